@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "common/alignment.h"
+#include "common/types.h"
+
+namespace Common {
+
+/**
+ * Bump allocator for short lived allocations that are all released at once. Memory is handed
+ * out from large chunks and individual deallocations are ignored, Reset rewinds the arena and
+ * keeps the chunks around for reuse. Not thread safe, meant to be owned by a single thread.
+ */
+class Arena final : public std::pmr::memory_resource {
+public:
+    explicit Arena(size_t chunk_size_ = 64_KB) : chunk_size{chunk_size_} {}
+
+    // Allocations point into the chunks and memory resources are compared by address.
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = delete;
+    Arena& operator=(Arena&&) = delete;
+
+    /// Releases every allocation. Everything allocated from the arena must be dead by then.
+    void Reset() {
+        if (chunks.size() > 1) {
+            // More than a chunk was needed, squash them so the next use stays in one.
+            const size_t total_size = ReservedBytes();
+            chunks.clear();
+            chunks.emplace_back(total_size);
+        }
+        if (!chunks.empty()) {
+            chunks.front().used = 0;
+        }
+        current = 0;
+        used_bytes = 0;
+    }
+
+    /// Returns the bytes handed out since the last reset.
+    [[nodiscard]] size_t UsedBytes() const noexcept {
+        return used_bytes;
+    }
+
+    /// Returns the bytes held by the arena.
+    [[nodiscard]] size_t ReservedBytes() const noexcept {
+        size_t total{};
+        for (const Chunk& chunk : chunks) {
+            total += chunk.size;
+        }
+        return total;
+    }
+
+private:
+    struct Chunk {
+        explicit Chunk(size_t size_)
+            : data{std::make_unique_for_overwrite<std::byte[]>(size_)}, size{size_} {}
+
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+        size_t used{};
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        for (; current < chunks.size(); ++current) {
+            if (void* const ptr = TryAllocate(chunks[current], bytes, alignment)) {
+                return ptr;
+            }
+        }
+        chunks.emplace_back(std::max(chunk_size, bytes + alignment));
+        return TryAllocate(chunks.back(), bytes, alignment);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    void* TryAllocate(Chunk& chunk, size_t bytes, size_t alignment) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data.get());
+        const size_t offset = AlignUp(base + chunk.used, alignment) - base;
+        if (offset + bytes > chunk.size) {
+            return nullptr;
+        }
+        chunk.used = offset + bytes;
+        used_bytes += bytes;
+        return chunk.data.get() + offset;
+    }
+
+    std::vector<Chunk> chunks;
+    size_t chunk_size;
+    size_t current{};
+    size_t used_bytes{};
+};
+
+} // namespace Common
@@ -1,6 +1,9 @@
 // SPDX-FileCopyrightText: Copyright 2021 yuzu Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <atomic>
+#include <stdexcept>
+
 #include "common/arch.h"
 #include "common/assert.h"
 #include "common/logging/backend.h"
@@ -13,13 +16,29 @@
 #error "Missing Crash() implementation for target CPU architecture."
 #endif
 
+namespace {
+std::atomic<AssertHandler> g_assert_handler{};
+
+void call_assert_handler() {
+    if (const auto handler = g_assert_handler.load(std::memory_order_acquire)) {
+        handler();
+    }
+}
+} // Anonymous namespace
+
+void set_assert_handler(AssertHandler handler) {
+    g_assert_handler.store(handler, std::memory_order_release);
+}
+
 void assert_fail_impl() {
+    call_assert_handler();
     Common::Log::Stop();
     std::fflush(stdout);
     Crash();
 }
 
 [[noreturn]] void unreachable_impl() {
+    call_assert_handler();
     Common::Log::Stop();
     std::fflush(stdout);
     Crash();
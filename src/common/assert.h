@@ -13,6 +13,11 @@
 void assert_fail_impl();
 [[noreturn]] void unreachable_impl();
 
+// Called on a failed assert or unreachable code before the process is stopped. Batch tools can
+// install a handler that throws to abandon only the work item that failed.
+using AssertHandler = void (*)();
+void set_assert_handler(AssertHandler handler);
+
 #ifdef _MSC_VER
 #define SHAD_NO_INLINE __declspec(noinline)
 #else
@@ -55,6 +55,11 @@ public:
         return t;
     }
 
+    bool Empty() const {
+        return m_read_index.load(std::memory_order::acquire) ==
+               m_write_index.load(std::memory_order::acquire);
+    }
+
 private:
     enum class PushMode {
         Try,
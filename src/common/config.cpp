@@ -45,11 +45,17 @@ static bool useSpecialPad = false;
 static std::string backButtonBehavior = "left";
 static int specialPadClass = 1;
 static bool isDebugDump = false;
+static bool isCpuPatchDisplace = false;
 static bool isShowSplash = false;
 static bool isAutoUpdate = false;
 static bool isNullGpu = false;
 static bool shouldCopyGPUBuffers = false;
 static bool shouldDumpShaders = false;
+static bool isHostMemoryImport = false;
+static bool shaderCacheEnabled = true;
+static u32 shaderCachePrecompileNumThreads = 0; // 0 disables precompilation at startup
+static bool isAsyncShaderCompile = false;
+static u32 shaderCompileNumThreads = 0; // 0 selects half of the host threads
 static u32 vblankDivider = 1;
 static bool vkValidation = false;
 static bool vkValidationSync = false;
@@ -140,6 +146,10 @@ bool debugDump() {
     return isDebugDump;
 }
 
+bool cpuPatchDisplace() {
+    return isCpuPatchDisplace;
+}
+
 bool showSplash() {
     return isShowSplash;
 }
@@ -160,6 +170,26 @@ bool dumpShaders() {
     return shouldDumpShaders;
 }
 
+bool hostMemoryImport() {
+    return isHostMemoryImport;
+}
+
+bool shaderCache() {
+    return shaderCacheEnabled;
+}
+
+u32 shaderCachePrecompileThreads() {
+    return shaderCachePrecompileNumThreads;
+}
+
+bool asyncShaderCompile() {
+    return isAsyncShaderCompile;
+}
+
+u32 shaderCompileThreads() {
+    return shaderCompileNumThreads;
+}
+
 bool isRdocEnabled() {
     return rdocEnable;
 }
@@ -228,6 +258,30 @@ void setDumpShaders(bool enable) {
     shouldDumpShaders = enable;
 }
 
+void setHostMemoryImport(bool enable) {
+    isHostMemoryImport = enable;
+}
+
+void setCpuPatchDisplace(bool enable) {
+    isCpuPatchDisplace = enable;
+}
+
+void setShaderCache(bool enable) {
+    shaderCacheEnabled = enable;
+}
+
+void setShaderCachePrecompileThreads(u32 num_threads) {
+    shaderCachePrecompileNumThreads = num_threads;
+}
+
+void setAsyncShaderCompile(bool enable) {
+    isAsyncShaderCompile = enable;
+}
+
+void setShaderCompileThreads(u32 num_threads) {
+    shaderCompileNumThreads = num_threads;
+}
+
 void setVkValidation(bool enable) {
     vkValidation = enable;
 }
@@ -462,6 +516,12 @@ void load(const std::filesystem::path& path) {
         isNullGpu = toml::find_or<bool>(gpu, "nullGpu", false);
         shouldCopyGPUBuffers = toml::find_or<bool>(gpu, "copyGPUBuffers", false);
         shouldDumpShaders = toml::find_or<bool>(gpu, "dumpShaders", false);
+        isHostMemoryImport = toml::find_or<bool>(gpu, "hostMemoryImport", false);
+        shaderCacheEnabled = toml::find_or<bool>(gpu, "shaderCache", true);
+        shaderCachePrecompileNumThreads =
+            toml::find_or<int>(gpu, "shaderCachePrecompileThreads", 0);
+        isAsyncShaderCompile = toml::find_or<bool>(gpu, "asyncShaderCompile", false);
+        shaderCompileNumThreads = toml::find_or<int>(gpu, "shaderCompileThreads", 0);
         vblankDivider = toml::find_or<int>(gpu, "vblankDivider", 1);
     }
 
@@ -481,6 +541,7 @@ void load(const std::filesystem::path& path) {
         const toml::value& debug = data.at("Debug");
 
         isDebugDump = toml::find_or<bool>(debug, "DebugDump", false);
+        isCpuPatchDisplace = toml::find_or<bool>(debug, "cpuPatchDisplace", false);
     }
 
     if (data.contains("GUI")) {
@@ -551,6 +612,11 @@ void save(const std::filesystem::path& path) {
     data["GPU"]["nullGpu"] = isNullGpu;
     data["GPU"]["copyGPUBuffers"] = shouldCopyGPUBuffers;
     data["GPU"]["dumpShaders"] = shouldDumpShaders;
+    data["GPU"]["hostMemoryImport"] = isHostMemoryImport;
+    data["GPU"]["shaderCache"] = shaderCacheEnabled;
+    data["GPU"]["shaderCachePrecompileThreads"] = shaderCachePrecompileNumThreads;
+    data["GPU"]["asyncShaderCompile"] = isAsyncShaderCompile;
+    data["GPU"]["shaderCompileThreads"] = shaderCompileNumThreads;
     data["GPU"]["vblankDivider"] = vblankDivider;
     data["Vulkan"]["gpuId"] = gpuId;
     data["Vulkan"]["validation"] = vkValidation;
@@ -560,6 +626,7 @@ void save(const std::filesystem::path& path) {
     data["Vulkan"]["rdocMarkersEnable"] = vkMarkers;
     data["Vulkan"]["crashDiagnostic"] = vkCrashDiagnostic;
     data["Debug"]["DebugDump"] = isDebugDump;
+    data["Debug"]["cpuPatchDisplace"] = isCpuPatchDisplace;
     data["GUI"]["theme"] = mw_themes;
     data["GUI"]["iconSize"] = m_icon_size;
     data["GUI"]["sliderPos"] = m_slider_pos;
@@ -606,10 +673,16 @@ void setDefaultValues() {
     useSpecialPad = false;
     specialPadClass = 1;
     isDebugDump = false;
+    isCpuPatchDisplace = false;
     isShowSplash = false;
     isAutoUpdate = false;
     isNullGpu = false;
     shouldDumpShaders = false;
+    isHostMemoryImport = false;
+    shaderCacheEnabled = true;
+    shaderCachePrecompileNumThreads = 0;
+    isAsyncShaderCompile = false;
+    shaderCompileNumThreads = 0;
     vblankDivider = 1;
     vkValidation = false;
     vkValidationSync = false;
@@ -30,11 +30,17 @@ u32 getScreenHeight();
 s32 getGpuId();
 
 bool debugDump();
+bool cpuPatchDisplace();
 bool showSplash();
 bool autoUpdate();
 bool nullGpu();
 bool copyGPUCmdBuffers();
 bool dumpShaders();
+bool hostMemoryImport();
+bool shaderCache();
+u32 shaderCachePrecompileThreads();
+bool asyncShaderCompile();
+u32 shaderCompileThreads();
 bool isRdocEnabled();
 u32 vblankDiv();
 
@@ -44,6 +50,12 @@ void setAutoUpdate(bool enable);
 void setNullGpu(bool enable);
 void setCopyGPUCmdBuffers(bool enable);
 void setDumpShaders(bool enable);
+void setHostMemoryImport(bool enable);
+void setCpuPatchDisplace(bool enable);
+void setShaderCache(bool enable);
+void setShaderCachePrecompileThreads(u32 num_threads);
+void setAsyncShaderCompile(bool enable);
+void setShaderCompileThreads(u32 num_threads);
 void setVblankDiv(u32 value);
 void setGpuId(s32 selectedGpuId);
 void setScreenWidth(u32 width);
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <vector>
+#include <boost/container/small_vector.hpp>
 
 #include "common/alignment.h"
 #include "common/assert.h"
@@ -17,6 +18,7 @@
 #include <share.h>
 #include <windows.h>
 #else
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
@@ -272,6 +274,10 @@ uintptr_t IOFile::GetFileMapping() {
 #endif
 }
 
+int IOFile::GetDescriptor() const {
+    return fileno(file);
+}
+
 std::string IOFile::ReadString(size_t length) const {
     std::vector<char> string_buffer(length);
 
@@ -409,6 +415,100 @@ s64 IOFile::Tell() const {
     return ftello(file);
 }
 
+s64 IOFile::ReadAt(void* data, size_t size, s64 offset) const {
+    if (!IsOpen()) {
+        return -1;
+    }
+#ifdef _WIN32
+    const s64 pos = Tell();
+    if (fseeko(file, offset, SEEK_SET) != 0) {
+        return -1;
+    }
+    const size_t read = std::fread(data, 1, size, file);
+    const bool failed = read < size && std::ferror(file);
+    std::clearerr(file);
+    fseeko(file, pos, SEEK_SET);
+    return failed && read == 0 ? -1 : static_cast<s64>(read);
+#else
+    const int fd = fileno(file);
+    size_t total_read = 0;
+    while (total_read < size) {
+        const ssize_t read =
+            pread(fd, static_cast<u8*>(data) + total_read, size - total_read, offset + total_read);
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read < 0) {
+            // Report the bytes already read, the error shows up again on the next call.
+            return total_read == 0 ? -1 : static_cast<s64>(total_read);
+        }
+        if (read == 0) {
+            break;
+        }
+        total_read += read;
+    }
+    return static_cast<s64>(total_read);
+#endif
+}
+
+s64 IOFile::ReadAtV(std::span<const std::span<u8>> buffers, s64 offset) const {
+    if (!IsOpen()) {
+        return -1;
+    }
+#ifdef _WIN32
+    s64 total_read = 0;
+    for (const std::span<u8> buffer : buffers) {
+        const s64 read = ReadAt(buffer.data(), buffer.size(), offset + total_read);
+        if (read < 0) {
+            return total_read == 0 ? -1 : total_read;
+        }
+        total_read += read;
+        if (static_cast<size_t>(read) != buffer.size()) {
+            break;
+        }
+    }
+    return total_read;
+#else
+    boost::container::small_vector<iovec, 8> iovs;
+    size_t total_size = 0;
+    for (const std::span<u8> buffer : buffers) {
+        iovs.push_back({buffer.data(), buffer.size()});
+        total_size += buffer.size();
+    }
+    const int fd = fileno(file);
+    ssize_t read;
+    do {
+        read = preadv(fd, iovs.data(), static_cast<int>(iovs.size()), offset);
+    } while (read < 0 && errno == EINTR);
+    if (read < 0) {
+        return -1;
+    }
+    if (static_cast<size_t>(read) < total_size && read != 0) {
+        // Short read, finish the remaining buffers one by one.
+        size_t skip = read;
+        s64 total_read = read;
+        for (const std::span<u8> buffer : buffers) {
+            if (skip >= buffer.size()) {
+                skip -= buffer.size();
+                continue;
+            }
+            const size_t wanted = buffer.size() - skip;
+            const s64 tail_read = ReadAt(buffer.data() + skip, wanted, offset + total_read);
+            if (tail_read < 0) {
+                break;
+            }
+            total_read += tail_read;
+            skip = 0;
+            if (static_cast<size_t>(tail_read) != wanted) {
+                break;
+            }
+        }
+        return total_read;
+    }
+    return read;
+#endif
+}
+
 u64 GetDirectorySize(const std::filesystem::path& path) {
     if (!fs::exists(path)) {
         return 0;
@@ -63,6 +63,13 @@ enum class SeekOrigin : u32 {
 
 class IOFile final {
 public:
+#ifdef _WIN32
+    /// Whether ReadAt leaves the stream position alone, allowing concurrent calls without locks.
+    static constexpr bool HasPositionalReads = false;
+#else
+    static constexpr bool HasPositionalReads = true;
+#endif
+
     IOFile();
 
     explicit IOFile(const std::string& path, FileAccessMode mode,
@@ -102,6 +109,9 @@ public:
 
     uintptr_t GetFileMapping();
 
+    /// Returns the file descriptor of the underlying stream.
+    int GetDescriptor() const;
+
     int Open(const std::filesystem::path& path, FileAccessMode mode,
              FileType type = FileType::BinaryFile,
              FileShareFlag flag = FileShareFlag::ShareReadOnly);
@@ -118,6 +128,18 @@ public:
     bool Seek(s64 offset, SeekOrigin origin = SeekOrigin::SetOrigin) const;
     s64 Tell() const;
 
+    /**
+     * Reads up to size bytes starting at offset and returns the number of bytes read, which is
+     * short only at the end of the file. Returns -1 when the file is not open or the host read
+     * fails before anything was read. Writes still buffered in the stream are not visible, flush
+     * them first. When HasPositionalReads is false this goes through the stream position and
+     * calls must be serialized.
+     */
+    s64 ReadAt(void* data, size_t size, s64 offset) const;
+
+    /// Vectored ReadAt, fills the buffers in order until the end of the file.
+    s64 ReadAtV(std::span<const std::span<u8>> buffers, s64 offset) const;
+
     template <typename T>
     size_t Read(T& data) const {
         if constexpr (IsContiguousContainer<T>) {
@@ -119,6 +119,8 @@ static auto UserPaths = [] {
     create_path(PathType::CheatsDir, user_dir / CHEATS_DIR);
     create_path(PathType::PatchesDir, user_dir / PATCHES_DIR);
     create_path(PathType::MetaDataDir, user_dir / METADATA_DIR);
+    create_path(PathType::PkgMountDir, user_dir / PKG_MOUNT_DIR);
+    create_path(PathType::CacheDir, user_dir / CACHE_DIR);
 
     return paths;
 }();
@@ -26,6 +26,8 @@ enum class PathType {
     CheatsDir,      // Where cheats are stored.
     PatchesDir,     // Where patches are stored.
     MetaDataDir,    // Where game metadata (e.g. trophies and menu backgrounds) is stored.
+    PkgMountDir,    // Where metadata and boot modules of mounted packages are stored.
+    CacheDir,       // Where caches derived from game executables are stored.
 };
 
 constexpr auto PORTABLE_DIR = "user";
@@ -43,6 +45,8 @@ constexpr auto CAPTURES_DIR = "captures";
 constexpr auto CHEATS_DIR = "cheats";
 constexpr auto PATCHES_DIR = "patches";
 constexpr auto METADATA_DIR = "game_data";
+constexpr auto PKG_MOUNT_DIR = "pkg_mount";
+constexpr auto CACHE_DIR = "cache";
 
 // Filenames
 constexpr auto LOG_FILE = "shad_log.txt";
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <iterator>
+#include "common/assert.h"
+#include "common/types.h"
+
+namespace Core::AreaMap {
+
+/**
+ * Operations on sorted maps from base address to areas that cover an address range without
+ * gaps. Areas provide base, size, CanMergeWith(next) and SplitOff(offset). The map may be any
+ * ordered map with emplace_hint, like std::map or boost::container::flat_map. For flat maps
+ * inserting or erasing an area invalidates iterators past it, the returned iterators stay valid.
+ */
+
+/// Returns the area containing addr.
+template <typename Map>
+typename Map::iterator Find(Map& map, u64 addr) {
+    return std::prev(map.upper_bound(addr));
+}
+
+/// Splits the area at offset and returns the area that starts there.
+template <typename Map>
+typename Map::iterator Split(Map& map, typename Map::iterator it, size_t offset) {
+    auto& old_area = it->second;
+    ASSERT(offset < old_area.size && offset > 0);
+    auto new_area = old_area.SplitOff(offset);
+    return map.emplace_hint(std::next(it), new_area.base, std::move(new_area));
+}
+
+/// Splits the area containing addr so that [addr, addr + size) is an area of its own.
+template <typename Map>
+typename Map::iterator Carve(Map& map, u64 addr, size_t size) {
+    auto it = Find(map, addr);
+    ASSERT_MSG(it != map.end(), "Address {:#x} is not in the map", addr);
+
+    const auto& area = it->second;
+    ASSERT_MSG(area.base <= addr, "Adding an area to already covered range");
+
+    const u64 start_in_area = addr - area.base;
+    const u64 end_in_area = start_in_area + size;
+    const size_t area_size = area.size;
+    ASSERT_MSG(end_in_area <= area_size, "Area cannot fit inside region: size = {:#x}", size);
+
+    if (start_in_area != 0) {
+        // Split the area at the start of the carved range.
+        it = Split(map, it, start_in_area);
+    }
+    if (end_in_area != area_size) {
+        // Split the area at the end of the carved range. The insertion may move the carved
+        // area, so take it back from the iterator of the new one that follows it.
+        it = std::prev(Split(map, it, size));
+    }
+    return it;
+}
+
+/// Merges the area with its neighbours where possible and returns the resulting area.
+template <typename Map>
+typename Map::iterator MergeAdjacent(Map& map, typename Map::iterator it) {
+    const auto next = std::next(it);
+    if (next != map.end() && it->second.CanMergeWith(next->second)) {
+        it->second.size += next->second.size;
+        map.erase(next);
+    }
+
+    if (it != map.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second.CanMergeWith(it->second)) {
+            prev->second.size += it->second.size;
+            map.erase(it);
+            it = prev;
+        }
+    }
+    return it;
+}
+
+} // namespace Core::AreaMap
@@ -1,18 +1,29 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <set>
+#include <thread>
 #include <Zydis/Zydis.h>
+#include <tsl/robin_set.h>
 #include <xbyak/xbyak.h>
 #include <xbyak/xbyak_util.h>
+#include <xxhash.h>
 #include "common/alignment.h"
 #include "common/arch.h"
 #include "common/assert.h"
+#include "common/config.h"
 #include "common/decoder.h"
+#include "common/div_ceil.h"
+#include "common/io_file.h"
+#include "common/path_util.h"
+#include "common/scm_rev.h"
 #include "common/signal_context.h"
+#include "common/thread_worker.h"
 #include "common/types.h"
 #include "core/signals.h"
 #include "core/tls.h"
@@ -918,7 +929,7 @@ struct PatchModule {
     u8* end;
 
     /// Tracker for patched code locations.
-    std::set<u8*> patched;
+    tsl::robin_set<u8*> patched;
 
     /// Code generator for patching the module.
     Xbyak::CodeGenerator patch_gen;
@@ -941,9 +952,54 @@ static PatchModule* GetModule(const void* ptr) {
     return &(std::prev(upper_bound)->second);
 }
 
+/// Size of the near jump that replaces a trampolined instruction.
+static constexpr u64 NearJumpSize = 5;
+
+/// Returns the size of the whole instructions following a short instruction at code that have to
+/// move to its trampoline to make room for a near jump, or 0 when they cannot be moved.
+/// No direct branch in the segment may target the first reloc_limit bytes past code, except code
+/// itself. This is a heuristic: jump tables, exception landing pads and other modules can still
+/// enter the moved bytes, which is why it is only used when enabled in the config.
+static u64 GetDisplacedSize(const u8* code, u64 length, u64 reloc_limit, PatchModule* module) {
+    u64 displaced = 0;
+    while (length + displaced < NearJumpSize) {
+        auto* next = const_cast<u8*>(code + length + displaced);
+        ZydisDecodedInstruction instruction;
+        ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT];
+        const auto status = Common::Decoder::Instance()->decodeInstruction(
+            instruction, operands, next, module->end - next);
+        if (!ZYAN_SUCCESS(status)) {
+            return 0;
+        }
+        // Position dependent code and control flow would behave differently in the trampoline.
+        if (instruction.attributes & ZYDIS_ATTRIB_IS_RELATIVE) {
+            return 0;
+        }
+        switch (instruction.meta.category) {
+        case ZYDIS_CATEGORY_COND_BR:
+        case ZYDIS_CATEGORY_UNCOND_BR:
+        case ZYDIS_CATEGORY_CALL:
+        case ZYDIS_CATEGORY_RET:
+        case ZYDIS_CATEGORY_SYSCALL:
+        case ZYDIS_CATEGORY_INTERRUPT:
+            return 0;
+        default:
+            break;
+        }
+        // Instructions that need patching themselves cannot be copied as they are.
+        if (const auto it = Patches.find(instruction.mnemonic);
+            it != Patches.end() && it->second.filter(operands)) {
+            return 0;
+        }
+        displaced += instruction.length;
+    }
+    return length + displaced <= reloc_limit ? displaced : 0;
+}
+
 /// Returns a boolean indicating whether the instruction was patched, and the offset to advance past
-/// whatever is at the current code pointer.
-static std::pair<bool, u64> TryPatch(u8* code, PatchModule* module) {
+/// whatever is at the current code pointer. A non-zero reloc_limit allows instructions too short
+/// for a trampoline jump to be patched by moving the following ones, see GetDisplacedSize.
+static std::pair<bool, u64> TryPatch(u8* code, PatchModule* module, u64 reloc_limit = 0) {
     ZydisDecodedInstruction instruction;
     ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT];
     const auto status = Common::Decoder::Instance()->decodeInstruction(instruction, operands, code,
@@ -958,13 +1014,18 @@ static std::pair<bool, u64> TryPatch(u8* code, PatchModule* module) {
         if (patch_info.filter(operands)) {
             auto& patch_gen = module->patch_gen;
 
-            if (needs_trampoline && instruction.length < 5) {
-                // Trampoline is needed but instruction is too short to patch.
-                // Return false and length to fall back to the illegal instruction handler,
-                // or to signal to AOT compilation that this instruction should be skipped and
-                // handled at runtime.
-                return std::make_pair(false, instruction.length);
+            u64 displaced = 0;
+            if (needs_trampoline && instruction.length < NearJumpSize) {
+                displaced = GetDisplacedSize(code, instruction.length, reloc_limit, module);
+                if (displaced == 0) {
+                    // Trampoline is needed but instruction is too short to patch.
+                    // Return false and length to fall back to the illegal instruction handler,
+                    // or to signal to AOT compilation that this instruction should be skipped
+                    // and handled at runtime.
+                    return std::make_pair(false, instruction.length);
+                }
             }
+            const u64 replaced_size = instruction.length + displaced;
 
             // Reset state and move to current code position.
             patch_gen.reset();
@@ -976,8 +1037,13 @@ static std::pair<bool, u64> TryPatch(u8* code, PatchModule* module) {
 
                 patch_info.generator(operands, trampoline_gen);
 
+                // Execute the instructions that make room for the jump from the trampoline.
+                for (u64 i = 0; i < displaced; i++) {
+                    trampoline_gen.db(code[instruction.length + i]);
+                }
+
                 // Return to the following instruction at the end of the trampoline.
-                trampoline_gen.jmp(code + instruction.length);
+                trampoline_gen.jmp(code + replaced_size);
 
                 // Replace instruction with near jump to the trampoline.
                 patch_gen.jmp(trampoline_ptr, Xbyak::CodeGenerator::LabelType::T_NEAR);
@@ -987,18 +1053,18 @@ static std::pair<bool, u64> TryPatch(u8* code, PatchModule* module) {
 
             const auto patch_size = patch_gen.getCurr() - code;
             if (patch_size > 0) {
-                ASSERT_MSG(instruction.length >= patch_size,
+                ASSERT_MSG(replaced_size >= patch_size,
                            "Instruction {} with length {} is too short to replace at: {}",
-                           ZydisMnemonicGetString(instruction.mnemonic), instruction.length,
+                           ZydisMnemonicGetString(instruction.mnemonic), replaced_size,
                            fmt::ptr(code));
 
                 // Fill remaining space with nops.
-                patch_gen.nop(instruction.length - patch_size);
+                patch_gen.nop(replaced_size - patch_size);
 
                 module->patched.insert(code);
                 LOG_DEBUG(Core, "Patched instruction '{}' at: {}",
                           ZydisMnemonicGetString(instruction.mnemonic), fmt::ptr(code));
-                return std::make_pair(true, instruction.length);
+                return std::make_pair(true, replaced_size);
             }
         }
     }
@@ -1163,13 +1229,183 @@ static bool TryPatchJit(void* code_address) {
     std::unique_lock lock{module->mutex};
 
     // Return early if already patched, in case multiple threads signaled at the same time.
-    if (std::ranges::find(module->patched, code) != module->patched.end()) {
+    if (module->patched.contains(code)) {
         return true;
     }
 
     return TryPatch(code, module).first;
 }
 
+/// Bump whenever the scan results or the patch table change meaning.
+static constexpr u32 PatchCacheVersion = 1;
+static constexpr u32 PatchCacheMagic = 0x48435450; // PTCH
+
+/// Segments are only scanned in parallel when every thread gets at least this much code.
+static constexpr u64 MinScanChunkSize = 256_KB;
+
+struct PatchCacheHeader {
+    u32 magic;
+    u32 version;
+    u64 scm_rev_hash;
+    u64 code_size;
+    u32 host_features;
+    u32 num_sites;
+};
+
+/// Location of an instruction that passed its patch filter.
+struct PatchSite {
+    /// Offset from the start of the segment.
+    u32 offset;
+    /// Number of bytes past the site that no direct branch in the segment targets.
+    u32 reloc_limit;
+};
+
+/// Results of decoding a range of a segment.
+struct ScanChunk {
+    u64 begin;
+    u64 end;
+    /// Offset past the last decoded instruction, may lie past the end of the range.
+    u64 last_end;
+    std::vector<PatchSite> sites;
+    /// Pairs of the source and target offsets of direct branches.
+    std::vector<std::pair<u32, u32>> branches;
+};
+
+/// Returns the host properties that the patch filters depend on.
+static u32 GetHostPatchFeatures() {
+    Cpu cpu;
+    return cpu.has(Cpu::tSSE4a) ? 1U : 0U;
+}
+
+/// Decodes the instruction at offset, records it in the chunk and returns its length.
+static u64 ScanInstruction(const u8* code, u64 code_size, u64 offset, PatchModule* module,
+                           ScanChunk& chunk, std::vector<u64>& starts) {
+    auto* inst_code = const_cast<u8*>(code + offset);
+    ZydisDecodedInstruction instruction;
+    ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT];
+    const auto status = Common::Decoder::Instance()->decodeInstruction(
+        instruction, operands, inst_code, module->end - inst_code);
+    starts[offset / 64] |= 1ULL << (offset % 64);
+    if (!ZYAN_SUCCESS(status)) {
+        return 1;
+    }
+    if (const auto it = Patches.find(instruction.mnemonic);
+        it != Patches.end() && it->second.filter(operands)) {
+        chunk.sites.push_back({static_cast<u32>(offset), 0});
+    }
+    const auto& target = operands[0];
+    if ((instruction.attributes & ZYDIS_ATTRIB_IS_RELATIVE) &&
+        target.type == ZYDIS_OPERAND_TYPE_IMMEDIATE && target.imm.is_relative) {
+        ZyanU64 address;
+        if (ZYAN_SUCCESS(ZydisCalcAbsoluteAddress(&instruction, &target, offset, &address)) &&
+            address < code_size) {
+            chunk.branches.emplace_back(static_cast<u32>(offset), static_cast<u32>(address));
+        }
+    }
+    return instruction.length;
+}
+
+/// Finds the patch sites of a code segment. The segment is split in chunks that are decoded
+/// concurrently, each from its own start. As linear decoding resynchronizes within a few
+/// instructions, the end of every chunk is then decoded serially until it meets an instruction
+/// boundary of the next chunk, which yields the same result as a serial scan.
+static std::vector<PatchSite> ScanPatchSites(const u8* code, u64 code_size, PatchModule* module) {
+    const u64 max_chunks = std::max(code_size / MinScanChunkSize, u64{1});
+    const u64 num_chunks = std::min<u64>(std::max(std::thread::hardware_concurrency(), 1U),
+                                         max_chunks);
+    // Keep chunks aligned to the bitmap words so that threads never write to the same word.
+    const u64 chunk_size = Common::AlignUp(Common::DivCeil(code_size, num_chunks), 64);
+
+    std::vector<u64> starts(Common::DivCeil(code_size, u64{64}));
+    std::vector<ScanChunk> chunks;
+    for (u64 begin = 0; begin < code_size; begin += chunk_size) {
+        chunks.push_back({.begin = begin, .end = std::min(begin + chunk_size, code_size)});
+    }
+    const auto scan_chunk = [&](ScanChunk& chunk) {
+        u64 offset = chunk.begin;
+        while (offset < chunk.end) {
+            offset += ScanInstruction(code, code_size, offset, module, chunk, starts);
+        }
+        chunk.last_end = offset;
+    };
+    if (chunks.size() == 1) {
+        scan_chunk(chunks[0]);
+    } else {
+        Common::ThreadWorker workers{chunks.size(), "shadPS4:PatchScan"};
+        for (auto& chunk : chunks) {
+            workers.QueueWork([&scan_chunk, &chunk] { scan_chunk(chunk); });
+        }
+        workers.WaitForRequests();
+    }
+
+    for (size_t i = 1; i < chunks.size(); i++) {
+        auto& chunk = chunks[i];
+        ScanChunk prefix{};
+        u64 offset = chunks[i - 1].last_end;
+        while (offset < chunk.end && !((starts[offset / 64] >> (offset % 64)) & 1)) {
+            offset += ScanInstruction(code, code_size, offset, module, prefix, starts);
+        }
+        // Everything decoded before the synchronization point started mid-instruction.
+        std::erase_if(chunk.sites, [offset](const auto& site) { return site.offset < offset; });
+        std::erase_if(chunk.branches, [offset](const auto& b) { return b.first < offset; });
+        chunk.sites.insert(chunk.sites.begin(), prefix.sites.begin(), prefix.sites.end());
+        chunk.branches.insert(chunk.branches.end(), prefix.branches.begin(),
+                              prefix.branches.end());
+        if (offset >= chunk.end) {
+            chunk.last_end = offset;
+        }
+    }
+
+    std::vector<u32> targets;
+    std::vector<PatchSite> sites;
+    for (const auto& chunk : chunks) {
+        for (const auto& branch : chunk.branches) {
+            targets.push_back(branch.second);
+        }
+        sites.insert(sites.end(), chunk.sites.begin(), chunk.sites.end());
+    }
+    std::ranges::sort(targets);
+    for (auto& site : sites) {
+        const auto it = std::ranges::upper_bound(targets, site.offset);
+        site.reloc_limit = it != targets.end() ? *it - site.offset : 0xFFFFFFFF;
+    }
+    return sites;
+}
+
+static bool LoadPatchSites(const std::filesystem::path& path, const PatchCacheHeader& expected,
+                           std::vector<PatchSite>& sites) {
+    using namespace Common::FS;
+    if (!std::filesystem::exists(path)) {
+        return false;
+    }
+    IOFile file{path, FileAccessMode::Read};
+    PatchCacheHeader header{};
+    if (!file.ReadObject(header) || header.magic != expected.magic ||
+        header.version != expected.version || header.scm_rev_hash != expected.scm_rev_hash ||
+        header.code_size != expected.code_size ||
+        header.host_features != expected.host_features ||
+        file.GetSize() != sizeof(header) + u64{header.num_sites} * sizeof(PatchSite)) {
+        return false;
+    }
+    sites.resize(header.num_sites);
+    return file.ReadSpan(std::span{sites}) == sites.size();
+}
+
+static void StorePatchSites(const std::filesystem::path& path, PatchCacheHeader header,
+                            std::span<const PatchSite> sites) {
+    using namespace Common::FS;
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    IOFile file{path, FileAccessMode::Write};
+    if (!file.IsOpen()) {
+        LOG_WARNING(Core, "Failed to open patch cache {}", fmt::UTF(path.u8string()));
+        return;
+    }
+    header.num_sites = static_cast<u32>(sites.size());
+    file.WriteObject(header);
+    file.WriteSpan(sites);
+}
+
 static void TryPatchAot(void* code_address, u64 code_size) {
     auto* code = static_cast<u8*>(code_address);
     auto* module = GetModule(code);
@@ -1177,12 +1413,39 @@ static void TryPatchAot(void* code_address, u64 code_size) {
         return;
     }
 
+    // Scan results only depend on the segment contents, key them by their hash so that modules
+    // shared between titles also share their cache entry.
+    const auto start = std::chrono::steady_clock::now();
+    const u64 code_hash = XXH3_64bits(code, code_size);
+    const auto cache_path = Common::FS::GetUserPath(Common::FS::PathType::CacheDir) /
+                            "cpu_patches" / fmt::format("{:016x}.bin", code_hash);
+    const PatchCacheHeader header = {
+        .magic = PatchCacheMagic,
+        .version = PatchCacheVersion,
+        .scm_rev_hash = XXH3_64bits(Common::g_scm_rev, std::strlen(Common::g_scm_rev)),
+        .code_size = code_size,
+        .host_features = GetHostPatchFeatures(),
+        .num_sites = 0,
+    };
+    std::vector<PatchSite> sites;
+    const bool cached = LoadPatchSites(cache_path, header, sites);
+    if (!cached) {
+        sites = ScanPatchSites(code, code_size, module);
+        StorePatchSites(cache_path, header, sites);
+    }
+
     std::unique_lock lock{module->mutex};
 
-    const auto* end = code + code_size;
-    while (code < end) {
-        code += TryPatch(code, module).second;
+    const bool displace = Config::cpuPatchDisplace();
+    u32 num_patched = 0;
+    for (const auto& site : sites) {
+        num_patched += TryPatch(code + site.offset, module, displace ? site.reloc_limit : 0).first;
     }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    LOG_INFO(Core, "Patched {} of {} instructions at {} in {} ms ({})", num_patched,
+             sites.size(), fmt::ptr(code), elapsed.count(), cached ? "cached" : "scanned");
 }
 
 static bool PatchesAccessViolationHandler(void* context, void* /* fault_address */) {
@@ -1,7 +1,10 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <algorithm>
 #include <array>
+#include "common/div_ceil.h"
+#include "common/thread_worker.h"
 #include "crypto.h"
 
 CryptoPP::RSA::PrivateKey Crypto::key_pkg_derived_key3_keyset_init() {
@@ -185,30 +188,77 @@ void Crypto::PfsGenCryptoKey(std::span<const CryptoPP::byte, 32> ekpfs,
               data_tweak_key.begin() + tweakKey.size() + dataKey.size(), dataKey.begin());
 }
 
-void Crypto::decryptPFS(std::span<const CryptoPP::byte, 16> dataKey,
-                        std::span<const CryptoPP::byte, 16> tweakKey, std::span<const u8> src_image,
-                        std::span<CryptoPP::byte> dst_image, u64 sector) {
-    // Start at 0x10000 to keep the header when decrypting the whole pfs_image.
-    for (int i = 0; i < src_image.size(); i += 0x1000) {
-        const u64 current_sector = sector + (i / 0x1000);
-        CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption encrypt(tweakKey.data(), tweakKey.size());
-        CryptoPP::ECB_Mode<CryptoPP::AES>::Decryption decrypt(dataKey.data(), dataKey.size());
-
-        std::array<CryptoPP::byte, 16> tweak{};
-        std::array<CryptoPP::byte, 16> encryptedTweak;
-        std::array<CryptoPP::byte, 16> xorBuffer;
+Crypto::PfsDecryptor::PfsDecryptor(std::span<const CryptoPP::byte, 16> dataKey,
+                                   std::span<const CryptoPP::byte, 16> tweakKey)
+    : tweak_cipher{tweakKey.data(), tweakKey.size()}, data_cipher{dataKey.data(),
+                                                                  dataKey.size()} {}
+
+void Crypto::PfsDecryptor::Decrypt(std::span<const u8> src_image,
+                                   std::span<CryptoPP::byte> dst_image, u64 sector) {
+    constexpr size_t BlockSize = CryptoPP::AES::BLOCKSIZE;
+    constexpr auto flags = CryptoPP::BlockTransformation::BT_XorInput |
+                           CryptoPP::BlockTransformation::BT_AllowParallel;
+
+    const size_t size = std::min(src_image.size(), dst_image.size()) & ~(PfsSectorSize - 1);
+    for (size_t i = 0; i < size; i += PfsSectorSize) {
+        const u64 current_sector = sector + (i / PfsSectorSize);
+        std::array<CryptoPP::byte, BlockSize> tweak{};
         std::memcpy(tweak.data(), &current_sector, sizeof(u64));
+        tweak_cipher.ProcessBlock(tweak.data(), tweaks.data());
+
+        // Derive the tweaks of every block in the sector up front. Multiplication by x in
+        // GF(2^128) is a 128-bit little endian shift with the carry folded back as 0x87.
+        u64 lo, hi;
+        std::memcpy(&lo, tweaks.data(), sizeof(u64));
+        std::memcpy(&hi, tweaks.data() + sizeof(u64), sizeof(u64));
+        for (size_t offset = BlockSize; offset < PfsSectorSize; offset += BlockSize) {
+            const u64 carry = hi >> 63;
+            hi = (hi << 1) | (lo >> 63);
+            lo = (lo << 1) ^ (carry * 0x87);
+            std::memcpy(tweaks.data() + offset, &lo, sizeof(u64));
+            std::memcpy(tweaks.data() + offset + sizeof(u64), &hi, sizeof(u64));
+        }
 
-        // Encrypt the tweak for each sector.
-        encrypt.ProcessData(encryptedTweak.data(), tweak.data(), 16);
-
-        for (int plaintextOffset = 0; plaintextOffset < 0x1000; plaintextOffset += 16) {
-            xtsXorBlock(xorBuffer.data(), src_image.data() + i + plaintextOffset,
-                        encryptedTweak.data());                          // x, c, t
-            decrypt.ProcessData(xorBuffer.data(), xorBuffer.data(), 16); // x, x
-            xtsXorBlock(dst_image.data() + i + plaintextOffset, xorBuffer.data(),
-                        encryptedTweak.data()); //(p)  c, x , t
-            xtsMult(encryptedTweak);
+        // p = D(c ^ t) ^ t. The input xor is fused into the batched decryption.
+        CryptoPP::byte* dst = dst_image.data() + i;
+        data_cipher.AdvancedProcessBlocks(src_image.data() + i, tweaks.data(), dst,
+                                          PfsSectorSize, flags);
+        for (size_t offset = 0; offset < PfsSectorSize; offset += sizeof(u64)) {
+            u64 block, mask;
+            std::memcpy(&block, dst + offset, sizeof(u64));
+            std::memcpy(&mask, tweaks.data() + offset, sizeof(u64));
+            block ^= mask;
+            std::memcpy(dst + offset, &block, sizeof(u64));
         }
     }
 }
+
+void Crypto::decryptPFS(std::span<const CryptoPP::byte, 16> dataKey,
+                        std::span<const CryptoPP::byte, 16> tweakKey, std::span<const u8> src_image,
+                        std::span<CryptoPP::byte> dst_image, u64 sector, u32 num_threads) {
+    // Keep small images on the calling thread, spawning workers would cost more than it saves.
+    constexpr size_t MinSectorsPerThread = 256;
+    const size_t num_sectors = src_image.size() / PfsSectorSize;
+    num_threads =
+        static_cast<u32>(std::min<size_t>(num_threads, num_sectors / MinSectorsPerThread));
+    if (num_threads <= 1) {
+        PfsDecryptor decryptor{dataKey, tweakKey};
+        decryptor.Decrypt(src_image, dst_image, sector);
+        return;
+    }
+
+    // Sectors are independent, so split the image in contiguous ranges with their own schedules.
+    const size_t sectors_per_thread = Common::DivCeil(num_sectors, size_t{num_threads});
+    Common::ThreadWorker workers{num_threads, "shadPS4:PfsDecrypt"};
+    for (size_t first = 0; first < num_sectors; first += sectors_per_thread) {
+        const size_t count = std::min(sectors_per_thread, num_sectors - first);
+        const size_t offset = first * PfsSectorSize;
+        const size_t length = count * PfsSectorSize;
+        workers.QueueWork([=] {
+            PfsDecryptor decryptor{dataKey, tweakKey};
+            decryptor.Decrypt(src_image.subspan(offset, length), dst_image.subspan(offset, length),
+                              sector + first);
+        });
+    }
+    workers.WaitForRequests();
+}
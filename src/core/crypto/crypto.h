@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <array>
 #include <span>
 #include <cryptopp/aes.h>
 #include <cryptopp/filters.h>
@@ -17,6 +18,28 @@
 
 class Crypto {
 public:
+    static constexpr size_t PfsSectorSize = 0x1000;
+
+    /**
+     * AES-XTS decryptor for PFS images. The key schedules are expanded once on construction and
+     * every sector is processed as a single batch of blocks, so the cipher can pipeline them.
+     * An instance must not be shared between threads.
+     */
+    class PfsDecryptor {
+    public:
+        explicit PfsDecryptor(std::span<const CryptoPP::byte, 16> dataKey,
+                              std::span<const CryptoPP::byte, 16> tweakKey);
+
+        /// Decrypts the whole sectors of src_image starting at the provided sector index.
+        void Decrypt(std::span<const u8> src_image, std::span<CryptoPP::byte> dst_image,
+                     u64 sector);
+
+    private:
+        CryptoPP::AES::Encryption tweak_cipher;
+        CryptoPP::AES::Decryption data_cipher;
+        alignas(16) std::array<CryptoPP::byte, PfsSectorSize> tweaks;
+    };
+
     CryptoPP::RSA::PrivateKey key_pkg_derived_key3_keyset_init();
     CryptoPP::RSA::PrivateKey FakeKeyset_keyset_init();
     CryptoPP::RSA::PrivateKey DebugRifKeyset_init();
@@ -40,7 +63,7 @@ public:
                          std::span<CryptoPP::byte, 16> tweakKey);
     void decryptPFS(std::span<const CryptoPP::byte, 16> dataKey,
                     std::span<const CryptoPP::byte, 16> tweakKey, std::span<const u8> src_image,
-                    std::span<CryptoPP::byte> dst_image, u64 sector);
+                    std::span<CryptoPP::byte> dst_image, u64 sector, u32 num_threads = 1);
 
     void xtsXorBlock(CryptoPP::byte* x, const CryptoPP::byte* a, const CryptoPP::byte* b) {
         for (int i = 0; i < 16; i++) {
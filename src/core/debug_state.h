@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <mutex>
 #include <vector>
@@ -48,6 +49,18 @@ struct FrameDump {
     std::vector<QueueDump> queues;
 };
 
+struct GpuQueueStats {
+    std::atomic<u32> depth;       ///< Submissions queued or being processed
+    std::atomic<u64> num_submits; ///< Submissions started by the command processor
+    std::atomic<u64> wait_ns;     ///< Total time submissions spent queued before starting
+    std::atomic<u64> max_wait_ns; ///< Longest time a submission spent queued
+};
+
+struct DescriptorStats {
+    std::atomic<u64> writes;  ///< Descriptors written for draws
+    std::atomic<u64> skipped; ///< Descriptors left bound from the previous draw
+};
+
 class DebugStateImpl {
     friend class Core::Devtools::Layer;
     friend class Core::Devtools::Widget::FrameGraph;
@@ -69,6 +82,14 @@ class DebugStateImpl {
 
     std::queue<std::string> debug_message_popup;
 
+public:
+    static constexpr size_t MaxGpuQueues = 64;
+
+private:
+    std::array<GpuQueueStats, MaxGpuQueues> gpu_queue_stats{};
+    DescriptorStats descriptor_stats{};      ///< Of the frame being rendered
+    DescriptorStats last_descriptor_stats{}; ///< Of the last presented frame
+
 public:
     void AddCurrentThreadToGuestList();
 
@@ -84,6 +105,12 @@ public:
 
     void IncFlipFrameNum() {
         ++flip_frame_count;
+        last_descriptor_stats.writes.store(
+            descriptor_stats.writes.exchange(0, std::memory_order::relaxed),
+            std::memory_order::relaxed);
+        last_descriptor_stats.skipped.store(
+            descriptor_stats.skipped.exchange(0, std::memory_order::relaxed),
+            std::memory_order::relaxed);
     }
 
     void IncGnmFrameNum() {
@@ -114,6 +141,31 @@ public:
         GetFrameDump().queues.push_back(std::move(dump));
     }
 
+    void OnGpuSubmit(u32 queue) {
+        gpu_queue_stats[queue].depth.fetch_add(1, std::memory_order::relaxed);
+    }
+
+    void OnGpuSubmitStart(u32 queue, u64 wait_ns) {
+        auto& stats = gpu_queue_stats[queue];
+        stats.num_submits.fetch_add(1, std::memory_order::relaxed);
+        stats.wait_ns.fetch_add(wait_ns, std::memory_order::relaxed);
+        if (wait_ns > stats.max_wait_ns.load(std::memory_order::relaxed)) {
+            stats.max_wait_ns.store(wait_ns, std::memory_order::relaxed);
+        }
+    }
+
+    void OnGpuSubmitDone(u32 queue) {
+        gpu_queue_stats[queue].depth.fetch_sub(1, std::memory_order::relaxed);
+    }
+
+    void OnDescriptorWrites(size_t count) {
+        descriptor_stats.writes.fetch_add(count, std::memory_order::relaxed);
+    }
+
+    void OnDescriptorWritesSkipped(size_t count) {
+        descriptor_stats.skipped.fetch_add(count, std::memory_order::relaxed);
+    }
+
     void ShowDebugMessage(std::string message) {
         if (message.empty()) {
             return;
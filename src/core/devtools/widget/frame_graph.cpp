@@ -92,6 +92,25 @@ void FrameGraph::Draw() {
             }
         }
         draw_list.PopClipRect();
+
+        const auto& descriptor_stats = DebugState.last_descriptor_stats;
+        Text("Descriptor writes: %llu (%llu skipped)",
+             static_cast<unsigned long long>(descriptor_stats.writes.load()),
+             static_cast<unsigned long long>(descriptor_stats.skipped.load()));
+
+        SeparatorText("GPU queues");
+        for (u32 i = 0; i < DebugState.MaxGpuQueues; ++i) {
+            const auto& stats = DebugState.gpu_queue_stats[i];
+            const u64 num_submits = stats.num_submits.load(std::memory_order::relaxed);
+            if (num_submits == 0) {
+                continue;
+            }
+            const double avg_wait_us =
+                stats.wait_ns.load(std::memory_order::relaxed) / 1000.0 / num_submits;
+            const double max_wait_us = stats.max_wait_ns.load(std::memory_order::relaxed) / 1000.0;
+            Text("%s %u: depth %u, wait avg %.1f us max %.1f us", i == 0 ? "GFX" : "ASC", i,
+                 stats.depth.load(std::memory_order::relaxed), avg_wait_us, max_wait_us);
+        }
     }
     End();
 }
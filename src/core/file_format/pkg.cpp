@@ -1,13 +1,24 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
 #include <zlib-ng.h>
+#include "common/alignment.h"
 #include "common/io_file.h"
+#include "common/logging/log.h"
+#include "common/polyfill_thread.h"
+#include "common/thread.h"
 #include "core/file_format/pkg.h"
 #include "core/file_format/pkg_type.h"
 
-static void DecompressPFSC(std::span<const char> compressed_data,
-                           std::span<char> decompressed_data) {
+void DecompressPFSC(std::span<const char> compressed_data, std::span<char> decompressed_data) {
     zng_stream decompressStream;
     decompressStream.zalloc = Z_NULL;
     decompressStream.zfree = Z_NULL;
@@ -271,7 +282,8 @@ bool PKG::Extract(const std::filesystem::path& filepath, const std::filesystem::
         file.Close();
         // Decrypt the pfs_image.
         std::vector<u8> pfs_decrypted(length);
-        PKG::crypto.decryptPFS(dataKey, tweakKey, pfs_encrypted, pfs_decrypted, 0);
+        PKG::crypto.decryptPFS(dataKey, tweakKey, pfs_encrypted, pfs_decrypted, 0,
+                               std::thread::hardware_concurrency());
 
         // Retrieve PFSC from decrypted pfs_image.
         pfsc_offset = GetPFSCOffset(pfs_decrypted);
@@ -407,66 +419,242 @@ bool PKG::Extract(const std::filesystem::path& filepath, const std::filesystem::
     return true;
 }
 
-void PKG::ExtractFiles(const int index) {
-    int inode_number = fsTable[index].inode;
-    int inode_type = fsTable[index].type;
-    std::string inode_name = fsTable[index].name;
-
-    if (inode_type == PFS_FILE) {
-        int sector_loc = iNodeBuf[inode_number].loc;
-        int nblocks = iNodeBuf[inode_number].Blocks;
-        int bsize = iNodeBuf[inode_number].Size;
-
-        Common::FS::IOFile inflated;
-        inflated.Open(extractPaths[inode_number], Common::FS::FileAccessMode::Write);
-
-        Common::FS::IOFile pkgFile; // Open the file for each iteration to avoid conflict.
-        pkgFile.Open(pkgpath, Common::FS::FileAccessMode::Read);
-
-        int size_decompressed = 0;
-        std::vector<char> compressedData;
-        std::vector<char> decompressedData(0x10000);
-
-        u64 pfsc_buf_size = 0x11000; // extra 0x1000
-        std::vector<u8> pfsc(pfsc_buf_size);
-        std::vector<u8> pfs_decrypted(pfsc_buf_size);
+namespace {
+
+constexpr u64 PfscBlockSize = 0x10000;
+constexpr u32 MaxChunkBlocks = 16;
+constexpr u64 MaxChunkInput = MaxChunkBlocks * PfscBlockSize + 2 * Crypto::PfsSectorSize;
+constexpr u64 MaxChunkOutput = MaxChunkBlocks * PfscBlockSize;
+
+/// A run of consecutive PFSC blocks of one file travelling through the extraction pipeline.
+struct ExtractChunk {
+    u64 sequence;
+    u32 inode;
+    u32 first_block;
+    u32 num_blocks;
+    u64 first_sector;
+    u64 read_size;
+    u64 data_offset;
+    std::vector<u8> input;
+    std::vector<char> output;
+};
+
+/// Hands chunks from one stage to the next. It needs no capacity of its own, the number of
+/// chunks in flight is already bounded by the chunk pool.
+class StageQueue {
+public:
+    void Push(ExtractChunk* chunk) {
+        {
+            std::scoped_lock lock{mutex};
+            queue.push(chunk);
+        }
+        cv.notify_one();
+    }
 
-        for (int j = 0; j < nblocks; j++) {
-            u64 sectorOffset =
-                sectorMap[sector_loc + j]; // offset into PFSC_image and not pfs_image.
-            u64 sectorSize = sectorMap[sector_loc + j + 1] -
-                             sectorOffset; // indicates if data is compressed or not.
-            u64 fileOffset = (pkgheader.pfs_image_offset + pfsc_offset + sectorOffset);
-            u64 currentSector1 =
-                (pfsc_offset + sectorOffset) / 0x1000; // block size is 0x1000 for xts decryption.
+    /// Returns nullptr once the queue is closed and drained.
+    ExtractChunk* Pop() {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this] { return !queue.empty() || closed; });
+        if (queue.empty()) {
+            return nullptr;
+        }
+        ExtractChunk* chunk = queue.front();
+        queue.pop();
+        return chunk;
+    }
 
-            int sectorOffsetMask = (sectorOffset + pfsc_offset) & 0xFFFFF000;
-            int previousData = (sectorOffset + pfsc_offset) - sectorOffsetMask;
+    void Close() {
+        {
+            std::scoped_lock lock{mutex};
+            closed = true;
+        }
+        cv.notify_all();
+    }
 
-            pkgFile.Seek(fileOffset - previousData);
-            pkgFile.Read(pfsc);
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::queue<ExtractChunk*> queue;
+    bool closed{};
+};
+
+/// Accumulates the amount of data a stage processed and the time it spent working on it.
+struct StageStats {
+    std::atomic<u64> bytes{};
+    std::atomic<u64> busy_ns{};
+
+    void Add(u64 size, std::chrono::steady_clock::time_point begin) {
+        const auto elapsed = std::chrono::steady_clock::now() - begin;
+        bytes += size;
+        busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
 
-            PKG::crypto.decryptPFS(dataKey, tweakKey, pfsc, pfs_decrypted, currentSector1);
+    /// Throughput of a single thread of the stage, in MB/s.
+    double Throughput() const {
+        const u64 ns = busy_ns.load();
+        return ns == 0 ? 0.0 : static_cast<double>(bytes.load()) * 1000.0 / ns;
+    }
+};
 
-            compressedData.resize(sectorSize);
-            std::memcpy(compressedData.data(), pfs_decrypted.data() + previousData, sectorSize);
+} // Anonymous namespace
 
-            if (sectorSize == 0x10000) // Uncompressed data
-                std::memcpy(decompressedData.data(), compressedData.data(), 0x10000);
-            else if (sectorSize < 0x10000) // Compressed data
-                DecompressPFSC(compressedData, decompressedData);
+void PKG::ExtractFiles(std::stop_token stop_token,
+                       const std::function<void(u32 done, u32 total)>& progress,
+                       u64 memory_budget) {
+    std::vector<u32> files;
+    for (const auto& entry : fsTable) {
+        if (entry.type == PFS_FILE) {
+            files.push_back(entry.inode);
+        }
+    }
+    const u32 num_files = static_cast<u32>(files.size());
+    if (progress) {
+        progress(0, num_files);
+    }
+    if (files.empty()) {
+        return;
+    }
 
-            size_decompressed += 0x10000;
+    const auto start_time = std::chrono::steady_clock::now();
+    const u32 num_inflaters = std::max(4U, std::thread::hardware_concurrency()) - 3;
+    const u64 num_chunks = std::clamp<u64>(memory_budget / (MaxChunkInput + MaxChunkOutput),
+                                           num_inflaters + 3, 256);
+    std::vector<ExtractChunk> chunks(num_chunks);
+    StageQueue free_queue, decrypt_queue, inflate_queue, write_queue;
+    for (auto& chunk : chunks) {
+        chunk.input.resize(MaxChunkInput);
+        chunk.output.resize(MaxChunkOutput);
+        free_queue.Push(&chunk);
+    }
+    StageStats read_stats, decrypt_stats, inflate_stats, write_stats;
+
+    // Reads runs of blocks of each file with sector aligned reads large enough for a chunk.
+    std::jthread reader{[&] {
+        Common::SetCurrentThreadName("shadPS4:PkgRead");
+        Common::FS::IOFile pkg_file(pkgpath, Common::FS::FileAccessMode::Read);
+        u64 sequence = 0;
+        for (const u32 inode : files) {
+            const u32 loc = iNodeBuf[inode].loc;
+            const u32 num_blocks = iNodeBuf[inode].Blocks;
+            u32 block = 0;
+            do {
+                if (stop_token.stop_requested()) {
+                    decrypt_queue.Close();
+                    return;
+                }
+                ExtractChunk* chunk = free_queue.Pop();
+                const auto begin = std::chrono::steady_clock::now();
+                chunk->sequence = sequence++;
+                chunk->inode = inode;
+                chunk->first_block = block;
+                chunk->num_blocks = std::min(MaxChunkBlocks, num_blocks - block);
+                chunk->read_size = 0;
+                if (chunk->num_blocks != 0) {
+                    const u64 data_begin = pfsc_offset + sectorMap[loc + block];
+                    const u64 data_end = pfsc_offset + sectorMap[loc + block + chunk->num_blocks];
+                    const u64 read_begin = Common::AlignDown(data_begin, Crypto::PfsSectorSize);
+                    const u64 read_end = Common::AlignUp(data_end, Crypto::PfsSectorSize);
+                    chunk->first_sector = read_begin / Crypto::PfsSectorSize;
+                    chunk->data_offset = data_begin - read_begin;
+                    chunk->read_size = read_end - read_begin;
+                    pkg_file.Seek(pkgheader.pfs_image_offset + read_begin);
+                    pkg_file.ReadRaw<u8>(chunk->input.data(), chunk->read_size);
+                }
+                block += chunk->num_blocks;
+                read_stats.Add(chunk->read_size, begin);
+                decrypt_queue.Push(chunk);
+            } while (block < num_blocks);
+        }
+        decrypt_queue.Close();
+    }};
+
+    std::jthread decrypter{[&] {
+        Common::SetCurrentThreadName("shadPS4:PkgDecrypt");
+        Crypto::PfsDecryptor decryptor{dataKey, tweakKey};
+        while (ExtractChunk* chunk = decrypt_queue.Pop()) {
+            const auto begin = std::chrono::steady_clock::now();
+            const std::span data{chunk->input.data(), chunk->read_size};
+            decryptor.Decrypt(data, data, chunk->first_sector);
+            decrypt_stats.Add(chunk->read_size, begin);
+            inflate_queue.Push(chunk);
+        }
+        inflate_queue.Close();
+    }};
+
+    // Inflation is the most expensive stage, so it gets the remaining cores. Chunks may leave it
+    // out of order and are put back in sequence by the writer.
+    std::atomic<u32> active_inflaters{num_inflaters};
+    std::vector<std::jthread> inflaters;
+    inflaters.reserve(num_inflaters);
+    for (u32 i = 0; i < num_inflaters; i++) {
+        inflaters.emplace_back([&] {
+            Common::SetCurrentThreadName("shadPS4:PkgInflate");
+            while (ExtractChunk* chunk = inflate_queue.Pop()) {
+                const auto begin = std::chrono::steady_clock::now();
+                const u32 loc = iNodeBuf[chunk->inode].loc + chunk->first_block;
+                for (u32 j = 0; j < chunk->num_blocks; j++) {
+                    const u64 offset = chunk->data_offset + sectorMap[loc + j] - sectorMap[loc];
+                    const u64 size = sectorMap[loc + j + 1] - sectorMap[loc + j];
+                    const std::span compressed{
+                        reinterpret_cast<const char*>(chunk->input.data()) + offset, size};
+                    const std::span decompressed{chunk->output.data() + j * PfscBlockSize,
+                                                 PfscBlockSize};
+                    if (size == PfscBlockSize) { // Uncompressed data
+                        std::memcpy(decompressed.data(), compressed.data(), PfscBlockSize);
+                    } else if (size < PfscBlockSize) { // Compressed data
+                        DecompressPFSC(compressed, decompressed);
+                    }
+                }
+                inflate_stats.Add(chunk->num_blocks * PfscBlockSize, begin);
+                write_queue.Push(chunk);
+            }
+            if (--active_inflaters == 0) {
+                write_queue.Close();
+            }
+        });
+    }
 
-            if (j < nblocks - 1) {
-                inflated.WriteRaw<u8>(decompressedData.data(), decompressedData.size());
-            } else {
-                // This is to remove the zeros at the end of the file.
-                const u32 write_size = decompressedData.size() - (size_decompressed - bsize);
-                inflated.WriteRaw<u8>(decompressedData.data(), write_size);
+    // The calling thread writes the chunks back in the order they were read.
+    u32 files_done = 0;
+    u64 next_sequence = 0;
+    std::map<u64, ExtractChunk*> pending;
+    Common::FS::IOFile inflated;
+    while (ExtractChunk* chunk = write_queue.Pop()) {
+        pending.emplace(chunk->sequence, chunk);
+        for (auto it = pending.begin(); it != pending.end() && it->first == next_sequence;
+             it = pending.erase(it), next_sequence++) {
+            ExtractChunk* ready = it->second;
+            const auto begin = std::chrono::steady_clock::now();
+            const Inode& node = iNodeBuf[ready->inode];
+            if (ready->first_block == 0) {
+                inflated.Open(extractPaths[ready->inode], Common::FS::FileAccessMode::Write);
             }
+            // The last block is cut to the file size to remove the zeros at the end of the file.
+            const u64 file_offset = ready->first_block * PfscBlockSize;
+            const u64 write_size = std::min<u64>(ready->num_blocks * PfscBlockSize,
+                                                 static_cast<u64>(node.Size) - file_offset);
+            inflated.WriteRaw<char>(ready->output.data(), write_size);
+            write_stats.Add(write_size, begin);
+            if (ready->first_block + ready->num_blocks >= node.Blocks) {
+                inflated.Close();
+                if (progress) {
+                    progress(++files_done, num_files);
+                }
+            }
+            free_queue.Push(ready);
         }
-        pkgFile.Close();
-        inflated.Close();
     }
+
+    reader.join();
+    decrypter.join();
+    inflaters.clear();
+
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    LOG_INFO(Loader,
+             "Extracted {}/{} files ({:.1f} MB) in {:.2f}s, per thread throughput: read {:.1f} "
+             "MB/s, decrypt {:.1f} MB/s, inflate {:.1f} MB/s ({} threads), write {:.1f} MB/s",
+             files_done, num_files, write_stats.bytes.load() / 1e6, seconds,
+             read_stats.Throughput(), decrypt_stats.Throughput(), inflate_stats.Throughput(),
+             num_inflaters, write_stats.Throughput());
 }
@@ -5,14 +5,24 @@
 
 #include <array>
 #include <filesystem>
+#include <functional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "common/endian.h"
+#include "common/polyfill_thread.h"
 #include "core/crypto/crypto.h"
 #include "pfs.h"
 #include "trp.h"
 
+namespace Core::FileSys {
+class PfsImage;
+}
+
+/// Inflates a compressed PFSC block.
+void DecompressPFSC(std::span<const char> compressed_data, std::span<char> decompressed_data);
+
 struct PKGHeader {
     u32_be magic; // Magic
     u32_be pkg_type;
@@ -103,8 +113,16 @@ public:
     PKG();
     ~PKG();
 
+    static constexpr u64 DefaultExtractMemoryBudget = 256_MB;
+
     bool Open(const std::filesystem::path& filepath, std::string& failreason);
-    void ExtractFiles(const int index);
+
+    /// Extracts every file of the package through a read, decrypt, inflate and write pipeline.
+    /// The buffers of the chunks in flight are kept within memory_budget and progress is
+    /// reported as the number of files written so far out of the total.
+    void ExtractFiles(std::stop_token stop_token,
+                      const std::function<void(u32 done, u32 total)>& progress,
+                      u64 memory_budget = DefaultExtractMemoryBudget);
     bool Extract(const std::filesystem::path& filepath, const std::filesystem::path& extract,
                  std::string& failreason);
 
@@ -147,6 +165,8 @@ public:
          {PKGContentFlag::CUMULATIVE_PATCH, "CUMULATIVE_PATCH"}}};
 
 private:
+    friend class Core::FileSys::PfsImage;
+
     Crypto crypto;
     TRP trp;
     u64 pkgSize = 0;
@@ -0,0 +1,529 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <boost/container/small_vector.hpp>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/polyfill_thread.h"
+#include "common/thread.h"
+#include "core/file_sys/aio_engine.h"
+#include "core/file_sys/fs.h"
+#include "core/libraries/error_codes.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Core::FileSys {
+
+#ifdef __linux__
+
+/// Minimal io_uring wrapper over the raw system calls, only used by the ring thread.
+class IoUring {
+public:
+    explicit IoUring(u32 entries) {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return;
+        }
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+        sq_ring = Map(sq_ring_size, IORING_OFF_SQ_RING);
+        cq_ring = params.features & IORING_FEAT_SINGLE_MMAP
+                      ? sq_ring
+                      : Map(cq_ring_size, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(Map(sqes_size, IORING_OFF_SQES));
+        if (!sq_ring || !cq_ring || !sqes) {
+            Release();
+            return;
+        }
+        u8* const sq = static_cast<u8*>(sq_ring);
+        sq_head = reinterpret_cast<u32*>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<u32*>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<u32*>(sq + params.sq_off.array);
+        sq_entries = params.sq_entries;
+        u8* const cq = static_cast<u8*>(cq_ring);
+        cq_head = reinterpret_cast<u32*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<u32*>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~IoUring() {
+        Release();
+    }
+
+    [[nodiscard]] bool IsValid() const noexcept {
+        return fd >= 0;
+    }
+
+    [[nodiscard]] u32 NumEntries() const noexcept {
+        return sq_entries;
+    }
+
+    /// Returns the next free submission entry, or nullptr when the queue is full.
+    io_uring_sqe* NextSqe() {
+        const u32 head = std::atomic_ref{*sq_head}.load(std::memory_order_acquire);
+        if (local_tail - head >= sq_entries) {
+            return nullptr;
+        }
+        const u32 index = local_tail & sq_mask;
+        sq_array[index] = index;
+        ++local_tail;
+        ++num_queued;
+        io_uring_sqe* const sqe = &sqes[index];
+        *sqe = {};
+        return sqe;
+    }
+
+    /// Submits the queued entries and waits for at least min_complete completions.
+    int Enter(u32 min_complete) {
+        std::atomic_ref{*sq_tail}.store(local_tail, std::memory_order_release);
+        const u32 flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        const int result = static_cast<int>(
+            syscall(__NR_io_uring_enter, fd, num_queued, min_complete, flags, nullptr, 0));
+        if (result >= 0) {
+            num_queued -= std::min<u32>(num_queued, result);
+        }
+        return result;
+    }
+
+    template <typename Func>
+    void ForEachCompletion(Func&& func) {
+        u32 head = *cq_head;
+        const u32 tail = std::atomic_ref{*cq_tail}.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            func(cqes[head & cq_mask]);
+        }
+        std::atomic_ref{*cq_head}.store(head, std::memory_order_release);
+    }
+
+private:
+    void* Map(size_t size, u64 offset) const {
+        void* const ptr =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    void Release() {
+        if (sqes) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ring && cq_ring != sq_ring) {
+            munmap(cq_ring, cq_ring_size);
+        }
+        if (sq_ring) {
+            munmap(sq_ring, sq_ring_size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        sqes = nullptr;
+        sq_ring = cq_ring = nullptr;
+        fd = -1;
+    }
+
+    int fd{-1};
+    void* sq_ring{};
+    void* cq_ring{};
+    size_t sq_ring_size{};
+    size_t cq_ring_size{};
+    size_t sqes_size{};
+    io_uring_sqe* sqes{};
+    u32* sq_head{};
+    u32* sq_tail{};
+    u32* sq_array{};
+    u32 sq_mask{};
+    u32 sq_entries{};
+    u32 local_tail{};
+    u32 num_queued{};
+    u32* cq_head{};
+    u32* cq_tail{};
+    u32 cq_mask{};
+    io_uring_cqe* cqes{};
+};
+
+namespace {
+
+constexpr u32 RingEntries = 64;
+constexpr u64 WakeUserData = 0;
+
+} // Anonymous namespace
+
+#else
+
+class IoUring {};
+
+#endif
+
+AioEngine::AioEngine() {
+    const u32 num_workers = std::clamp(std::thread::hardware_concurrency() / 4, 2U, 4U);
+    for (u32 i = 0; i < num_workers; ++i) {
+        threads.emplace_back([this](std::stop_token stop_token) { WorkerMain(stop_token); });
+    }
+#ifdef __linux__
+    ring = std::make_unique<IoUring>(RingEntries);
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (ring->IsValid() && wake_fd >= 0) {
+        threads.emplace_back([this](std::stop_token stop_token) { RingMain(stop_token); });
+    } else {
+        LOG_WARNING(Kernel_Fs, "io_uring is unavailable, serving AIO from worker threads only");
+        ring.reset();
+        if (wake_fd >= 0) {
+            close(wake_fd);
+            wake_fd = -1;
+        }
+    }
+#endif
+    LOG_INFO(Kernel_Fs, "AIO engine started with {} workers{}", num_workers,
+             ring ? " and io_uring" : "");
+}
+
+AioEngine::~AioEngine() {
+    Shutdown();
+}
+
+void AioEngine::Shutdown() {
+    if (threads.empty()) {
+        return;
+    }
+    for (auto& thread : threads) {
+        thread.request_stop();
+    }
+#ifdef __linux__
+    if (wake_fd >= 0) {
+        const u64 value = 1;
+        [[maybe_unused]] const auto written = write(wake_fd, &value, sizeof(value));
+    }
+#endif
+    threads.clear();
+#ifdef __linux__
+    if (wake_fd >= 0) {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+#endif
+    {
+        // Drop the file references held by requests that will never run.
+        std::scoped_lock lk{mutex};
+        for (Queues* queues : {&pool_queues, &ring_queues}) {
+            for (auto& queue : *queues) {
+                queue.clear();
+            }
+        }
+        batches.clear();
+    }
+    LogLatencyHistogram();
+}
+
+AioEngine::BatchId AioEngine::Submit(std::span<const AioRequest> requests, bool is_write,
+                                     AioPriority priority) {
+    const auto now = Clock::now();
+    auto batch = std::make_shared<Batch>();
+    batch->num_pending = static_cast<u32>(requests.size());
+    bool wake_ring = false;
+    BatchId id;
+    {
+        std::scoped_lock lk{mutex};
+        id = next_id;
+        next_id = next_id == std::numeric_limits<BatchId>::max() ? 1 : next_id + 1;
+        batches.insert_or_assign(id, batch);
+        if (requests.empty()) {
+            batch->state = AioState::Completed;
+            return id;
+        }
+        const u32 queue = static_cast<u32>(priority);
+        for (const AioRequest& request : requests) {
+            if (request.result) {
+                request.result->state = AioState::Submitted;
+            }
+            // Only read-only host files can be read without the stream lock, see sceKernelPread.
+            const File* file = request.file.get();
+            const bool use_ring = ring && !is_write && !file->pfs &&
+                                  file->f.GetAccessMode() == Common::FS::FileAccessMode::Read;
+            auto& queues = use_ring ? ring_queues : pool_queues;
+            queues[queue].push_back({batch, request, is_write, now});
+            wake_ring |= use_ring;
+        }
+    }
+    work_cv.notify_all();
+#ifdef __linux__
+    if (wake_ring) {
+        const u64 value = 1;
+        [[maybe_unused]] const auto written = write(wake_fd, &value, sizeof(value));
+    }
+#endif
+    return id;
+}
+
+std::optional<AioState> AioEngine::Poll(BatchId id) {
+    std::scoped_lock lk{mutex};
+    const auto it = batches.find(id);
+    if (it == batches.end()) {
+        return std::nullopt;
+    }
+    return it->second->state;
+}
+
+bool AioEngine::Wait(std::span<const BatchId> ids, std::span<AioState> states, bool wait_all,
+                     std::optional<Clock::time_point> deadline) {
+    std::unique_lock lk{mutex};
+    boost::container::small_vector<std::shared_ptr<Batch>, 8> waited;
+    for (const BatchId id : ids) {
+        const auto it = batches.find(id);
+        if (it == batches.end()) {
+            return false;
+        }
+        waited.push_back(it->second);
+    }
+    const auto is_done = [&] {
+        const auto finished = [](const auto& batch) {
+            return batch->state == AioState::Completed || batch->state == AioState::Aborted;
+        };
+        return wait_all ? std::ranges::all_of(waited, finished)
+                        : std::ranges::any_of(waited, finished);
+    };
+    if (deadline) {
+        done_cv.wait_until(lk, *deadline, is_done);
+    } else {
+        done_cv.wait(lk, is_done);
+    }
+    for (size_t i = 0; i < waited.size(); ++i) {
+        states[i] = waited[i]->state;
+    }
+    return true;
+}
+
+std::optional<AioState> AioEngine::Cancel(BatchId id) {
+    std::unique_lock lk{mutex};
+    const auto it = batches.find(id);
+    if (it == batches.end()) {
+        return std::nullopt;
+    }
+    const std::shared_ptr<Batch> batch = it->second;
+    u32 num_aborted{};
+    for (Queues* queues : {&pool_queues, &ring_queues}) {
+        for (auto& queue : *queues) {
+            std::erase_if(queue, [&](const Operation& op) {
+                if (op.batch != batch) {
+                    return false;
+                }
+                if (op.request.result) {
+                    op.request.result->state = AioState::Aborted;
+                }
+                ++num_aborted;
+                return true;
+            });
+        }
+    }
+    if (num_aborted == 0) {
+        return batch->state;
+    }
+    batch->num_pending -= num_aborted;
+    batch->num_aborted += num_aborted;
+    if (batch->num_pending == 0) {
+        batch->state = AioState::Aborted;
+    }
+    const AioState state = batch->state;
+    lk.unlock();
+    done_cv.notify_all();
+    return state;
+}
+
+bool AioEngine::Delete(BatchId id) {
+    std::scoped_lock lk{mutex};
+    return batches.erase(id) != 0;
+}
+
+AioEngine::LatencyHistogram AioEngine::GetLatencyHistogram() const {
+    LatencyHistogram histogram;
+    for (size_t i = 0; i < NumLatencyBuckets; ++i) {
+        histogram[i] = latency_buckets[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+}
+
+std::optional<AioEngine::Operation> AioEngine::PopNext(Queues& queues) {
+    for (auto it = queues.rbegin(); it != queues.rend(); ++it) {
+        if (!it->empty()) {
+            Operation op = std::move(it->front());
+            it->pop_front();
+            return op;
+        }
+    }
+    return std::nullopt;
+}
+
+s64 AioEngine::Execute(const Operation& op) {
+    File* const file = op.request.file.get();
+    u8* const buf = static_cast<u8*>(op.request.buf);
+    if (file->pfs) {
+        if (op.is_write) {
+            return ORBIS_KERNEL_ERROR_EROFS;
+        }
+        return file->pfs->Read(file->pfs_entry, op.request.offset, {buf, op.request.size});
+    }
+    if (!op.is_write && Common::FS::IOFile::HasPositionalReads &&
+        file->f.GetAccessMode() == Common::FS::FileAccessMode::Read) {
+        const s64 read = file->f.ReadAt(buf, op.request.size, op.request.offset);
+        return read < 0 ? ORBIS_KERNEL_ERROR_EIO : read;
+    }
+    std::scoped_lock lk{file->m_mutex};
+    if (!op.is_write) {
+        file->f.Flush();
+        const s64 read = file->f.ReadAt(buf, op.request.size, op.request.offset);
+        return read < 0 ? ORBIS_KERNEL_ERROR_EIO : read;
+    }
+    const s64 pos = file->f.Tell();
+    if (!file->f.Seek(op.request.offset)) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    const s64 written = file->f.WriteRaw<u8>(buf, op.request.size);
+    file->f.Seek(pos);
+    return written;
+}
+
+void AioEngine::Complete(const Operation& op, s64 result) {
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - op.submit_time);
+    const size_t bucket = std::min<size_t>(std::bit_width(static_cast<u64>(latency.count())),
+                                           NumLatencyBuckets - 1);
+    latency_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    {
+        std::scoped_lock lk{mutex};
+        if (op.request.result) {
+            op.request.result->return_value = result;
+            op.request.result->state = AioState::Completed;
+        }
+        if (--op.batch->num_pending == 0) {
+            op.batch->state =
+                op.batch->num_aborted != 0 ? AioState::Aborted : AioState::Completed;
+        }
+    }
+    done_cv.notify_all();
+}
+
+void AioEngine::WorkerMain(std::stop_token stop_token) {
+    Common::SetCurrentThreadName("shadPS4:AioWorker");
+    while (!stop_token.stop_requested()) {
+        std::optional<Operation> op;
+        {
+            std::unique_lock lk{mutex};
+            Common::CondvarWait(work_cv, lk, stop_token, [this] {
+                return std::ranges::any_of(pool_queues, [](auto& q) { return !q.empty(); });
+            });
+            if (stop_token.stop_requested()) {
+                break;
+            }
+            op = PopNext(pool_queues);
+            op->batch->state = AioState::Processing;
+            if (op->request.result) {
+                op->request.result->state = AioState::Processing;
+            }
+        }
+        Complete(*op, Execute(*op));
+    }
+}
+
+#ifdef __linux__
+void AioEngine::RingMain(std::stop_token stop_token) {
+    Common::SetCurrentThreadName("shadPS4:AioRing");
+    // In flight operations are indexed by their user data, zero is the wake up poll.
+    // One submission entry stays reserved for the wake up poll.
+    std::vector<std::optional<Operation>> in_flight(ring->NumEntries() - 1);
+    std::vector<u64> free_slots;
+    for (u64 slot = in_flight.size(); slot > 0; --slot) {
+        free_slots.push_back(slot);
+    }
+    bool wake_armed = false;
+    while (!stop_token.stop_requested()) {
+        if (!wake_armed) {
+            io_uring_sqe* const sqe = ring->NextSqe();
+            ASSERT(sqe);
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = wake_fd;
+            sqe->poll_events = POLLIN;
+            sqe->user_data = WakeUserData;
+            wake_armed = true;
+        }
+        {
+            std::scoped_lock lk{mutex};
+            while (!free_slots.empty()) {
+                std::optional<Operation> op = PopNext(ring_queues);
+                if (!op) {
+                    break;
+                }
+                io_uring_sqe* const sqe = ring->NextSqe();
+                ASSERT(sqe);
+                const u64 slot = free_slots.back();
+                free_slots.pop_back();
+                op->batch->state = AioState::Processing;
+                if (op->request.result) {
+                    op->request.result->state = AioState::Processing;
+                }
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = op->request.file->f.GetDescriptor();
+                sqe->addr = reinterpret_cast<u64>(op->request.buf);
+                sqe->len = static_cast<u32>(op->request.size);
+                sqe->off = op->request.offset;
+                sqe->user_data = slot;
+                in_flight[slot - 1] = std::move(op);
+            }
+        }
+        if (ring->Enter(1) < 0 && errno != EINTR) {
+            LOG_ERROR(Kernel_Fs, "io_uring_enter failed with errno {}", errno);
+        }
+        ring->ForEachCompletion([&](const io_uring_cqe& cqe) {
+            if (cqe.user_data == WakeUserData) {
+                u64 value;
+                [[maybe_unused]] const auto num_read = read(wake_fd, &value, sizeof(value));
+                wake_armed = false;
+                return;
+            }
+            Operation op = std::move(*in_flight[cqe.user_data - 1]);
+            in_flight[cqe.user_data - 1].reset();
+            free_slots.push_back(cqe.user_data);
+            if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+                // Kernels older than 5.6 lack plain reads, serve the request directly.
+                Complete(op, Execute(op));
+                return;
+            }
+            Complete(op, cqe.res < 0 ? ORBIS_KERNEL_ERROR_EIO : cqe.res);
+        });
+    }
+}
+#endif
+
+void AioEngine::LogLatencyHistogram() const {
+    const LatencyHistogram histogram = GetLatencyHistogram();
+    u64 total{};
+    for (const u64 count : histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return;
+    }
+    LOG_INFO(Kernel_Fs, "AIO completed {} requests, latency histogram:", total);
+    for (size_t i = 0; i < NumLatencyBuckets; ++i) {
+        if (histogram[i] != 0) {
+            LOG_INFO(Kernel_Fs, "  < {:>9} us: {}", u64{1} << i, histogram[i]);
+        }
+    }
+}
+
+} // namespace Core::FileSys
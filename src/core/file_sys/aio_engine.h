@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+#include <tsl/robin_map.h>
+#include "common/types.h"
+#include "core/file_sys/fs.h"
+
+namespace Core::FileSys {
+
+class IoUring;
+
+/// State of an asynchronous request, the values match the guest AIO states.
+enum class AioState : u32 {
+    Submitted = 1,
+    Processing = 2,
+    Completed = 3,
+    Aborted = 4,
+};
+
+/// Scheduling class of a batch, higher priorities are dispatched first.
+enum class AioPriority : u32 {
+    Low = 0,
+    Mid = 1,
+    High = 2,
+};
+
+/// Completion record of a single request, laid out like the guest one.
+struct AioResult {
+    s64 return_value;
+    AioState state;
+};
+static_assert(sizeof(AioResult) == 16);
+
+struct AioRequest {
+    FileRef file; ///< Keeps the file alive if the guest closes it while the request is queued
+    void* buf;
+    u64 size;
+    s64 offset;
+    AioResult* result; ///< Written on completion, may be null
+};
+
+/**
+ * Executes file reads and writes asynchronously to the submitting thread. Requests are grouped in
+ * batches that complete as a whole. Reads of read-only host files go through io_uring on Linux
+ * when the host allows it, everything else is served by a pool of worker threads.
+ */
+class AioEngine {
+public:
+    using BatchId = s32;
+    using Clock = std::chrono::steady_clock;
+
+    /// Completion latencies are bucketed by powers of two microseconds.
+    static constexpr size_t NumLatencyBuckets = 24;
+    using LatencyHistogram = std::array<u64, NumLatencyBuckets>;
+
+    explicit AioEngine();
+    ~AioEngine();
+
+    /// Stops and joins the worker threads, queued requests are dropped.
+    void Shutdown();
+
+    AioEngine(const AioEngine&) = delete;
+    AioEngine& operator=(const AioEngine&) = delete;
+
+    /// Queues a batch of requests and returns its id.
+    BatchId Submit(std::span<const AioRequest> requests, bool is_write, AioPriority priority);
+
+    /// Returns the state of a batch, or nullopt when the id is unknown.
+    std::optional<AioState> Poll(BatchId id);
+
+    /**
+     * Waits until all or any of the batches finished or the deadline passed. Returns the state of
+     * each batch in states, or false when an id is unknown.
+     */
+    bool Wait(std::span<const BatchId> ids, std::span<AioState> states, bool wait_all,
+              std::optional<Clock::time_point> deadline);
+
+    /**
+     * Aborts the requests of a batch that were not started yet and returns its state. The batch
+     * stays in the processing state while requests that were already started are running, it is
+     * aborted once they finish.
+     */
+    std::optional<AioState> Cancel(BatchId id);
+
+    /// Forgets a batch, requests that are still running complete in the background.
+    bool Delete(BatchId id);
+
+    /// Returns the number of completed requests per latency bucket.
+    [[nodiscard]] LatencyHistogram GetLatencyHistogram() const;
+
+private:
+    struct Batch {
+        u32 num_pending{};
+        u32 num_aborted{};
+        AioState state{AioState::Submitted};
+    };
+
+    struct Operation {
+        std::shared_ptr<Batch> batch;
+        AioRequest request;
+        bool is_write;
+        Clock::time_point submit_time;
+    };
+
+    using Queues = std::array<std::deque<Operation>, 3>;
+
+    static std::optional<Operation> PopNext(Queues& queues);
+
+    s64 Execute(const Operation& op);
+
+    void Complete(const Operation& op, s64 result);
+
+    void WorkerMain(std::stop_token stop_token);
+
+#ifdef __linux__
+    void RingMain(std::stop_token stop_token);
+#endif
+
+    void LogLatencyHistogram() const;
+
+    std::mutex mutex;
+    std::condition_variable_any work_cv;
+    std::condition_variable_any done_cv;
+    tsl::robin_map<BatchId, std::shared_ptr<Batch>> batches;
+    BatchId next_id{1};
+    Queues pool_queues;
+    Queues ring_queues;
+    std::unique_ptr<IoUring> ring;
+    int wake_fd{-1}; ///< Eventfd that interrupts the ring thread when work is queued
+    std::array<std::atomic<u64>, NumLatencyBuckets> latency_buckets{};
+    std::vector<std::jthread> threads;
+};
+
+} // namespace Core::FileSys
@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <algorithm>
+#include <utility>
+#include "common/assert.h"
 #include "common/string_util.h"
 #include "core/file_sys/fs.h"
 
@@ -15,6 +17,12 @@ void MntPoints::Mount(const std::filesystem::path& host_folder, const std::strin
     m_mnt_pairs.emplace_back(host_folder, guest_folder, read_only);
 }
 
+void MntPoints::Mount(std::shared_ptr<PfsImage> pfs, const std::string& guest_folder) {
+    std::scoped_lock lock{m_mutex};
+    const auto host_folder = pfs->GetMetaDir();
+    m_mnt_pairs.emplace_back(host_folder, guest_folder, true, std::move(pfs));
+}
+
 void MntPoints::Unmount(const std::filesystem::path& host_folder, const std::string& guest_folder) {
     std::scoped_lock lock{m_mutex};
     auto it = std::remove_if(m_mnt_pairs.begin(), m_mnt_pairs.end(),
@@ -58,101 +66,257 @@ std::filesystem::path MntPoints::GetHostPath(std::string_view guest_directory, b
         return host_path;
     }
 
-    // If the path does not exist attempt to verify this.
-    // Retrieve parent path until we find one that exists.
-    std::scoped_lock lk{m_mutex};
-    path_parts.clear();
-    auto current_path = host_path;
-    while (!std::filesystem::exists(current_path)) {
-        // We have probably cached this if it's a folder.
-        if (auto it = path_cache.find(current_path); it != path_cache.end()) {
-            current_path = it->second;
-            break;
-        }
-        path_parts.emplace_back(current_path.filename());
-        current_path = current_path.parent_path();
-    }
-
-    // We have found an anchor. Traverse parts we recoded and see if they
-    // exist in filesystem but in different case.
-    auto guest_path = current_path;
-    while (!path_parts.empty()) {
-        const auto part = path_parts.back();
-        const auto add_match = [&](const auto& host_part) {
-            current_path /= host_part;
-            guest_path /= part;
-            path_cache[guest_path] = current_path;
-            path_parts.pop_back();
-        };
-
-        // Can happen when the mismatch is in upper folder.
-        if (std::filesystem::exists(current_path / part)) {
-            add_match(part);
+    // Resolve every component through the lowercase index of its parent directory.
+    std::scoped_lock lk{index_mutex};
+    auto current_path = mount->host_path;
+    for (const auto& part : std::filesystem::path(rel_path)) {
+        const auto part_str = part.string();
+        if (part_str.empty() || part_str == ".") {
             continue;
         }
-        const auto part_low = Common::ToLower(part.string());
-        bool found_match = false;
-        for (const auto& path : std::filesystem::directory_iterator(current_path)) {
-            const auto candidate = path.path().filename();
-            const auto filename = Common::ToLower(candidate.string());
-            // Check if a filename matches in case insensitive manner.
-            if (filename != part_low) {
-                continue;
-            }
-            // We found a match, record the actual path in the cache.
-            add_match(candidate);
-            found_match = true;
-            break;
+        if (part_str == "..") {
+            current_path = current_path.parent_path();
+            continue;
         }
-        if (!found_match) {
-            // Opening the guest path will surely fail but at least gives
-            // a better error message than the empty path.
+        const std::string* host_name = FindInIndex(current_path, Common::ToLower(part_str));
+        if (!host_name) {
+            // Opening the guest path will surely fail, or it is about to be created, either way
+            // the path as given is the most sensible answer.
             return host_path;
         }
+        current_path /= *host_name;
     }
 
     // The path was found.
     return current_path;
 }
 
-int HandleTable::CreateHandle() {
-    std::scoped_lock lock{m_mutex};
+void MntPoints::InvalidateHostPath(const std::filesystem::path& host_path) {
+    if (!NeedsCaseInsensitiveSearch) {
+        return;
+    }
+    // Drop the parent listing and everything below the path, it may have been a directory.
+    const auto prefix = host_path.native();
+    std::scoped_lock lk{index_mutex};
+    dir_index.erase(host_path.parent_path());
+    for (auto it = dir_index.begin(); it != dir_index.end();) {
+        const auto& dir = it->first.native();
+        if (dir.starts_with(prefix) &&
+            (dir.size() == prefix.size() || dir[prefix.size()] == '/')) {
+            it = dir_index.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+const std::string* MntPoints::FindInIndex(const std::filesystem::path& dir,
+                                          const std::string& lower_name) {
+    const auto populate = [&](DirIndex& index) {
+        index.entries.clear();
+        std::error_code ec;
+        index.last_write = std::filesystem::last_write_time(dir, ec);
+        index.scan_time = std::filesystem::file_time_type::clock::now();
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+            auto name = entry.path().filename().string();
+            index.entries.emplace(Common::ToLower(name), std::move(name));
+        }
+    };
+    auto [it, inserted] = dir_index.try_emplace(dir);
+    DirIndex& index = it.value();
+    if (inserted) {
+        populate(index);
+    }
+    if (const auto entry = index.entries.find(lower_name); entry != index.entries.end()) {
+        return &entry->second;
+    }
+    // Files created behind our back only change the modification time, rescan in that case.
+    // With coarse timestamps a change right after the listing may keep the same time, so the
+    // listing is only trusted once it is older than the granularity.
+    std::error_code ec;
+    const bool maybe_stale = index.last_write > index.scan_time - MtimeGranularity;
+    if (inserted ||
+        (!maybe_stale && std::filesystem::last_write_time(dir, ec) == index.last_write)) {
+        return nullptr;
+    }
+    populate(index);
+    const auto entry = index.entries.find(lower_name);
+    return entry != index.entries.end() ? &entry->second : nullptr;
+}
+
+std::shared_ptr<PfsImage> MntPoints::GetPfsImage(std::string_view guest_path,
+                                                 std::string* rel_path) {
+    std::string corrected_path(guest_path);
+    size_t pos = corrected_path.find("//");
+    while (pos != std::string::npos) {
+        corrected_path.replace(pos, 2, "/");
+        pos = corrected_path.find("//", pos + 1);
+    }
 
+    const MntPair* mount = GetMount(corrected_path);
+    if (!mount || !mount->pfs) {
+        return nullptr;
+    }
+    if (rel_path) {
+        *rel_path = corrected_path.substr(std::min(mount->mount.size(), corrected_path.size()));
+    }
+    return mount->pfs;
+}
+
+FileRef::~FileRef() {
+    Reset();
+}
+
+FileRef::FileRef(const FileRef& other) : table{other.table}, slot{other.slot}, file{other.file} {
+    if (file) {
+        table->m_slots[slot].state.fetch_add(HandleTable::SlotRef, std::memory_order_relaxed);
+    }
+}
+
+FileRef& FileRef::operator=(const FileRef& other) {
+    if (this != &other) {
+        *this = FileRef{other};
+    }
+    return *this;
+}
+
+FileRef::FileRef(FileRef&& other) noexcept
+    : table{std::exchange(other.table, nullptr)}, slot{other.slot},
+      file{std::exchange(other.file, nullptr)} {}
+
+FileRef& FileRef::operator=(FileRef&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        table = std::exchange(other.table, nullptr);
+        slot = other.slot;
+        file = std::exchange(other.file, nullptr);
+    }
+    return *this;
+}
+
+void FileRef::Reset() noexcept {
+    if (file) {
+        table->Release(slot);
+        file = nullptr;
+        table = nullptr;
+    }
+}
+
+HandleTable::HandleTable() {
+    for (int i = 0; i < MaxHandles; ++i) {
+        const u32 next = i + 1 < MaxHandles ? static_cast<u32>(i + 2) : 0;
+        m_slots[i].next_free.store(next, std::memory_order_relaxed);
+    }
+    m_free_head.store(1, std::memory_order_release);
+}
+
+HandleTable::~HandleTable() {
+    for (Slot& slot : m_slots) {
+        delete slot.file;
+    }
+}
+
+int HandleTable::CreateHandle() {
     auto* file = new File{};
     file->is_directory = false;
     file->is_opened = false;
 
-    int existingFilesNum = m_files.size();
+    u64 head = m_free_head.load(std::memory_order_acquire);
+    u32 index;
+    do {
+        index = static_cast<u32>(head);
+        if (index == 0) {
+            delete file;
+            return -1;
+        }
+        const u64 next = m_slots[index - 1].next_free.load(std::memory_order_relaxed);
+        const u64 new_head = ((head >> 32) + 1) << 32 | next;
+        if (m_free_head.compare_exchange_weak(head, new_head, std::memory_order_acquire)) {
+            break;
+        }
+    } while (true);
+
+    Slot& slot = m_slots[index - 1];
+    slot.file = file;
+    slot.state.store(SlotOpen, std::memory_order_release);
+    return static_cast<int>(index - 1) + RESERVED_HANDLES;
+}
 
-    for (int index = 0; index < existingFilesNum; index++) {
-        if (m_files.at(index) == nullptr) {
-            m_files[index] = file;
-            return index + RESERVED_HANDLES;
+void HandleTable::DeleteHandle(int d) {
+    // Hold a reference so the file outlives the index update even if another close races us.
+    const FileRef file = GetFile(d);
+    if (!file) {
+        return;
+    }
+    if (!file->m_host_name.empty()) {
+        std::scoped_lock lock{m_mutex};
+        const auto it = m_path_index.find(file->m_host_name);
+        if (it != m_path_index.end()) {
+            auto& handles = it.value();
+            std::erase(handles, d);
+            if (handles.empty()) {
+                m_path_index.erase(it);
+            }
         }
     }
+    // The file is destroyed when the last reference, possibly ours, is dropped.
+    m_slots[file.slot].state.fetch_and(~SlotOpen, std::memory_order_acq_rel);
+}
 
-    m_files.push_back(file);
-    return m_files.size() + RESERVED_HANDLES - 1;
+FileRef HandleTable::GetFile(int d) {
+    const int slot_index = d - RESERVED_HANDLES;
+    if (slot_index < 0 || slot_index >= MaxHandles) {
+        return {};
+    }
+    return Acquire(static_cast<u32>(slot_index));
 }
 
-void HandleTable::DeleteHandle(int d) {
+FileRef HandleTable::GetFile(const std::filesystem::path& host_name) {
     std::scoped_lock lock{m_mutex};
-    delete m_files.at(d - RESERVED_HANDLES);
-    m_files[d - RESERVED_HANDLES] = nullptr;
+    const auto it = m_path_index.find(host_name);
+    if (it == m_path_index.end()) {
+        return {};
+    }
+    return GetFile(it->second.front());
 }
 
-File* HandleTable::GetFile(int d) {
+void HandleTable::SetHostName(int d, std::filesystem::path host_name) {
+    const FileRef file = GetFile(d);
+    ASSERT_MSG(file, "Setting the host name of closed descriptor {}", d);
     std::scoped_lock lock{m_mutex};
-    return m_files.at(d - RESERVED_HANDLES);
+    file->m_host_name = std::move(host_name);
+    m_path_index[file->m_host_name].push_back(d);
 }
 
-File* HandleTable::GetFile(const std::filesystem::path& host_name) {
-    for (auto* file : m_files) {
-        if (file != nullptr && file->m_host_name == host_name) {
-            return file;
+FileRef HandleTable::Acquire(u32 slot_index) {
+    Slot& slot = m_slots[slot_index];
+    u64 state = slot.state.load(std::memory_order_relaxed);
+    do {
+        if (!(state & SlotOpen)) {
+            return {};
         }
+    } while (!slot.state.compare_exchange_weak(state, state + SlotRef, std::memory_order_acquire,
+                                               std::memory_order_relaxed));
+    return FileRef{this, slot_index, slot.file};
+}
+
+void HandleTable::Release(u32 slot_index) {
+    const u64 state = m_slots[slot_index].state.fetch_sub(SlotRef, std::memory_order_acq_rel);
+    if (state == SlotRef) {
+        Reclaim(slot_index);
     }
-    return nullptr;
+}
+
+void HandleTable::Reclaim(u32 slot_index) {
+    Slot& slot = m_slots[slot_index];
+    delete std::exchange(slot.file, nullptr);
+
+    u64 head = m_free_head.load(std::memory_order_relaxed);
+    do {
+        slot.next_free.store(static_cast<u32>(head), std::memory_order_relaxed);
+    } while (!m_free_head.compare_exchange_weak(
+        head, ((head >> 32) + 1) << 32 | static_cast<u64>(slot_index + 1),
+        std::memory_order_release, std::memory_order_relaxed));
 }
 
 } // namespace Core::FileSys
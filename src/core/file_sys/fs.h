@@ -3,12 +3,17 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 #include <tsl/robin_map.h>
 #include "common/io_file.h"
+#include "core/file_sys/pfs_image.h"
 
 namespace Core::FileSys {
 
@@ -23,6 +28,7 @@ public:
         std::filesystem::path host_path;
         std::string mount; // e.g /app0/
         bool read_only;
+        std::shared_ptr<PfsImage> pfs; // Set when the mount is served from a package.
     };
 
     explicit MntPoints() = default;
@@ -30,12 +36,21 @@ public:
 
     void Mount(const std::filesystem::path& host_folder, const std::string& guest_folder,
                bool read_only = false);
+    void Mount(std::shared_ptr<PfsImage> pfs, const std::string& guest_folder);
     void Unmount(const std::filesystem::path& host_folder, const std::string& guest_folder);
     void UnmountAll();
 
     std::filesystem::path GetHostPath(std::string_view guest_directory,
                                       bool* is_read_only = nullptr);
 
+    /// Returns the package backing the guest path, or nullptr for host backed mounts. On success
+    /// rel_path receives the path inside the package.
+    std::shared_ptr<PfsImage> GetPfsImage(std::string_view guest_path,
+                                          std::string* rel_path = nullptr);
+
+    /// Forgets the cached directory listings affected by a change of the host path.
+    void InvalidateHostPath(const std::filesystem::path& host_path);
+
     const MntPair* GetMount(const std::string& guest_path) {
         std::scoped_lock lock{m_mutex};
         const auto it = std::ranges::find_if(
@@ -44,10 +59,24 @@ public:
     }
 
 private:
+    /// Entries of a host directory keyed by their lowercase name.
+    struct DirIndex {
+        tsl::robin_map<std::string, std::string> entries;
+        std::filesystem::file_time_type last_write;
+        std::filesystem::file_time_type scan_time; ///< Time of the listing, on the same clock
+    };
+
+    /// Coarsest modification time resolution of the host filesystems we expect (FAT).
+    static constexpr std::chrono::seconds MtimeGranularity{2};
+
+    /// Returns the host name of the entry matching lower_name in dir, or nullptr.
+    const std::string* FindInIndex(const std::filesystem::path& dir,
+                                   const std::string& lower_name);
+
     std::vector<MntPair> m_mnt_pairs;
-    std::vector<std::filesystem::path> path_parts;
-    tsl::robin_map<std::filesystem::path, std::filesystem::path> path_cache;
+    tsl::robin_map<std::filesystem::path, DirIndex> dir_index;
     std::mutex m_mutex;
+    std::mutex index_mutex;
 };
 
 struct DirEntry {
@@ -64,21 +93,110 @@ struct File {
     std::vector<DirEntry> dirents;
     u32 dirents_index;
     std::mutex m_mutex;
+    std::shared_ptr<PfsImage> pfs; // Set when the file is read from a mounted package.
+    PfsImage::Entry pfs_entry;
+    u64 pfs_offset;
+};
+
+class HandleTable;
+
+/**
+ * Counted reference to an open file. The file stays alive while any reference to it exists, even
+ * if its descriptor is closed concurrently.
+ */
+class FileRef {
+public:
+    FileRef() = default;
+    ~FileRef();
+
+    FileRef(const FileRef& other);
+    FileRef& operator=(const FileRef& other);
+    FileRef(FileRef&& other) noexcept;
+    FileRef& operator=(FileRef&& other) noexcept;
+
+    File* get() const noexcept {
+        return file;
+    }
+
+    File* operator->() const noexcept {
+        return file;
+    }
+
+    File& operator*() const noexcept {
+        return *file;
+    }
+
+    explicit operator bool() const noexcept {
+        return file != nullptr;
+    }
+
+    friend bool operator==(const FileRef& ref, std::nullptr_t) noexcept {
+        return ref.file == nullptr;
+    }
+
+private:
+    friend class HandleTable;
+
+    FileRef(HandleTable* table_, u32 slot_, File* file_) noexcept
+        : table{table_}, slot{slot_}, file{file_} {}
+
+    void Reset() noexcept;
+
+    HandleTable* table{};
+    u32 slot{};
+    File* file{};
 };
 
+/**
+ * Fixed capacity table of open files. Lookups by descriptor are lock-free, free slots are kept in
+ * a lock-free stack whose head carries a generation counter to rule out ABA races between
+ * concurrent opens and closes. Each slot counts the references handed out to its file, a closed
+ * file is destroyed and its slot recycled only once the last reference is dropped. Files are
+ * additionally indexed by host path.
+ */
 class HandleTable {
 public:
-    HandleTable() = default;
-    virtual ~HandleTable() = default;
+    static constexpr int MaxHandles = 8192;
+
+    HandleTable();
+    virtual ~HandleTable();
 
+    /// Allocates a descriptor for a new file, returns -1 when the table is full.
     int CreateHandle();
     void DeleteHandle(int d);
-    File* GetFile(int d);
-    File* GetFile(const std::filesystem::path& host_name);
+    FileRef GetFile(int d);
+    FileRef GetFile(const std::filesystem::path& host_name);
+
+    /// Sets the host path of an open file and indexes the file by it.
+    void SetHostName(int d, std::filesystem::path host_name);
 
 private:
-    std::vector<File*> m_files;
-    std::mutex m_mutex;
+    friend class FileRef;
+
+    /// Lowest bit of the slot state, set while the descriptor is open.
+    static constexpr u64 SlotOpen = 1;
+    /// Increment of the slot state for every reference to its file.
+    static constexpr u64 SlotRef = 2;
+
+    struct Slot {
+        std::atomic<u64> state{};     ///< Reference count above the open bit
+        File* file{};                 ///< Only written while the slot is unreferenced
+        std::atomic<u32> next_free{}; ///< One based index of the next free slot, 0 ends the list
+    };
+
+    /// Takes a reference to the file of a slot if its descriptor is open.
+    FileRef Acquire(u32 slot_index);
+
+    /// Drops a reference, destroying the file once it is closed and unreferenced.
+    void Release(u32 slot_index);
+
+    /// Destroys the file of a closed slot and returns the slot to the free stack.
+    void Reclaim(u32 slot_index);
+
+    std::array<Slot, MaxHandles> m_slots;
+    std::atomic<u64> m_free_head; ///< Generation in the high word, one based slot index below
+    tsl::robin_map<std::filesystem::path, std::vector<int>> m_path_index;
+    std::mutex m_mutex; ///< Protects the path index
 };
 
 } // namespace Core::FileSys
@@ -0,0 +1,169 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include "common/alignment.h"
+#include "common/logging/log.h"
+#include "common/path_util.h"
+#include "common/string_util.h"
+#include "core/file_format/pfs.h"
+#include "core/file_sys/pfs_image.h"
+
+namespace Core::FileSys {
+
+std::shared_ptr<PfsImage> PfsImage::Open(const std::filesystem::path& pkg_path,
+                                         std::string& failreason) {
+    std::shared_ptr<PfsImage> image{new PfsImage};
+    PKG& pkg = image->pkg;
+    if (!pkg.Open(pkg_path, failreason)) {
+        return nullptr;
+    }
+
+    // Parsing the package writes sce_sys and the (empty) directory tree, the file data stays in
+    // the package.
+    image->meta_dir = Common::FS::GetUserPath(Common::FS::PathType::PkgMountDir) /
+                      std::string(pkg.GetTitleID());
+    std::filesystem::create_directories(image->meta_dir);
+    if (!pkg.Extract(pkg_path, image->meta_dir, failreason)) {
+        return nullptr;
+    }
+
+    image->entries.emplace("", Entry{0, true, 0});
+    image->directories.emplace("", Directory{Entry{0, true, 0}, {}});
+    for (const auto& table : pkg.fsTable) {
+        if (table.type != PFS_FILE && table.type != PFS_DIR) {
+            continue;
+        }
+        const bool is_directory = table.type == PFS_DIR;
+        const auto rel_path = pkg.extractPaths[table.inode].lexically_relative(image->meta_dir);
+        const auto key = NormalizePath(rel_path.generic_string());
+        const Entry entry{table.inode, is_directory,
+                          is_directory ? 0 : static_cast<u64>(pkg.iNodeBuf[table.inode].Size)};
+        image->entries.emplace(key, entry);
+        if (is_directory) {
+            image->directories[key].entry = entry;
+        }
+        const auto parent = NormalizePath(rel_path.parent_path().generic_string());
+        image->directories[parent].children.emplace_back(table.name, is_directory);
+    }
+
+    image->pkg_file.Open(pkg_path, Common::FS::FileAccessMode::Read);
+    if (!image->pkg_file.IsOpen()) {
+        failreason = "Failed to open package";
+        return nullptr;
+    }
+    image->decryptor = std::make_unique<Crypto::PfsDecryptor>(pkg.dataKey, pkg.tweakKey);
+    LOG_INFO(Loader, "Mounted package {} with {} entries", fmt::UTF(pkg_path.u8string()),
+             image->entries.size());
+    return image;
+}
+
+const PfsImage::Entry* PfsImage::Find(std::string_view rel_path) const {
+    const auto it = entries.find(NormalizePath(rel_path));
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+std::vector<PfsImage::DirectoryEntry> PfsImage::ListDirectory(std::string_view rel_path) const {
+    const auto it = directories.find(NormalizePath(rel_path));
+    return it == directories.end() ? std::vector<DirectoryEntry>{} : it->second.children;
+}
+
+size_t PfsImage::Read(const Entry& entry, u64 offset, std::span<u8> out) {
+    if (entry.is_directory || offset >= entry.size) {
+        return 0;
+    }
+    const u64 first_block = pkg.iNodeBuf[entry.inode].loc;
+    const size_t size = std::min<u64>(out.size(), entry.size - offset);
+    size_t done = 0;
+    while (done < size) {
+        const u64 position = offset + done;
+        const u64 block_offset = position % BlockSize;
+        const size_t copy_size = std::min<u64>(BlockSize - block_offset, size - done);
+        const Block block = GetBlock(first_block + position / BlockSize);
+        std::memcpy(out.data() + done, block->data() + block_offset, copy_size);
+        done += copy_size;
+    }
+    return size;
+}
+
+bool PfsImage::ExtractFile(std::string_view rel_path, const std::filesystem::path& host_path) {
+    const Entry* entry = Find(rel_path);
+    if (!entry || entry->is_directory) {
+        return false;
+    }
+    std::error_code ec;
+    if (std::filesystem::file_size(host_path, ec) == entry->size && !ec) {
+        return true;
+    }
+    Common::FS::IOFile out(host_path, Common::FS::FileAccessMode::Write);
+    if (!out.IsOpen()) {
+        return false;
+    }
+    std::vector<u8> buffer(BlockSize * 16);
+    for (u64 offset = 0; offset < entry->size; offset += buffer.size()) {
+        const size_t read = Read(*entry, offset, buffer);
+        out.WriteRaw<u8>(buffer.data(), read);
+    }
+    return true;
+}
+
+PfsImage::Block PfsImage::GetBlock(u64 block) {
+    {
+        std::scoped_lock lock{cache_mutex};
+        if (const auto it = cached_blocks.find(block); it != cached_blocks.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            return it->second->second;
+        }
+    }
+
+    const u64 data_begin = pkg.pfsc_offset + pkg.sectorMap[block];
+    const u64 data_end = pkg.pfsc_offset + pkg.sectorMap[block + 1];
+    const u64 read_begin = Common::AlignDown(data_begin, Crypto::PfsSectorSize);
+    const u64 read_end = Common::AlignUp(data_end, Crypto::PfsSectorSize);
+    const u64 size = data_end - data_begin;
+
+    std::vector<u8> buffer(read_end - read_begin);
+    {
+        std::scoped_lock lock{file_mutex};
+        pkg_file.Seek(pkg.pkgheader.pfs_image_offset + read_begin);
+        pkg_file.ReadRaw<u8>(buffer.data(), buffer.size());
+        decryptor->Decrypt(buffer, buffer, read_begin / Crypto::PfsSectorSize);
+    }
+
+    auto data = std::make_shared<std::vector<char>>(BlockSize);
+    const std::span compressed{
+        reinterpret_cast<const char*>(buffer.data()) + (data_begin - read_begin), size};
+    if (size == BlockSize) { // Uncompressed data
+        std::memcpy(data->data(), compressed.data(), BlockSize);
+    } else if (size < BlockSize) { // Compressed data
+        DecompressPFSC(compressed, *data);
+    }
+
+    std::scoped_lock lock{cache_mutex};
+    if (const auto it = cached_blocks.find(block); it != cached_blocks.end()) {
+        // Another thread decoded the same block in the meantime.
+        return it->second->second;
+    }
+    lru.emplace_front(block, std::move(data));
+    cached_blocks.emplace(block, lru.begin());
+    if (lru.size() > BlockCacheSize) {
+        cached_blocks.erase(lru.back().first);
+        lru.pop_back();
+    }
+    return lru.front().second;
+}
+
+std::string PfsImage::NormalizePath(std::string_view rel_path) {
+    while (rel_path.starts_with('/')) {
+        rel_path.remove_prefix(1);
+    }
+    while (rel_path.ends_with('/')) {
+        rel_path.remove_suffix(1);
+    }
+    if (rel_path == ".") {
+        return {};
+    }
+    return Common::ToLower(rel_path);
+}
+
+} // namespace Core::FileSys
@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include <tsl/robin_map.h>
+
+#include "common/io_file.h"
+#include "common/types.h"
+#include "core/file_format/pkg.h"
+
+namespace Core::FileSys {
+
+/**
+ * Read-only view of the PFS image of a package. Files are served straight from the package,
+ * their PFSC blocks are decrypted and inflated on demand and kept in a small LRU cache.
+ * Only the package metadata (sce_sys) and the directory tree are written to the host.
+ */
+class PfsImage {
+public:
+    static constexpr u64 BlockSize = 0x10000;
+    static constexpr size_t BlockCacheSize = 64;
+
+    struct Entry {
+        u32 inode;
+        bool is_directory;
+        u64 size;
+    };
+
+    struct DirectoryEntry {
+        std::string name;
+        bool is_directory;
+    };
+
+    /// Opens the package and indexes its file system. Returns nullptr on failure.
+    static std::shared_ptr<PfsImage> Open(const std::filesystem::path& pkg_path,
+                                          std::string& failreason);
+
+    PfsImage(const PfsImage&) = delete;
+    PfsImage& operator=(const PfsImage&) = delete;
+
+    /// Returns the host directory holding the package metadata and directory tree.
+    [[nodiscard]] const std::filesystem::path& GetMetaDir() const noexcept {
+        return meta_dir;
+    }
+
+    /// Looks up a path relative to the image root, ignoring case. Returns nullptr if missing.
+    [[nodiscard]] const Entry* Find(std::string_view rel_path) const;
+
+    /// Lists the contents of a directory relative to the image root.
+    [[nodiscard]] std::vector<DirectoryEntry> ListDirectory(std::string_view rel_path) const;
+
+    /// Reads up to out.size() bytes of a file starting at offset. Returns the number of bytes read.
+    size_t Read(const Entry& entry, u64 offset, std::span<u8> out);
+
+    /// Copies a file out of the image to the host. Files of matching size are left untouched.
+    bool ExtractFile(std::string_view rel_path, const std::filesystem::path& host_path);
+
+private:
+    struct Directory {
+        Entry entry;
+        std::vector<DirectoryEntry> children;
+    };
+
+    using Block = std::shared_ptr<const std::vector<char>>;
+
+    PfsImage() = default;
+
+    Block GetBlock(u64 block);
+
+    static std::string NormalizePath(std::string_view rel_path);
+
+private:
+    PKG pkg;
+    std::filesystem::path meta_dir;
+    tsl::robin_map<std::string, Entry> entries;
+    tsl::robin_map<std::string, Directory> directories;
+
+    std::mutex file_mutex;
+    Common::FS::IOFile pkg_file;
+    std::unique_ptr<Crypto::PfsDecryptor> decryptor;
+
+    std::mutex cache_mutex;
+    std::list<std::pair<u64, Block>> lru;
+    tsl::robin_map<u64, std::list<std::pair<u64, Block>>::iterator> cached_blocks;
+};
+
+} // namespace Core::FileSys
@@ -293,10 +293,9 @@ static constexpr std::array CtxInitSequence400{
 static_assert(CtxInitSequence400.size() == 0x61);
 // clang-format on
 
-// In case if `submitDone` is issued we need to block submissions until GPU idle
-static u32 submission_lock{};
-std::condition_variable cv_lock{};
-static std::mutex m_submission{};
+// Without command buffer copies the guest buffers of a finished frame are parsed in place, so
+// the next submission waits for the GPU to go idle before the guest may have recycled them.
+static std::atomic<bool> wait_idle_on_submit{};
 static u64 frames_submitted{};      // frame counter
 static bool send_init_packet{true}; // initialize HW state before first game's submit in a frame
 static int sdk_version{0};
@@ -309,16 +308,11 @@ struct AscQueueInfo {
 static Common::SlotVector<AscQueueInfo> asc_queues{};
 static constexpr VAddr tessellation_factors_ring_addr = Core::SYSTEM_RESERVED_MAX - 0xFFFFFFF;
 
-static void ResetSubmissionLock(Platform::InterruptId irq) {
-    std::unique_lock lock{m_submission};
-    submission_lock = 0;
-    cv_lock.notify_all();
-}
-
-static void WaitGpuIdle() {
-    HLE_TRACE;
-    std::unique_lock lock{m_submission};
-    cv_lock.wait(lock, [] { return submission_lock == 0; });
+static void WaitGpuIdleIfPending() {
+    if (wait_idle_on_submit.exchange(false)) {
+        HLE_TRACE;
+        liverpool->WaitGpuIdle();
+    }
 }
 
 // Write a special ending NOP packet with N DWs data block
@@ -372,7 +366,10 @@ s32 PS4_SYSV_ABI sceGnmAddEqEvent(SceKernelEqueue eq, u64 id, void* udata) {
 
 int PS4_SYSV_ABI sceGnmAreSubmitsAllowed() {
     LOG_TRACE(Lib_GnmDriver, "called");
-    return submission_lock == 0;
+    if (wait_idle_on_submit && !liverpool->IsGpuIdle()) {
+        return false;
+    }
+    return liverpool->AreSubmitsAllowed();
 }
 
 int PS4_SYSV_ABI sceGnmBeginWorkload() {
@@ -492,7 +489,7 @@ void PS4_SYSV_ABI sceGnmDingDong(u32 gnm_vqid, u32 next_offs_dw) {
         return;
     }
 
-    WaitGpuIdle();
+    WaitGpuIdleIfPending();
 
     if (DebugState.ShouldPauseInSubmit()) {
         DebugState.PauseGuestThreads();
@@ -2101,7 +2098,7 @@ s32 PS4_SYSV_ABI sceGnmSubmitCommandBuffers(u32 count, const u32* dcb_gpu_addrs[
         }
     }
 
-    WaitGpuIdle();
+    WaitGpuIdleIfPending();
 
     if (DebugState.ShouldPauseInSubmit()) {
         DebugState.PauseGuestThreads();
@@ -2167,11 +2164,10 @@ int PS4_SYSV_ABI sceGnmSubmitCommandBuffersForWorkload() {
 
 int PS4_SYSV_ABI sceGnmSubmitDone() {
     LOG_DEBUG(Lib_GnmDriver, "called");
-    WaitGpuIdle();
-    if (!liverpool->IsGpuIdle()) {
-        submission_lock = true;
-    }
     liverpool->SubmitDone();
+    if (!Config::copyGPUCmdBuffers()) {
+        wait_idle_on_submit = true;
+    }
     send_init_packet = true;
     ++frames_submitted;
     DebugState.IncGnmFrameNum();
@@ -2684,9 +2680,6 @@ void RegisterlibSceGnmDriver(Core::Loader::SymbolsResolver* sym) {
         liverpool->reserveCopyBufferSpace();
     }
 
-    Platform::IrqC::Instance()->Register(Platform::InterruptId::GpuIdle, ResetSubmissionLock,
-                                         nullptr);
-
     LIB_FUNCTION("b0xyllnVY-I", "libSceGnmDriver", 1, "libSceGnmDriver", 1, 1, sceGnmAddEqEvent);
     LIB_FUNCTION("b08AgtPlHPg", "libSceGnmDriver", 1, "libSceGnmDriver", 1, 1,
                  sceGnmAreSubmitsAllowed);
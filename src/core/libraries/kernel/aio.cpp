@@ -0,0 +1,273 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <boost/container/small_vector.hpp>
+#include "common/logging/log.h"
+#include "common/singleton.h"
+#include "core/file_sys/aio_engine.h"
+#include "core/file_sys/fs.h"
+#include "core/libraries/error_codes.h"
+#include "core/libraries/kernel/aio.h"
+#include "core/libraries/libs.h"
+
+namespace Libraries::Kernel {
+
+using Core::FileSys::AioEngine;
+using Core::FileSys::AioState;
+
+static_assert(sizeof(OrbisKernelAioResult) == sizeof(Core::FileSys::AioResult));
+
+namespace {
+
+std::atomic_bool engine_used{};
+
+AioEngine* GetEngine() {
+    engine_used.store(true, std::memory_order_relaxed);
+    return Common::Singleton<AioEngine>::Instance();
+}
+
+Core::FileSys::AioPriority ToPriority(s32 prio) {
+    switch (prio) {
+    case ORBIS_KERNEL_AIO_PRIORITY_HIGH:
+        return Core::FileSys::AioPriority::High;
+    case ORBIS_KERNEL_AIO_PRIORITY_MID:
+        return Core::FileSys::AioPriority::Mid;
+    default:
+        return Core::FileSys::AioPriority::Low;
+    }
+}
+
+/// Resolves the guest requests into engine requests, fails when a descriptor is invalid.
+s32 ResolveRequests(const OrbisKernelAioRWRequest req[], s32 size,
+                    boost::container::small_vector<Core::FileSys::AioRequest, 16>& out) {
+    if (req == nullptr || size <= 0 || size > ORBIS_KERNEL_AIO_MAX_REQUESTS) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
+    for (s32 i = 0; i < size; ++i) {
+        if (req[i].fd < 3 || req[i].offset < 0 || req[i].nbyte < 0) {
+            return ORBIS_KERNEL_ERROR_EINVAL;
+        }
+        auto file = h->GetFile(req[i].fd);
+        if (file == nullptr || file->is_directory) {
+            return ORBIS_KERNEL_ERROR_EBADF;
+        }
+        out.push_back({
+            .file = std::move(file),
+            .buf = req[i].buf,
+            .size = static_cast<u64>(req[i].nbyte),
+            .offset = req[i].offset,
+            .result = reinterpret_cast<Core::FileSys::AioResult*>(req[i].result),
+        });
+    }
+    return ORBIS_OK;
+}
+
+s32 SubmitRequests(const OrbisKernelAioRWRequest req[], s32 size, s32 prio,
+                   OrbisKernelAioSubmitId* id, bool is_write) {
+    if (id == nullptr) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    boost::container::small_vector<Core::FileSys::AioRequest, 16> requests;
+    if (const s32 result = ResolveRequests(req, size, requests); result != ORBIS_OK) {
+        return result;
+    }
+    *id = GetEngine()->Submit(requests, is_write, ToPriority(prio));
+    return ORBIS_OK;
+}
+
+s32 SubmitRequestsMultiple(const OrbisKernelAioRWRequest req[], s32 size, s32 prio,
+                           OrbisKernelAioSubmitId id[], bool is_write) {
+    if (id == nullptr) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    boost::container::small_vector<Core::FileSys::AioRequest, 16> requests;
+    if (const s32 result = ResolveRequests(req, size, requests); result != ORBIS_OK) {
+        return result;
+    }
+    for (s32 i = 0; i < size; ++i) {
+        id[i] = GetEngine()->Submit({&requests[i], 1}, is_write, ToPriority(prio));
+    }
+    return ORBIS_OK;
+}
+
+s32 WaitRequests(const OrbisKernelAioSubmitId id[], s32 num, s32 state[], bool wait_all,
+                 u32* usec) {
+    if (id == nullptr || state == nullptr || num <= 0) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    std::optional<AioEngine::Clock::time_point> deadline;
+    const auto start = AioEngine::Clock::now();
+    if (usec) {
+        deadline = start + std::chrono::microseconds{*usec};
+    }
+    boost::container::small_vector<AioState, 16> states(num);
+    if (!GetEngine()->Wait({id, static_cast<size_t>(num)}, states, wait_all, deadline)) {
+        return ORBIS_KERNEL_ERROR_ESRCH;
+    }
+    const auto is_finished = [](AioState s) {
+        return s == AioState::Completed || s == AioState::Aborted;
+    };
+    std::ranges::transform(states, state, [](AioState s) { return static_cast<s32>(s); });
+    const bool done = wait_all ? std::ranges::all_of(states, is_finished)
+                               : std::ranges::any_of(states, is_finished);
+    if (usec) {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            AioEngine::Clock::now() - start);
+        *usec = static_cast<u32>(std::max<s64>(*usec - elapsed.count(), 0));
+    }
+    return done ? ORBIS_OK : ORBIS_KERNEL_ERROR_ETIMEDOUT;
+}
+
+} // Anonymous namespace
+
+s32 PS4_SYSV_ABI sceKernelAioInitializeParam(OrbisKernelAioParam* param) {
+    if (param == nullptr) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    for (auto* sched : {&param->low, &param->mid, &param->high}) {
+        *sched = {
+            .schedulingWindowSize = 0x20,
+            .delayedCountLimit = 0x20,
+            .enableSplit = 1,
+            .splitSize = 0x10000,
+            .splitChunkSize = 0x10000,
+        };
+    }
+    return ORBIS_OK;
+}
+
+s32 PS4_SYSV_ABI sceKernelAioSetParam(OrbisKernelAioParam* param) {
+    // Scheduling windows and request splitting are left to the host.
+    return param == nullptr ? ORBIS_KERNEL_ERROR_EINVAL : ORBIS_OK;
+}
+
+s32 PS4_SYSV_ABI sceKernelAioSubmitReadRequests(OrbisKernelAioRWRequest req[], s32 size, s32 prio,
+                                                OrbisKernelAioSubmitId* id) {
+    return SubmitRequests(req, size, prio, id, false);
+}
+
+s32 PS4_SYSV_ABI sceKernelAioSubmitReadRequestsMultiple(OrbisKernelAioRWRequest req[], s32 size,
+                                                        s32 prio, OrbisKernelAioSubmitId id[]) {
+    return SubmitRequestsMultiple(req, size, prio, id, false);
+}
+
+s32 PS4_SYSV_ABI sceKernelAioSubmitWriteRequests(OrbisKernelAioRWRequest req[], s32 size,
+                                                 s32 prio, OrbisKernelAioSubmitId* id) {
+    return SubmitRequests(req, size, prio, id, true);
+}
+
+s32 PS4_SYSV_ABI sceKernelAioSubmitWriteRequestsMultiple(OrbisKernelAioRWRequest req[], s32 size,
+                                                         s32 prio, OrbisKernelAioSubmitId id[]) {
+    return SubmitRequestsMultiple(req, size, prio, id, true);
+}
+
+s32 PS4_SYSV_ABI sceKernelAioPollRequest(OrbisKernelAioSubmitId id, s32* state) {
+    if (state == nullptr) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    const auto result = GetEngine()->Poll(id);
+    if (!result) {
+        return ORBIS_KERNEL_ERROR_ESRCH;
+    }
+    *state = static_cast<s32>(*result);
+    return ORBIS_OK;
+}
+
+s32 PS4_SYSV_ABI sceKernelAioPollRequests(OrbisKernelAioSubmitId id[], s32 num, s32 state[]) {
+    if (id == nullptr || state == nullptr || num <= 0) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    for (s32 i = 0; i < num; ++i) {
+        if (const s32 result = sceKernelAioPollRequest(id[i], &state[i]); result != ORBIS_OK) {
+            return result;
+        }
+    }
+    return ORBIS_OK;
+}
+
+s32 PS4_SYSV_ABI sceKernelAioWaitRequest(OrbisKernelAioSubmitId id, s32* state, u32* usec) {
+    return WaitRequests(&id, 1, state, true, usec);
+}
+
+s32 PS4_SYSV_ABI sceKernelAioWaitRequests(OrbisKernelAioSubmitId id[], s32 num, s32 state[],
+                                          u32 mode, u32* usec) {
+    if (mode != ORBIS_KERNEL_AIO_WAIT_AND && mode != ORBIS_KERNEL_AIO_WAIT_OR) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    return WaitRequests(id, num, state, mode == ORBIS_KERNEL_AIO_WAIT_AND, usec);
+}
+
+s32 PS4_SYSV_ABI sceKernelAioCancelRequest(OrbisKernelAioSubmitId id, s32* state) {
+    if (state == nullptr) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    const auto result = GetEngine()->Cancel(id);
+    if (!result) {
+        return ORBIS_KERNEL_ERROR_ESRCH;
+    }
+    *state = static_cast<s32>(*result);
+    return ORBIS_OK;
+}
+
+s32 PS4_SYSV_ABI sceKernelAioCancelRequests(OrbisKernelAioSubmitId id[], s32 num, s32 state[]) {
+    if (id == nullptr || state == nullptr || num <= 0) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    for (s32 i = 0; i < num; ++i) {
+        if (const s32 result = sceKernelAioCancelRequest(id[i], &state[i]); result != ORBIS_OK) {
+            return result;
+        }
+    }
+    return ORBIS_OK;
+}
+
+s32 PS4_SYSV_ABI sceKernelAioDeleteRequest(OrbisKernelAioSubmitId id, s32* ret) {
+    if (ret == nullptr) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    *ret = GetEngine()->Delete(id) ? ORBIS_OK : ORBIS_KERNEL_ERROR_ESRCH;
+    return ORBIS_OK;
+}
+
+s32 PS4_SYSV_ABI sceKernelAioDeleteRequests(OrbisKernelAioSubmitId id[], s32 num, s32 ret[]) {
+    if (id == nullptr || ret == nullptr || num <= 0) {
+        return ORBIS_KERNEL_ERROR_EINVAL;
+    }
+    for (s32 i = 0; i < num; ++i) {
+        sceKernelAioDeleteRequest(id[i], &ret[i]);
+    }
+    return ORBIS_OK;
+}
+
+void ShutdownKernelAio() {
+    if (engine_used.load(std::memory_order_relaxed)) {
+        GetEngine()->Shutdown();
+    }
+}
+
+void RegisterKernelAio(Core::Loader::SymbolsResolver* sym) {
+    LIB_FUNCTION("fR521KIGgb8", "libkernel", 1, "libkernel", 1, 1, sceKernelAioCancelRequest);
+    LIB_FUNCTION("3Lca1XBrQdY", "libkernel", 1, "libkernel", 1, 1, sceKernelAioCancelRequests);
+    LIB_FUNCTION("5TgME6AYty4", "libkernel", 1, "libkernel", 1, 1, sceKernelAioDeleteRequest);
+    LIB_FUNCTION("Ft3EtsZzAoY", "libkernel", 1, "libkernel", 1, 1, sceKernelAioDeleteRequests);
+    LIB_FUNCTION("nu4a0-arQis", "libkernel", 1, "libkernel", 1, 1, sceKernelAioInitializeParam);
+    LIB_FUNCTION("2pOuoWoCxdk", "libkernel", 1, "libkernel", 1, 1, sceKernelAioPollRequest);
+    LIB_FUNCTION("o7O4z3jwKzo", "libkernel", 1, "libkernel", 1, 1, sceKernelAioPollRequests);
+    LIB_FUNCTION("9WK-vhNXimw", "libkernel", 1, "libkernel", 1, 1, sceKernelAioSetParam);
+    LIB_FUNCTION("HgX7+AORI58", "libkernel", 1, "libkernel", 1, 1,
+                 sceKernelAioSubmitReadRequests);
+    LIB_FUNCTION("lXT0m3P-vs4", "libkernel", 1, "libkernel", 1, 1,
+                 sceKernelAioSubmitReadRequestsMultiple);
+    LIB_FUNCTION("XQ8C8y+de+E", "libkernel", 1, "libkernel", 1, 1,
+                 sceKernelAioSubmitWriteRequests);
+    LIB_FUNCTION("xT3Cpz0yh6Y", "libkernel", 1, "libkernel", 1, 1,
+                 sceKernelAioSubmitWriteRequestsMultiple);
+    LIB_FUNCTION("KOF-oJbQVvc", "libkernel", 1, "libkernel", 1, 1, sceKernelAioWaitRequest);
+    LIB_FUNCTION("lgK+oIWkJyA", "libkernel", 1, "libkernel", 1, 1, sceKernelAioWaitRequests);
+}
+
+} // namespace Libraries::Kernel
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "common/types.h"
+
+namespace Core::Loader {
+class SymbolsResolver;
+}
+
+namespace Libraries::Kernel {
+
+constexpr s32 ORBIS_KERNEL_AIO_STATE_SUBMITTED = 1;
+constexpr s32 ORBIS_KERNEL_AIO_STATE_PROCESSING = 2;
+constexpr s32 ORBIS_KERNEL_AIO_STATE_COMPLETED = 3;
+constexpr s32 ORBIS_KERNEL_AIO_STATE_ABORTED = 4;
+
+constexpr s32 ORBIS_KERNEL_AIO_PRIORITY_LOW = 1;
+constexpr s32 ORBIS_KERNEL_AIO_PRIORITY_MID = 2;
+constexpr s32 ORBIS_KERNEL_AIO_PRIORITY_HIGH = 3;
+
+constexpr u32 ORBIS_KERNEL_AIO_WAIT_AND = 0x01;
+constexpr u32 ORBIS_KERNEL_AIO_WAIT_OR = 0x02;
+
+constexpr s32 ORBIS_KERNEL_AIO_MAX_REQUESTS = 128;
+
+using OrbisKernelAioSubmitId = s32;
+
+struct OrbisKernelAioResult {
+    s64 returnValue;
+    u32 state;
+};
+
+struct OrbisKernelAioRWRequest {
+    s64 offset;
+    s64 nbyte;
+    void* buf;
+    OrbisKernelAioResult* result;
+    s32 fd;
+};
+
+struct OrbisKernelAioSchedulingParam {
+    s32 schedulingWindowSize;
+    s32 delayedCountLimit;
+    u32 enableSplit;
+    u32 splitSize;
+    u32 splitChunkSize;
+};
+
+struct OrbisKernelAioParam {
+    OrbisKernelAioSchedulingParam low;
+    OrbisKernelAioSchedulingParam mid;
+    OrbisKernelAioSchedulingParam high;
+};
+
+/// Stops the asynchronous I/O threads, must run before static destruction.
+void ShutdownKernelAio();
+
+void RegisterKernelAio(Core::Loader::SymbolsResolver* sym);
+
+} // namespace Libraries::Kernel
@@ -1,6 +1,7 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <boost/container/small_vector.hpp>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
@@ -24,6 +25,41 @@ std::vector<Core::FileSys::DirEntry> GetDirectoryEntries(const std::filesystem::
     return files;
 }
 
+static int OpenPfsFile(std::shared_ptr<Core::FileSys::PfsImage> pfs, std::string_view rel_path,
+                       const char* path, int flags) {
+    if ((flags & 0x3) != ORBIS_KERNEL_O_RDONLY || (flags & ORBIS_KERNEL_O_CREAT) != 0) {
+        return SCE_KERNEL_ERROR_EROFS;
+    }
+    const auto* entry = pfs->Find(rel_path);
+    if (!entry) {
+        return ORBIS_KERNEL_ERROR_ENOENT;
+    }
+    const bool directory = (flags & ORBIS_KERNEL_O_DIRECTORY) != 0;
+    if (directory && !entry->is_directory) {
+        return ORBIS_KERNEL_ERROR_ENOTDIR;
+    }
+
+    auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
+    const int handle = h->CreateHandle();
+    if (handle < 0) {
+        return ORBIS_KERNEL_ERROR_EMFILE;
+    }
+    auto file = h->GetFile(handle);
+    file->m_guest_name = path;
+    file->is_directory = entry->is_directory;
+    file->pfs_entry = *entry;
+    file->pfs_offset = 0;
+    if (entry->is_directory) {
+        for (const auto& child : pfs->ListDirectory(rel_path)) {
+            file->dirents.emplace_back(child.name, !child.is_directory);
+        }
+        file->dirents_index = 0;
+    }
+    file->pfs = std::move(pfs);
+    file->is_opened = true;
+    return handle;
+}
+
 int PS4_SYSV_ABI sceKernelOpen(const char* path, int flags, u16 mode) {
     LOG_INFO(Kernel_Fs, "path = {} flags = {:#x} mode = {}", path, flags, mode);
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
@@ -56,13 +92,22 @@ int PS4_SYSV_ABI sceKernelOpen(const char* path, int flags, u16 mode) {
     if (std::string_view{path} == "/dev/urandom") {
         return 2003;
     }
-    u32 handle = h->CreateHandle();
-    auto* file = h->GetFile(handle);
+    std::string rel_path;
+    if (auto pfs = mnt->GetPfsImage(path, &rel_path)) {
+        return OpenPfsFile(std::move(pfs), rel_path, path, flags);
+    }
+    const int handle = h->CreateHandle();
+    if (handle < 0) {
+        return ORBIS_KERNEL_ERROR_EMFILE;
+    }
+    auto file = h->GetFile(handle);
     if (directory) {
         file->is_directory = true;
         file->m_guest_name = path;
-        file->m_host_name = mnt->GetHostPath(file->m_guest_name);
+        h->SetHostName(handle, mnt->GetHostPath(file->m_guest_name));
         if (!std::filesystem::is_directory(file->m_host_name)) { // directory doesn't exist
+            // The path may have been resolved through a stale listing.
+            mnt->InvalidateHostPath(file->m_host_name);
             h->DeleteHandle(handle);
             return ORBIS_KERNEL_ERROR_ENOTDIR;
         } else {
@@ -75,7 +120,7 @@ int PS4_SYSV_ABI sceKernelOpen(const char* path, int flags, u16 mode) {
         }
     } else {
         file->m_guest_name = path;
-        file->m_host_name = mnt->GetHostPath(file->m_guest_name);
+        h->SetHostName(handle, mnt->GetHostPath(file->m_guest_name));
         int e = 0;
         if (read) {
             e = file->f.Open(file->m_host_name, Common::FS::FileAccessMode::Read);
@@ -95,9 +140,14 @@ int PS4_SYSV_ABI sceKernelOpen(const char* path, int flags, u16 mode) {
             UNREACHABLE();
         }
         if (e != 0) {
+            // The path may have been resolved through a stale listing.
+            mnt->InvalidateHostPath(file->m_host_name);
             h->DeleteHandle(handle);
             return ErrnoToSceKernelError(e);
         }
+        if (create || truncate) {
+            mnt->InvalidateHostPath(file->m_host_name);
+        }
     }
     file->is_opened = true;
     return handle;
@@ -131,13 +181,11 @@ int PS4_SYSV_ABI sceKernelClose(int d) {
         return SCE_OK;
     }
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(d);
+    auto file = h->GetFile(d);
     if (file == nullptr) {
         return SCE_KERNEL_ERROR_EBADF;
     }
-    if (!file->is_directory) {
-        file->f.Close();
-    }
+    // The host file is closed along with the last reference, other threads may still use it.
     file->is_opened = false;
     LOG_INFO(Kernel_Fs, "Closing {}", file->m_guest_name);
     h->DeleteHandle(d);
@@ -164,7 +212,7 @@ size_t PS4_SYSV_ABI sceKernelWrite(int d, const void* buf, size_t nbytes) {
         return nbytes;
     }
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(d);
+    auto file = h->GetFile(d);
     if (file == nullptr) {
         return SCE_KERNEL_ERROR_EBADF;
     }
@@ -195,10 +243,11 @@ int PS4_SYSV_ABI sceKernelUnlink(const char* path) {
         return SCE_KERNEL_ERROR_EPERM;
     }
 
-    auto* file = h->GetFile(host_path);
+    auto file = h->GetFile(host_path);
     if (file != nullptr) {
         file->f.Unlink();
     }
+    mnt->InvalidateHostPath(host_path);
 
     LOG_INFO(Kernel_Fs, "Unlinked {}", path);
     return SCE_OK;
@@ -206,18 +255,39 @@ int PS4_SYSV_ABI sceKernelUnlink(const char* path) {
 
 size_t PS4_SYSV_ABI _readv(int d, const SceKernelIovec* iov, int iovcnt) {
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(d);
+    auto file = h->GetFile(d);
     size_t total_read = 0;
     std::scoped_lock lk{file->m_mutex};
+    if (file->pfs) {
+        for (int i = 0; i < iovcnt; i++) {
+            const std::span data{static_cast<u8*>(iov[i].iov_base), iov[i].iov_len};
+            const size_t read = file->pfs->Read(file->pfs_entry, file->pfs_offset, data);
+            file->pfs_offset += read;
+            total_read += read;
+        }
+        return total_read;
+    }
+    if (iovcnt == 1) {
+        return file->f.ReadRaw<u8>(iov[0].iov_base, iov[0].iov_len);
+    }
+    // Read all vectors with a single positional read and move the stream past them.
+    boost::container::small_vector<std::span<u8>, 8> buffers;
     for (int i = 0; i < iovcnt; i++) {
-        total_read += file->f.ReadRaw<u8>(iov[i].iov_base, iov[i].iov_len);
+        buffers.emplace_back(static_cast<u8*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    const s64 pos = file->f.Tell();
+    file->f.Flush();
+    const s64 read = file->f.ReadAtV(buffers, pos);
+    if (read < 0) {
+        return ORBIS_KERNEL_ERROR_EIO;
     }
-    return total_read;
+    file->f.Seek(pos + read);
+    return read;
 }
 
 s64 PS4_SYSV_ABI sceKernelLseek(int d, s64 offset, int whence) {
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(d);
+    auto file = h->GetFile(d);
 
     Common::FS::SeekOrigin origin{};
     if (whence == 0) {
@@ -229,6 +299,19 @@ s64 PS4_SYSV_ABI sceKernelLseek(int d, s64 offset, int whence) {
     }
 
     std::scoped_lock lk{file->m_mutex};
+    if (file->pfs) {
+        s64 base = 0;
+        if (whence == 1) {
+            base = file->pfs_offset;
+        } else if (whence == 2) {
+            base = file->pfs_entry.size;
+        }
+        if (base + offset < 0) {
+            return SCE_KERNEL_ERROR_EINVAL;
+        }
+        file->pfs_offset = base + offset;
+        return file->pfs_offset;
+    }
     if (!file->f.Seek(offset, origin)) {
         LOG_CRITICAL(Kernel_Fs, "sceKernelLseek: failed to seek");
         return SCE_KERNEL_ERROR_EINVAL;
@@ -255,12 +338,18 @@ s64 PS4_SYSV_ABI sceKernelRead(int d, void* buf, size_t nbytes) {
         return nbytes;
     }
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(d);
+    auto file = h->GetFile(d);
     if (file == nullptr) {
         return SCE_KERNEL_ERROR_EBADF;
     }
 
     std::scoped_lock lk{file->m_mutex};
+    if (file->pfs) {
+        const size_t read =
+            file->pfs->Read(file->pfs_entry, file->pfs_offset, {static_cast<u8*>(buf), nbytes});
+        file->pfs_offset += read;
+        return read;
+    }
     return file->f.ReadRaw<u8>(buf, nbytes);
 }
 
@@ -297,6 +386,7 @@ int PS4_SYSV_ABI sceKernelMkdir(const char* path, u16 mode) {
     if (dir_name.empty() || !std::filesystem::create_directory(dir_name, ec)) {
         return SCE_KERNEL_ERROR_EIO;
     }
+    mnt->InvalidateHostPath(dir_name);
 
     if (!std::filesystem::exists(dir_name)) {
         return SCE_KERNEL_ERROR_ENOENT;
@@ -346,6 +436,7 @@ int PS4_SYSV_ABI sceKernelRmdir(const char* path) {
 
     std::error_code ec;
     int result = std::filesystem::remove_all(dir_name, ec);
+    mnt->InvalidateHostPath(dir_name);
 
     if (!ec) {
         LOG_DEBUG(Kernel_Fs, "Removed directory: {}", fmt::UTF(dir_name.u8string()));
@@ -369,9 +460,21 @@ int PS4_SYSV_ABI posix_rmdir(const char* path) {
 int PS4_SYSV_ABI sceKernelStat(const char* path, OrbisKernelStat* sb) {
     LOG_INFO(Kernel_Fs, "(PARTIAL) path = {}", path);
     auto* mnt = Common::Singleton<Core::FileSys::MntPoints>::Instance();
+    std::memset(sb, 0, sizeof(OrbisKernelStat));
+    std::string rel_path;
+    if (const auto pfs = mnt->GetPfsImage(path, &rel_path)) {
+        const auto* entry = pfs->Find(rel_path);
+        if (!entry) {
+            return ORBIS_KERNEL_ERROR_ENOENT;
+        }
+        sb->st_mode = entry->is_directory ? (0000555u | 0040000u) : (0000555u | 0100000u);
+        sb->st_size = entry->size;
+        sb->st_blksize = 512;
+        sb->st_blocks = (sb->st_size + 511) / 512;
+        return ORBIS_OK;
+    }
     bool ro = false;
     const auto path_name = mnt->GetHostPath(path, &ro);
-    std::memset(sb, 0, sizeof(OrbisKernelStat));
     const bool is_dir = std::filesystem::is_directory(path_name);
     const bool is_file = std::filesystem::is_regular_file(path_name);
     if (!is_dir && !is_file) {
@@ -409,6 +512,10 @@ int PS4_SYSV_ABI posix_stat(const char* path, OrbisKernelStat* sb) {
 
 int PS4_SYSV_ABI sceKernelCheckReachability(const char* path) {
     auto* mnt = Common::Singleton<Core::FileSys::MntPoints>::Instance();
+    std::string rel_path;
+    if (const auto pfs = mnt->GetPfsImage(path, &rel_path)) {
+        return pfs->Find(rel_path) ? ORBIS_OK : SCE_KERNEL_ERROR_ENOENT;
+    }
     const auto path_name = mnt->GetHostPath(path);
     if (!std::filesystem::exists(path_name)) {
         return SCE_KERNEL_ERROR_ENOENT;
@@ -425,21 +532,25 @@ s64 PS4_SYSV_ABI sceKernelPread(int d, void* buf, size_t nbytes, s64 offset) {
     }
 
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(d);
+    auto file = h->GetFile(d);
     if (file == nullptr) {
         return ORBIS_KERNEL_ERROR_EBADF;
     }
 
-    std::scoped_lock lk{file->m_mutex};
-    const s64 pos = file->f.Tell();
-    SCOPE_EXIT {
-        file->f.Seek(pos);
-    };
-    if (!file->f.Seek(offset)) {
-        LOG_CRITICAL(Kernel_Fs, "sceKernelPread: failed to seek");
-        return ORBIS_KERNEL_ERROR_EINVAL;
+    if (file->pfs) {
+        // Package reads are positional and serialized by the image itself.
+        return file->pfs->Read(file->pfs_entry, offset, {static_cast<u8*>(buf), nbytes});
     }
-    return file->f.ReadRaw<u8>(buf, nbytes);
+    if (Common::FS::IOFile::HasPositionalReads &&
+        file->f.GetAccessMode() == Common::FS::FileAccessMode::Read) {
+        // Nothing can be buffered for writing, so concurrent readers don't need the lock.
+        const s64 read = file->f.ReadAt(buf, nbytes, offset);
+        return read < 0 ? ORBIS_KERNEL_ERROR_EIO : read;
+    }
+    std::scoped_lock lk{file->m_mutex};
+    file->f.Flush();
+    const s64 read = file->f.ReadAt(buf, nbytes, offset);
+    return read < 0 ? ORBIS_KERNEL_ERROR_EIO : read;
 }
 
 int PS4_SYSV_ABI sceKernelFStat(int fd, OrbisKernelStat* sb) {
@@ -451,7 +562,7 @@ int PS4_SYSV_ABI sceKernelFStat(int fd, OrbisKernelStat* sb) {
         return ORBIS_KERNEL_ERROR_EFAULT;
     }
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(fd);
+    auto file = h->GetFile(fd);
     if (file == nullptr) {
         return ORBIS_KERNEL_ERROR_EBADF;
     }
@@ -465,7 +576,7 @@ int PS4_SYSV_ABI sceKernelFStat(int fd, OrbisKernelStat* sb) {
         // TODO incomplete
     } else {
         sb->st_mode = 0000777u | 0100000u;
-        sb->st_size = file->f.GetSize();
+        sb->st_size = file->pfs ? file->pfs_entry.size : file->f.GetSize();
         sb->st_blksize = 512;
         sb->st_blocks = (sb->st_size + 511) / 512;
         // TODO incomplete
@@ -485,14 +596,14 @@ int PS4_SYSV_ABI posix_fstat(int fd, OrbisKernelStat* sb) {
 
 s32 PS4_SYSV_ABI sceKernelFsync(int fd) {
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(fd);
+    auto file = h->GetFile(fd);
     file->f.Flush();
     return ORBIS_OK;
 }
 
 int PS4_SYSV_ABI sceKernelFtruncate(int fd, s64 length) {
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(fd);
+    auto file = h->GetFile(fd);
 
     if (file == nullptr) {
         return SCE_KERNEL_ERROR_EBADF;
@@ -515,7 +626,7 @@ static int GetDents(int fd, char* buf, int nbytes, s64* basep) {
         return ORBIS_KERNEL_ERROR_EFAULT;
     }
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(fd);
+    auto file = h->GetFile(fd);
     if (file == nullptr) {
         return ORBIS_KERNEL_ERROR_EBADF;
     }
@@ -562,7 +673,7 @@ s64 PS4_SYSV_ABI sceKernelPwrite(int d, void* buf, size_t nbytes, s64 offset) {
     }
 
     auto* h = Common::Singleton<Core::FileSys::HandleTable>::Instance();
-    auto* file = h->GetFile(d);
+    auto file = h->GetFile(d);
     if (file == nullptr) {
         return ORBIS_KERNEL_ERROR_EBADF;
     }
@@ -605,6 +716,8 @@ s32 PS4_SYSV_ABI sceKernelRename(const char* from, const char* to) {
         return ORBIS_KERNEL_ERROR_ENOTEMPTY;
     }
     std::filesystem::copy(src_path, dst_path, std::filesystem::copy_options::overwrite_existing);
+    mnt->InvalidateHostPath(src_path);
+    mnt->InvalidateHostPath(dst_path);
     return ORBIS_OK;
 }
 
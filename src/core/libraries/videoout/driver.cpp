@@ -196,7 +196,7 @@ void VideoOutDriver::Flip(const Request& req) {
     // Reset flip label
     if (req.index != -1) {
         port->buffer_labels[req.index] = 0;
-        port->SignalVoLabel();
+        liverpool->SignalVoLabel();
     }
 }
 
@@ -30,7 +30,6 @@ struct VideoOutPort {
     std::vector<Kernel::SceKernelEqueue> vblank_events;
     std::mutex vo_mutex;
     std::mutex port_mutex;
-    std::condition_variable vo_cv;
     std::condition_variable vblank_cv;
     int flip_rate = 0;
 
@@ -48,16 +47,6 @@ struct VideoOutPort {
         return address >= start && address <= end;
     }
 
-    void WaitVoLabel(auto&& pred) {
-        std::unique_lock lk{vo_mutex};
-        vo_cv.wait(lk, pred);
-    }
-
-    void SignalVoLabel() {
-        std::scoped_lock lk{vo_mutex};
-        vo_cv.notify_one();
-    }
-
     [[nodiscard]] int NumRegisteredBuffers() const {
         return std::count_if(buffer_slots.cbegin(), buffer_slots.cend(),
                              [](auto& buffer) { return buffer.group_index != -1; });
@@ -1,12 +1,14 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <chrono>
 #include "common/alignment.h"
 #include "common/arch.h"
 #include "common/assert.h"
 #include "common/config.h"
 #include "common/logging/log.h"
 #include "common/path_util.h"
+#include "common/scope_exit.h"
 #include "common/string_util.h"
 #include "common/thread.h"
 #include "core/aerolib/aerolib.h"
@@ -68,9 +70,18 @@ void Linker::Execute() {
     }
 
     // Relocate all modules
+    const auto relocate_begin = std::chrono::steady_clock::now();
     for (const auto& m : m_modules) {
         Relocate(m.get());
     }
+    BootTimings::Add(boot_timings.relocate_ns, relocate_begin);
+
+    const auto to_ms = [](const std::atomic<u64>& ns) { return ns.load() / 1'000'000.0; };
+    LOG_INFO(Core_Linker,
+             "Boot timing: loaded {} modules in {:.2f} ms, relocated in {:.2f} ms, {} symbol "
+             "lookups took {:.2f} ms",
+             m_modules.size(), to_ms(boot_timings.load_ns), to_ms(boot_timings.relocate_ns),
+             boot_timings.num_resolves.load(), to_ms(boot_timings.resolve_ns));
 
     // Configure used flexible memory size.
     if (const auto* proc_param = GetProcParam()) {
@@ -127,7 +138,9 @@ s32 Linker::LoadModule(const std::filesystem::path& elf_name, bool is_dynamic) {
         return -1;
     }
 
+    const auto load_begin = std::chrono::steady_clock::now();
     auto module = std::make_unique<Module>(memory, elf_name, max_tls_index);
+    BootTimings::Add(boot_timings.load_ns, load_begin);
     if (!module->IsValid()) {
         LOG_ERROR(Core_Linker, "Provided file {} is not valid ELF file", elf_name.string());
         return -1;
@@ -254,20 +267,31 @@ const Module* Linker::FindExportedModule(const ModuleInfo& module, const Library
 
 bool Linker::Resolve(const std::string& name, Loader::SymbolType sym_type, Module* m,
                      Loader::SymbolRecord* return_info) {
-    const auto ids = Common::SplitString(name, '#');
-    if (ids.size() != 3) {
+    const auto resolve_begin = std::chrono::steady_clock::now();
+    SCOPE_EXIT {
+        BootTimings::Add(boot_timings.resolve_ns, resolve_begin);
+        boot_timings.num_resolves.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    // Names have the form nid#library#module.
+    const std::string_view full_name{name};
+    const size_t library_pos = full_name.find('#');
+    const size_t module_pos = full_name.find('#', library_pos + 1);
+    if (library_pos == std::string_view::npos || module_pos == std::string_view::npos ||
+        full_name.find('#', module_pos + 1) != std::string_view::npos) {
         return_info->virtual_address = 0;
         return_info->name = name;
         LOG_ERROR(Core_Linker, "Not Resolved {}", name);
         return false;
     }
 
-    const LibraryInfo* library = m->FindLibrary(ids[1]);
-    const ModuleInfo* module = m->FindModule(ids[2]);
+    const LibraryInfo* library =
+        m->FindLibrary(full_name.substr(library_pos + 1, module_pos - library_pos - 1));
+    const ModuleInfo* module = m->FindModule(full_name.substr(module_pos + 1));
     ASSERT_MSG(library && module, "Unable to find library and module");
 
     Loader::SymbolResolver sr{};
-    sr.name = ids.at(0);
+    sr.name = full_name.substr(0, library_pos);
     sr.library = library->name;
     sr.library_version = library->version;
     sr.module = module->name;
@@ -4,6 +4,8 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <vector>
 #include "core/module.h"
@@ -127,6 +129,20 @@ private:
         return func(std::forward<CallArgs>(args)...);
     }
 
+    /// Modules can be loaded and relocated from guest threads, counters are in nanoseconds.
+    struct BootTimings {
+        std::atomic<u64> load_ns{};
+        std::atomic<u64> relocate_ns{};
+        std::atomic<u64> resolve_ns{};
+        std::atomic<u64> num_resolves{};
+
+        static void Add(std::atomic<u64>& counter, std::chrono::steady_clock::time_point begin) {
+            const auto elapsed = std::chrono::steady_clock::now() - begin;
+            counter.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                              std::memory_order_relaxed);
+        }
+    };
+
     MemoryManager* memory;
     std::mutex mutex;
     u32 dtv_generation_counter{1};
@@ -136,6 +152,7 @@ private:
     AppHeapAPI heap_api{};
     std::vector<std::unique_ptr<Module>> m_modules;
     Loader::SymbolsResolver m_hle_symbols{};
+    BootTimings boot_timings{};
 };
 
 } // namespace Core
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <fmt/format.h>
+#include <xxhash.h>
 #include "common/io_file.h"
 #include "common/string_util.h"
 #include "common/types.h"
@@ -10,7 +11,20 @@
 
 namespace Core::Loader {
 
+template <typename T>
+u64 SymbolsResolver::HashFields(const T& s) noexcept {
+    u64 hash = XXH3_64bits(s.name.data(), s.name.size());
+    hash = XXH3_64bits_withSeed(s.library.data(), s.library.size(), hash);
+    hash = XXH3_64bits_withSeed(s.module.data(), s.module.size(), hash);
+    const u64 versions = (u64(s.library_version) << 32) | (u64(s.module_version_major) << 24) |
+                         (u64(s.module_version_minor) << 16) | static_cast<u64>(s.type);
+    return XXH3_64bits_withSeed(&versions, sizeof(versions), hash);
+}
+
 void SymbolsResolver::AddSymbol(const SymbolResolver& s, u64 virtual_addr) {
+    const u32 index = static_cast<u32>(m_symbols.size());
+    // Duplicates keep their first index, so lookups keep returning the first registered symbol.
+    m_index.emplace(SymbolKey{s}, index);
     m_symbols.emplace_back(GenerateName(s), s.nidName, virtual_addr);
 }
 
@@ -20,14 +34,11 @@ std::string SymbolsResolver::GenerateName(const SymbolResolver& s) {
 }
 
 const SymbolRecord* SymbolsResolver::FindSymbol(const SymbolResolver& s) const {
-    const std::string name = GenerateName(s);
-    for (u32 i = 0; i < m_symbols.size(); i++) {
-        if (m_symbols[i].name == name) {
-            return &m_symbols[i];
-        }
+    if (const auto it = m_index.find(s); it != m_index.end()) {
+        return &m_symbols[it->second];
     }
 
-    // LOG_INFO(Core_Linker, "Unresolved! {}", name);
+    // LOG_INFO(Core_Linker, "Unresolved! {}", GenerateName(s));
     return nullptr;
 }
 
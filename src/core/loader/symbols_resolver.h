@@ -7,6 +7,7 @@
 #include <span>
 #include <string>
 #include <vector>
+#include <tsl/robin_map.h>
 #include "common/types.h"
 
 namespace Core::Loader {
@@ -72,7 +73,52 @@ public:
     }
 
 private:
+    /// The fields identifying a symbol. Lookups compare them directly against a SymbolResolver,
+    /// so that no name has to be generated to find a symbol.
+    struct SymbolKey {
+        std::string name;
+        std::string library;
+        std::string module;
+        u16 library_version;
+        u8 module_version_major;
+        u8 module_version_minor;
+        SymbolType type;
+
+        explicit SymbolKey(const SymbolResolver& s)
+            : name{s.name}, library{s.library}, module{s.module},
+              library_version{s.library_version}, module_version_major{s.module_version_major},
+              module_version_minor{s.module_version_minor}, type{s.type} {}
+    };
+
+    template <typename T>
+    static u64 HashFields(const T& s) noexcept;
+
+    struct SymbolKeyHash {
+        using is_transparent = void;
+
+        size_t operator()(const SymbolKey& key) const noexcept {
+            return HashFields(key);
+        }
+        size_t operator()(const SymbolResolver& s) const noexcept {
+            return HashFields(s);
+        }
+    };
+
+    struct SymbolKeyEqual {
+        using is_transparent = void;
+
+        template <typename T, typename U>
+        bool operator()(const T& a, const U& b) const noexcept {
+            return a.name == b.name && a.library == b.library && a.module == b.module &&
+                   a.library_version == b.library_version &&
+                   a.module_version_major == b.module_version_major &&
+                   a.module_version_minor == b.module_version_minor && a.type == b.type;
+        }
+    };
+
     std::vector<SymbolRecord> m_symbols;
+    /// Symbol fields to the index of the first record registered with them.
+    tsl::robin_map<SymbolKey, u32, SymbolKeyHash, SymbolKeyEqual> m_index;
 };
 
 } // namespace Core::Loader
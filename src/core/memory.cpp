@@ -14,6 +14,7 @@
 namespace Core {
 
 constexpr u64 SCE_DEFAULT_FLEXIBLE_MEMORY_SIZE = 448_MB;
+constexpr size_t InitialMapCapacity = 4096;
 
 MemoryManager::MemoryManager() {
     // Set up the direct and flexible memory regions.
@@ -26,6 +27,7 @@ MemoryManager::MemoryManager() {
     const size_t system_reserved_size = impl.SystemReservedVirtualSize();
     const VAddr user_base = impl.UserVirtualBase();
     const size_t user_size = impl.UserVirtualSize();
+    vma_map.reserve(InitialMapCapacity);
     vma_map.emplace(system_managed_base,
                     VirtualMemoryArea{system_managed_base, system_managed_size});
     vma_map.emplace(system_reserved_base,
@@ -48,6 +50,7 @@ void MemoryManager::SetupMemoryRegions(u64 flexible_size) {
     // Insert an area that covers direct memory physical block.
     // Note that this should never be called after direct memory allocations have been made.
     dmem_map.clear();
+    dmem_map.reserve(InitialMapCapacity);
     dmem_map.emplace(0, DirectMemoryArea{0, total_direct_size});
 
     LOG_INFO(Kernel_Vmm, "Configured memory regions: flexible size = {:#x}, direct size = {:#x}",
@@ -141,7 +144,7 @@ void MemoryManager::Free(PAddr phys_addr, size_t size) {
     auto& area = dmem_area->second;
     area.is_free = true;
     area.memory_type = 0;
-    MergeAdjacent(dmem_map, dmem_area);
+    AreaMap::MergeAdjacent(dmem_map, dmem_area);
 }
 
 int MemoryManager::PoolReserve(void** out_addr, VAddr virtual_addr, size_t size,
@@ -154,11 +157,11 @@ int MemoryManager::PoolReserve(void** out_addr, VAddr virtual_addr, size_t size,
 
     // Fixed mapping means the virtual address must exactly match the provided one.
     if (True(flags & MemoryMapFlags::Fixed)) {
-        const auto& vma = FindVMA(mapped_addr)->second;
         // If the VMA is mapped, unmap the region first.
-        if (vma.IsMapped()) {
+        if (FindVMA(mapped_addr)->second.IsMapped()) {
             UnmapMemoryImpl(mapped_addr, size);
         }
+        const auto& vma = FindVMA(mapped_addr)->second;
         const size_t remaining_size = vma.base + vma.size - mapped_addr;
         ASSERT_MSG(vma.type == VMAType::Free && remaining_size >= size);
     }
@@ -175,7 +178,7 @@ int MemoryManager::PoolReserve(void** out_addr, VAddr virtual_addr, size_t size,
     new_vma.prot = MemoryProt::NoAccess;
     new_vma.name = "";
     new_vma.type = VMAType::PoolReserved;
-    MergeAdjacent(vma_map, new_vma_handle);
+    AreaMap::MergeAdjacent(vma_map, new_vma_handle);
 
     *out_addr = std::bit_cast<void*>(mapped_addr);
     return ORBIS_OK;
@@ -191,11 +194,11 @@ int MemoryManager::Reserve(void** out_addr, VAddr virtual_addr, size_t size, Mem
 
     // Fixed mapping means the virtual address must exactly match the provided one.
     if (True(flags & MemoryMapFlags::Fixed)) {
-        const auto& vma = FindVMA(mapped_addr)->second;
         // If the VMA is mapped, unmap the region first.
-        if (vma.IsMapped()) {
+        if (FindVMA(mapped_addr)->second.IsMapped()) {
             UnmapMemoryImpl(mapped_addr, size);
         }
+        const auto& vma = FindVMA(mapped_addr)->second;
         const size_t remaining_size = vma.base + vma.size - mapped_addr;
         ASSERT_MSG(vma.type == VMAType::Free && remaining_size >= size);
     }
@@ -212,7 +215,7 @@ int MemoryManager::Reserve(void** out_addr, VAddr virtual_addr, size_t size, Mem
     new_vma.prot = MemoryProt::NoAccess;
     new_vma.name = "";
     new_vma.type = VMAType::Reserved;
-    MergeAdjacent(vma_map, new_vma_handle);
+    AreaMap::MergeAdjacent(vma_map, new_vma_handle);
 
     *out_addr = std::bit_cast<void*>(mapped_addr);
     return ORBIS_OK;
@@ -356,7 +359,7 @@ void MemoryManager::PoolDecommit(VAddr virtual_addr, size_t size) {
     vma.phys_base = 0;
     vma.disallow_merge = false;
     vma.name = "";
-    MergeAdjacent(vma_map, new_it);
+    AreaMap::MergeAdjacent(vma_map, new_it);
 
     // Unmap the memory region.
     impl.Unmap(vma_base_addr, vma_base_size, start_in_vma, start_in_vma + size, phys_base, is_exec,
@@ -397,8 +400,8 @@ void MemoryManager::UnmapMemoryImpl(VAddr virtual_addr, size_t size) {
     vma.phys_base = 0;
     vma.disallow_merge = false;
     vma.name = "";
-    MergeAdjacent(vma_map, new_it);
-    bool readonly_file = vma.prot == MemoryProt::CpuRead && type == VMAType::File;
+    const bool readonly_file = vma.prot == MemoryProt::CpuRead && type == VMAType::File;
+    AreaMap::MergeAdjacent(vma_map, new_it);
 
     // Unmap the memory region.
     impl.Unmap(vma_base_addr, vma_base_size, start_in_vma, start_in_vma + size, phys_base, is_exec,
@@ -607,80 +610,6 @@ VAddr MemoryManager::SearchFree(VAddr virtual_addr, size_t size, u32 alignment)
     return virtual_addr;
 }
 
-MemoryManager::VMAHandle MemoryManager::CarveVMA(VAddr virtual_addr, size_t size) {
-    auto vma_handle = FindVMA(virtual_addr);
-    ASSERT_MSG(vma_handle != vma_map.end(), "Virtual address not in vm_map");
-
-    const VirtualMemoryArea& vma = vma_handle->second;
-    ASSERT_MSG(vma.base <= virtual_addr, "Adding a mapping to already mapped region");
-
-    const VAddr start_in_vma = virtual_addr - vma.base;
-    const VAddr end_in_vma = start_in_vma + size;
-    ASSERT_MSG(end_in_vma <= vma.size, "Mapping cannot fit inside free region");
-
-    if (end_in_vma != vma.size) {
-        // Split VMA at the end of the allocated region
-        Split(vma_handle, end_in_vma);
-    }
-    if (start_in_vma != 0) {
-        // Split VMA at the start of the allocated region
-        vma_handle = Split(vma_handle, start_in_vma);
-    }
-
-    return vma_handle;
-}
-
-MemoryManager::DMemHandle MemoryManager::CarveDmemArea(PAddr addr, size_t size) {
-    auto dmem_handle = FindDmemArea(addr);
-    ASSERT_MSG(dmem_handle != dmem_map.end(), "Physical address not in dmem_map");
-
-    const DirectMemoryArea& area = dmem_handle->second;
-    ASSERT_MSG(area.base <= addr, "Adding an allocation to already allocated region");
-
-    const PAddr start_in_area = addr - area.base;
-    const PAddr end_in_vma = start_in_area + size;
-    ASSERT_MSG(end_in_vma <= area.size, "Mapping cannot fit inside free region: size = {:#x}",
-               size);
-
-    if (end_in_vma != area.size) {
-        // Split VMA at the end of the allocated region
-        Split(dmem_handle, end_in_vma);
-    }
-    if (start_in_area != 0) {
-        // Split VMA at the start of the allocated region
-        dmem_handle = Split(dmem_handle, start_in_area);
-    }
-
-    return dmem_handle;
-}
-
-MemoryManager::VMAHandle MemoryManager::Split(VMAHandle vma_handle, size_t offset_in_vma) {
-    auto& old_vma = vma_handle->second;
-    ASSERT(offset_in_vma < old_vma.size && offset_in_vma > 0);
-
-    auto new_vma = old_vma;
-    old_vma.size = offset_in_vma;
-    new_vma.base += offset_in_vma;
-    new_vma.size -= offset_in_vma;
-
-    if (new_vma.type == VMAType::Direct) {
-        new_vma.phys_base += offset_in_vma;
-    }
-    return vma_map.emplace_hint(std::next(vma_handle), new_vma.base, new_vma);
-}
-
-MemoryManager::DMemHandle MemoryManager::Split(DMemHandle dmem_handle, size_t offset_in_area) {
-    auto& old_area = dmem_handle->second;
-    ASSERT(offset_in_area < old_area.size && offset_in_area > 0);
-
-    auto new_area = old_area;
-    old_area.size = offset_in_area;
-    new_area.base += offset_in_area;
-    new_area.size -= offset_in_area;
-
-    return dmem_map.emplace_hint(std::next(dmem_handle), new_area.base, new_area);
-};
-
 int MemoryManager::GetDirectMemoryType(PAddr addr, int* directMemoryTypeOut,
                                        void** directMemoryStartOut, void** directMemoryEndOut) {
     std::scoped_lock lk{mutex};
@@ -3,13 +3,14 @@
 
 #pragma once
 
-#include <map>
 #include <mutex>
 #include <string_view>
+#include <boost/container/flat_map.hpp>
 #include "common/enum.h"
 #include "common/singleton.h"
 #include "common/types.h"
 #include "core/address_space.h"
+#include "core/area_map.h"
 #include "core/libraries/kernel/memory_management.h"
 
 namespace Vulkan {
@@ -76,6 +77,15 @@ struct DirectMemoryArea {
         }
         return true;
     }
+
+    /// Shrinks the area to offset bytes and returns the area covering the rest.
+    DirectMemoryArea SplitOff(size_t offset) {
+        auto next = *this;
+        size = offset;
+        next.base += offset;
+        next.size -= offset;
+        return next;
+    }
 };
 
 struct VirtualMemoryArea {
@@ -116,13 +126,28 @@ struct VirtualMemoryArea {
         }
         return true;
     }
+
+    /// Shrinks the area to offset bytes and returns the area covering the rest.
+    VirtualMemoryArea SplitOff(size_t offset) {
+        auto next = *this;
+        size = offset;
+        next.base += offset;
+        next.size -= offset;
+        if (next.type == VMAType::Direct) {
+            next.phys_base += offset;
+        }
+        return next;
+    }
 };
 
 class MemoryManager {
-    using DMemMap = std::map<PAddr, DirectMemoryArea>;
+    // Areas are kept in sorted vectors, lookups are binary searches over contiguous memory.
+    // Inserting or erasing an area invalidates handles past it, so handles must be looked up
+    // again after the map changes.
+    using DMemMap = boost::container::flat_map<PAddr, DirectMemoryArea>;
     using DMemHandle = DMemMap::iterator;
 
-    using VMAMap = std::map<VAddr, VirtualMemoryArea>;
+    using VMAMap = boost::container::flat_map<VAddr, VirtualMemoryArea>;
     using VMAHandle = VMAMap::iterator;
 
 public:
@@ -196,42 +221,22 @@ public:
 
 private:
     VMAHandle FindVMA(VAddr target) {
-        return std::prev(vma_map.upper_bound(target));
+        return AreaMap::Find(vma_map, target);
     }
 
     DMemHandle FindDmemArea(PAddr target) {
-        return std::prev(dmem_map.upper_bound(target));
-    }
-
-    template <typename Handle>
-    Handle MergeAdjacent(auto& handle_map, Handle iter) {
-        const auto next_vma = std::next(iter);
-        if (next_vma != handle_map.end() && iter->second.CanMergeWith(next_vma->second)) {
-            iter->second.size += next_vma->second.size;
-            handle_map.erase(next_vma);
-        }
-
-        if (iter != handle_map.begin()) {
-            auto prev_vma = std::prev(iter);
-            if (prev_vma->second.CanMergeWith(iter->second)) {
-                prev_vma->second.size += iter->second.size;
-                handle_map.erase(iter);
-                iter = prev_vma;
-            }
-        }
-
-        return iter;
+        return AreaMap::Find(dmem_map, target);
     }
 
     VAddr SearchFree(VAddr virtual_addr, size_t size, u32 alignment = 0);
 
-    VMAHandle CarveVMA(VAddr virtual_addr, size_t size);
-
-    DMemHandle CarveDmemArea(PAddr addr, size_t size);
-
-    VMAHandle Split(VMAHandle vma_handle, size_t offset_in_vma);
+    VMAHandle CarveVMA(VAddr virtual_addr, size_t size) {
+        return AreaMap::Carve(vma_map, virtual_addr, size);
+    }
 
-    DMemHandle Split(DMemHandle dmem_handle, size_t offset_in_area);
+    DMemHandle CarveDmemArea(PAddr addr, size_t size) {
+        return AreaMap::Carve(dmem_map, addr, size);
+    }
 
     void UnmapMemoryImpl(VAddr virtual_addr, size_t size);
 
@@ -24,6 +24,7 @@
 #include "core/file_format/trp.h"
 #include "core/file_sys/fs.h"
 #include "core/libraries/disc_map/disc_map.h"
+#include "core/libraries/kernel/aio.h"
 #include "core/libraries/kernel/thread_management.h"
 #include "core/libraries/libc_internal/libc_internal.h"
 #include "core/libraries/libs.h"
@@ -61,6 +62,8 @@ Emulator::Emulator() {
     LOG_INFO(Config, "General isNeo: {}", Config::isNeoMode());
     LOG_INFO(Config, "GPU isNullGpu: {}", Config::nullGpu());
     LOG_INFO(Config, "GPU shouldDumpShaders: {}", Config::dumpShaders());
+    LOG_INFO(Config, "GPU shaderCache: {}", Config::shaderCache());
+    LOG_INFO(Config, "GPU asyncShaderCompile: {}", Config::asyncShaderCompile());
     LOG_INFO(Config, "GPU vblankDivider: {}", Config::vblankDiv());
     LOG_INFO(Config, "Vulkan gpuId: {}", Config::getGpuId());
     LOG_INFO(Config, "Vulkan vkValidation: {}", Config::vkValidationEnabled());
@@ -85,11 +88,35 @@ Emulator::~Emulator() {
 }
 
 void Emulator::Run(const std::filesystem::path& file) {
+    if (file.extension() == ".pkg") {
+        // Serve the game files straight from the package, only the modules are copied out of it
+        // as the linker loads them from the host.
+        std::string failreason;
+        pfs_image = FileSys::PfsImage::Open(file, failreason);
+        ASSERT_MSG(pfs_image, "Failed to mount {}: {}", fmt::UTF(file.u8string()), failreason);
+        const auto& meta_dir = pfs_image->GetMetaDir();
+        ASSERT_MSG(pfs_image->ExtractFile("eboot.bin", meta_dir / "eboot.bin"),
+                   "Package has no eboot.bin");
+        for (const auto& entry : pfs_image->ListDirectory("sce_module")) {
+            if (!entry.is_directory) {
+                pfs_image->ExtractFile("sce_module/" + entry.name,
+                                       meta_dir / "sce_module" / entry.name);
+            }
+        }
+        Run(meta_dir / "eboot.bin");
+        return;
+    }
+
     // Applications expect to be run from /app0 so mount the file's parent path as app0.
     auto* mnt = Common::Singleton<Core::FileSys::MntPoints>::Instance();
-    mnt->Mount(file.parent_path(), "/app0");
-    // Certain games may use /hostapp as well such as CUSA001100
-    mnt->Mount(file.parent_path(), "/hostapp");
+    if (pfs_image) {
+        mnt->Mount(pfs_image, "/app0");
+        mnt->Mount(pfs_image, "/hostapp");
+    } else {
+        mnt->Mount(file.parent_path(), "/app0");
+        // Certain games may use /hostapp as well such as CUSA001100
+        mnt->Mount(file.parent_path(), "/hostapp");
+    }
 
     auto& game_info = Common::ElfInfo::Instance();
 
@@ -217,6 +244,7 @@ void Emulator::Run(const std::filesystem::path& file) {
         window->waitEvent();
     }
 
+    Libraries::Kernel::ShutdownKernelAio();
     std::exit(0);
 }
 
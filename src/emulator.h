@@ -4,9 +4,11 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <thread>
 
 #include "common/singleton.h"
+#include "core/file_sys/pfs_image.h"
 #include "core/linker.h"
 #include "input/controller.h"
 #include "sdl_window.h"
@@ -34,6 +36,7 @@ private:
     Input::GameController* controller;
     Core::Linker* linker;
     std::unique_ptr<Frontend::WindowSDL> window;
+    std::shared_ptr<FileSys::PfsImage> pfs_image;
 };
 
 } // namespace Core
@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Benchmarks guest path resolution and open(). A scratch tree of mixed-case directories and
+// files is created, mounted at /app0 and every file is resolved through its lowercase guest
+// path: first with a cold directory index, then repeatedly with a warm one. Opening the
+// resolved paths is compared against opening the host paths directly, and lookups of missing
+// files measure the cost of the staleness check on a miss.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/core.h>
+
+#include "common/io_file.h"
+#include "common/logging/backend.h"
+#include "common/types.h"
+#include "core/file_sys/fs.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    u32 num_dirs = 64;
+    u32 num_files = 64;
+    u32 iterations = 10;
+    bool keep = false;
+    std::filesystem::path scratch_dir;
+};
+
+void PrintUsage(const char* program) {
+    fmt::print("Usage: {} [options] <scratch directory>\n"
+               "  -d <dirs>        Directories in the tree (default: 64)\n"
+               "  -f <files>       Files per directory (default: 64)\n"
+               "  -n <iterations>  Passes over the tree for warm measurements (default: 10)\n"
+               "  -k               Keep the tree after the run\n",
+               program);
+}
+
+std::optional<Options> ParseOptions(int argc, char* argv[]) {
+    Options options{};
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg{argv[i]};
+        const bool has_value = i + 1 < argc;
+        if (arg == "-d" && has_value) {
+            options.num_dirs = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-f" && has_value) {
+            options.num_files = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-n" && has_value) {
+            options.iterations = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-k") {
+            options.keep = true;
+        } else if (arg.starts_with('-') || !options.scratch_dir.empty()) {
+            return std::nullopt;
+        } else {
+            options.scratch_dir = arg;
+        }
+    }
+    if (options.scratch_dir.empty()) {
+        return std::nullopt;
+    }
+    return options;
+}
+
+struct Entry {
+    std::string guest_path;
+    std::filesystem::path host_path;
+};
+
+/// Creates the tree with names in mixed case, so that resolution has to go through the index.
+std::vector<Entry> CreateTree(const Options& options, const std::filesystem::path& root) {
+    std::vector<Entry> entries;
+    entries.reserve(size_t{options.num_dirs} * options.num_files);
+    for (u32 d = 0; d < options.num_dirs; d++) {
+        const auto dir_name = fmt::format("Dir{:03}", d);
+        std::filesystem::create_directories(root / dir_name);
+        for (u32 f = 0; f < options.num_files; f++) {
+            const auto file_name = fmt::format("File{:03}.Bin", f);
+            auto host_path = root / dir_name / file_name;
+            Common::FS::IOFile file{host_path, Common::FS::FileAccessMode::Write};
+            file.WriteString(file_name);
+            entries.push_back({fmt::format("/app0/dir{:03}/file{:03}.bin", d, f),
+                               std::move(host_path)});
+        }
+    }
+    return entries;
+}
+
+template <typename Func>
+double MeasureNs(size_t num_ops, Func&& func) {
+    const auto start = Clock::now();
+    func();
+    const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return elapsed / static_cast<double>(num_ops);
+}
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[]) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage(argv[0]);
+        return -1;
+    }
+
+    Common::Log::Initialize("fs_bench.log");
+    Common::Log::Start();
+
+    const auto root = options->scratch_dir / "fs_bench";
+    std::filesystem::remove_all(root);
+    const auto entries = CreateTree(*options, root);
+    const size_t num_warm = entries.size() * options->iterations;
+
+    Core::FileSys::MntPoints mnt;
+    mnt.Mount(root, "/app0");
+
+    size_t num_failed{};
+    const auto resolve_all = [&] {
+        for (const auto& entry : entries) {
+            num_failed += mnt.GetHostPath(entry.guest_path) != entry.host_path;
+        }
+    };
+    const double cold_ns = MeasureNs(entries.size(), resolve_all);
+    const double warm_ns = MeasureNs(num_warm, [&] {
+        for (u32 i = 0; i < options->iterations; i++) {
+            resolve_all();
+        }
+    });
+    const double open_ns = MeasureNs(num_warm, [&] {
+        for (u32 i = 0; i < options->iterations; i++) {
+            for (const auto& entry : entries) {
+                const Common::FS::IOFile file{mnt.GetHostPath(entry.guest_path),
+                                              Common::FS::FileAccessMode::Read};
+                num_failed += !file.IsOpen();
+            }
+        }
+    });
+    const double host_open_ns = MeasureNs(num_warm, [&] {
+        for (u32 i = 0; i < options->iterations; i++) {
+            for (const auto& entry : entries) {
+                const Common::FS::IOFile file{entry.host_path, Common::FS::FileAccessMode::Read};
+                num_failed += !file.IsOpen();
+            }
+        }
+    });
+    const double miss_ns = MeasureNs(num_warm, [&] {
+        for (u32 i = 0; i < options->iterations; i++) {
+            for (const auto& entry : entries) {
+                const auto guest_path = entry.guest_path + ".missing";
+                num_failed += std::filesystem::exists(mnt.GetHostPath(guest_path));
+            }
+        }
+    });
+
+    fmt::print("{} files in {} directories, {} warm passes\n", entries.size(), options->num_dirs,
+               options->iterations);
+    fmt::print("{:<28}{:>12.1f} ns\n", "resolve (cold index)", cold_ns);
+    fmt::print("{:<28}{:>12.1f} ns\n", "resolve (warm index)", warm_ns);
+    fmt::print("{:<28}{:>12.1f} ns\n", "resolve + open", open_ns);
+    fmt::print("{:<28}{:>12.1f} ns\n", "open host path", host_open_ns);
+    fmt::print("{:<28}{:>12.1f} ns\n", "resolve missing file", miss_ns);
+    if (num_failed != 0) {
+        fmt::print("{} lookups returned a wrong result\n", num_failed);
+    }
+
+    if (!options->keep) {
+        std::filesystem::remove_all(root);
+    }
+    Common::Log::Stop();
+    return num_failed == 0 ? 0 : 1;
+}
@@ -15,7 +15,7 @@ int main(int argc, char* argv[]) {
 #endif
 
     if (argc == 1) {
-        fmt::print("Usage: {} <elf or eboot.bin path>\n", argv[0]);
+        fmt::print("Usage: {} <elf, eboot.bin or pkg path>\n", argv[0]);
         return -1;
     }
     // check if eboot file exists
@@ -5,6 +5,7 @@
 #include <QKeyEvent>
 #include <QPlainTextEdit>
 #include <QProgressDialog>
+#include <QPromise>
 #include <SDL3/SDL_events.h>
 
 #include "about_dialog.h"
@@ -902,11 +903,6 @@ void MainWindow::InstallDragDropPkg(std::filesystem::path file, int pkgNum, int
             int nfiles = pkg.GetNumberOfFiles();
 
             if (nfiles > 0) {
-                QVector<int> indices;
-                for (int i = 0; i < nfiles; i++) {
-                    indices.append(i);
-                }
-
                 QProgressDialog dialog;
                 dialog.setWindowTitle(tr("PKG Extraction"));
                 dialog.setWindowModality(Qt::WindowModal);
@@ -936,12 +932,24 @@ void MainWindow::InstallDragDropPkg(std::filesystem::path file, int pkgNum, int
                         extractMsgBox.exec();
                     }
                 });
-                connect(&dialog, &QProgressDialog::canceled, [&]() { futureWatcher.cancel(); });
+                std::stop_source stop_source;
+                connect(&dialog, &QProgressDialog::canceled, [&]() {
+                    stop_source.request_stop();
+                    futureWatcher.cancel();
+                });
+                connect(&futureWatcher, &QFutureWatcher<void>::progressRangeChanged, &dialog,
+                        &QProgressDialog::setRange);
                 connect(&futureWatcher, &QFutureWatcher<void>::progressValueChanged, &dialog,
                         &QProgressDialog::setValue);
-                futureWatcher.setFuture(
-                    QtConcurrent::map(indices, [&](int index) { pkg.ExtractFiles(index); }));
+                futureWatcher.setFuture(QtConcurrent::run([&](QPromise<void>& promise) {
+                    pkg.ExtractFiles(stop_source.get_token(), [&](u32 done, u32 total) {
+                        promise.setProgressRange(0, total);
+                        promise.setProgressValue(done);
+                    });
+                }));
                 dialog.exec();
+                // The task references the locals of this scope, including when it was canceled.
+                futureWatcher.waitForFinished();
             }
         }
     } else {
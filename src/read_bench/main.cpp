@@ -0,0 +1,181 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Benchmarks concurrent positional reads over a directory of extracted game files. Every thread
+// reads blocks at random offsets of random files, shared between all threads the way loader
+// threads share an archive. Lock free positional reads, as used by sceKernelPread on read only
+// files, are compared against the previous path that serialized a seek and a read on a per file
+// mutex.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+
+#include "common/io_file.h"
+#include "common/logging/backend.h"
+#include "common/types.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    u32 num_threads = 8;
+    u32 block_size = 64 * 1024;
+    u32 reads_per_thread = 4096;
+    std::filesystem::path dir;
+};
+
+void PrintUsage(const char* program) {
+    fmt::print("Usage: {} [options] <directory>\n"
+               "  -t <threads>  Reader threads (default: 8)\n"
+               "  -b <bytes>    Bytes per read (default: 65536)\n"
+               "  -n <reads>    Reads per thread (default: 4096)\n",
+               program);
+}
+
+std::optional<Options> ParseOptions(int argc, char* argv[]) {
+    Options options{};
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg{argv[i]};
+        const bool has_value = i + 1 < argc;
+        if (arg == "-t" && has_value) {
+            options.num_threads = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-b" && has_value) {
+            options.block_size = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-n" && has_value) {
+            options.reads_per_thread = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg.starts_with('-') || !options.dir.empty()) {
+            return std::nullopt;
+        } else {
+            options.dir = arg;
+        }
+    }
+    if (options.dir.empty()) {
+        return std::nullopt;
+    }
+    return options;
+}
+
+struct File {
+    Common::FS::IOFile file;
+    u64 size;
+    std::mutex mutex;
+};
+
+std::vector<std::unique_ptr<File>> OpenFiles(const std::filesystem::path& dir, u32 block_size) {
+    std::vector<std::unique_ptr<File>> files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator{dir}) {
+        if (!entry.is_regular_file() || entry.file_size() < block_size) {
+            continue;
+        }
+        auto file = std::make_unique<File>();
+        file->file.Open(entry.path(), Common::FS::FileAccessMode::Read);
+        file->size = entry.file_size();
+        if (file->file.IsOpen()) {
+            files.push_back(std::move(file));
+        }
+    }
+    return files;
+}
+
+struct Result {
+    double seconds;
+    u64 num_failed;
+};
+
+/// Runs every thread to completion and returns the wall time. read receives a file, an offset
+/// and a buffer and returns the number of bytes read.
+template <typename ReadFunc>
+Result Run(const Options& options, std::vector<std::unique_ptr<File>>& files, ReadFunc&& read) {
+    std::atomic<u64> num_failed{};
+    std::vector<std::jthread> threads;
+    const auto start = Clock::now();
+    for (u32 t = 0; t < options.num_threads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 rng{t};
+            std::vector<u8> buffer(options.block_size);
+            for (u32 i = 0; i < options.reads_per_thread; i++) {
+                File& file = *files[rng() % files.size()];
+                const u64 max_offset = file.size - options.block_size;
+                const s64 offset = static_cast<s64>(rng() % (max_offset + 1));
+                if (read(file, offset, buffer) != options.block_size) {
+                    num_failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    threads.clear();
+    return {std::chrono::duration<double>(Clock::now() - start).count(), num_failed.load()};
+}
+
+void PrintResult(std::string_view name, const Options& options, const Result& result) {
+    const u64 num_reads = u64{options.num_threads} * options.reads_per_thread;
+    const double mib = static_cast<double>(num_reads * options.block_size) / (1024.0 * 1024.0);
+    fmt::print("{:<24}{:>10.1f} MiB/s{:>12.2f} us/read\n", name, mib / result.seconds,
+               result.seconds * 1e6 * options.num_threads / static_cast<double>(num_reads));
+    if (result.num_failed != 0) {
+        fmt::print("{:<24}{} short or failed reads\n", "", result.num_failed);
+    }
+}
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[]) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage(argv[0]);
+        return -1;
+    }
+
+    Common::Log::Initialize("read_bench.log");
+    Common::Log::Start();
+
+    auto files = OpenFiles(options->dir, options->block_size);
+    if (files.empty()) {
+        fmt::print("No files of at least {} bytes in {}\n", options->block_size,
+                   options->dir.string());
+        Common::Log::Stop();
+        return -1;
+    }
+    fmt::print("{} files, {} threads, {} reads of {} bytes per thread\n", files.size(),
+               options->num_threads, options->reads_per_thread, options->block_size);
+
+    const auto locked = Run(*options, files, [](File& file, s64 offset, std::span<u8> buffer) {
+        std::scoped_lock lk{file.mutex};
+        const s64 pos = file.file.Tell();
+        file.file.Seek(offset);
+        const size_t read = file.file.ReadRaw<u8>(buffer.data(), buffer.size());
+        file.file.Seek(pos);
+        return read;
+    });
+    const auto positional = Run(*options, files, [](File& file, s64 offset, std::span<u8> buffer) {
+        // Mirrors sceKernelPread, which keeps the lock where reads go through the stream.
+        std::unique_lock lk{file.mutex, std::defer_lock};
+        if constexpr (!Common::FS::IOFile::HasPositionalReads) {
+            lk.lock();
+        }
+        const s64 read = file.file.ReadAt(buffer.data(), buffer.size(), offset);
+        return read < 0 ? size_t{0} : static_cast<size_t>(read);
+    });
+
+    PrintResult("seek + read (locked)", *options, locked);
+    PrintResult("positional read", *options, positional);
+    if (!Common::FS::IOFile::HasPositionalReads) {
+        fmt::print("Positional reads fall back to locked seeks on this platform\n");
+    }
+
+    Common::Log::Stop();
+    return locked.num_failed + positional.num_failed == 0 ? 0 : 1;
+}
@@ -17,73 +17,7 @@ T extract(T value, u32 lst, u32 fst) {
 } // namespace bit
 
 InstEncoding GetInstructionEncoding(u32 token) {
-    auto encoding = static_cast<InstEncoding>(token & (u32)EncodingMask::MASK_9bit);
-    switch (encoding) {
-    case InstEncoding::SOP1:
-    case InstEncoding::SOPP:
-    case InstEncoding::SOPC:
-        return encoding;
-    default:
-        break;
-    }
-
-    encoding = static_cast<InstEncoding>(token & (u32)EncodingMask::MASK_7bit);
-    switch (encoding) {
-    case InstEncoding::VOP1:
-    case InstEncoding::VOPC:
-        return encoding;
-    default:
-        break;
-    }
-
-    encoding = static_cast<InstEncoding>(token & (u32)EncodingMask::MASK_6bit);
-    switch (encoding) {
-    case InstEncoding::VOP3:
-    case InstEncoding::EXP:
-    case InstEncoding::VINTRP:
-    case InstEncoding::DS:
-    case InstEncoding::MUBUF:
-    case InstEncoding::MTBUF:
-    case InstEncoding::MIMG:
-        return encoding;
-    default:
-        break;
-    }
-
-    encoding = static_cast<InstEncoding>(token & (u32)EncodingMask::MASK_5bit);
-    switch (encoding) {
-    case InstEncoding::SMRD:
-        return encoding;
-    default:
-        break;
-    }
-
-    encoding = static_cast<InstEncoding>(token & (u32)EncodingMask::MASK_4bit);
-    switch (encoding) {
-    case InstEncoding::SOPK:
-        return encoding;
-    default:
-        break;
-    }
-
-    encoding = static_cast<InstEncoding>(token & (u32)EncodingMask::MASK_2bit);
-    switch (encoding) {
-    case InstEncoding::SOP2:
-        return encoding;
-    default:
-        break;
-    }
-
-    encoding = static_cast<InstEncoding>(token & (u32)EncodingMask::MASK_1bit);
-    switch (encoding) {
-    case InstEncoding::VOP2:
-        return encoding;
-    default:
-        break;
-    }
-
-    UNREACHABLE();
-    return InstEncoding::ILLEGAL;
+    return GetEncodingInfo(token).encoding;
 }
 
 bool HasAdditionalLiteral(InstEncoding encoding, Opcode opcode) {
@@ -110,164 +44,50 @@ bool IsVop3BEncoding(Opcode opcode) {
 GcnInst GcnDecodeContext::decodeInstruction(GcnCodeSlice& code) {
     const uint32_t token = code.at(0);
 
-    InstEncoding encoding = GetInstructionEncoding(token);
-    ASSERT_MSG(encoding != InstEncoding::ILLEGAL, "illegal encoding");
-    uint32_t encodingLen = getEncodingLength(encoding);
+    // Resolve encoding, length and instruction format from the first dword.
+    const EncodingInfo& info = GetEncodingInfo(token);
+    ASSERT_MSG(info.encoding != InstEncoding::ILLEGAL, "illegal encoding {:#x}", token);
+    const u32 encoding_op = (token >> info.op_shift) & info.op_mask;
+    ASSERT_MSG(encoding_op < info.num_formats, "Unknown opcode {} for encoding {}", encoding_op,
+               magic_enum::enum_name(info.encoding));
+    const InstFormat& format = info.formats[encoding_op];
 
     // Clear the instruction
     m_instruction = GcnInst();
 
     // Decode
-    if (encodingLen == sizeof(uint32_t)) {
-        decodeInstruction32(encoding, code);
+    if (info.length == sizeof(uint32_t)) {
+        decodeInstruction32(info.encoding, code);
     } else {
-        decodeInstruction64(encoding, code);
+        decodeInstruction64(info.encoding, code);
     }
 
     // Update instruction meta info.
-    updateInstructionMeta(encoding);
+    updateInstructionMeta(info, format);
 
     // Detect literal constant. Only 32 bits instructions may have literal constant.
     // Note: Literal constant decode must be performed after meta info updated.
-    if (encodingLen == sizeof(u32)) {
-        decodeLiteralConstant(encoding, code);
+    if (info.length == sizeof(u32)) {
+        decodeLiteralConstant(info.encoding, format, code);
     }
 
     repairOperandType();
     return m_instruction;
 }
 
-uint32_t GcnDecodeContext::getEncodingLength(InstEncoding encoding) {
-    uint32_t instLength = 0;
-
-    switch (encoding) {
-    case InstEncoding::SOP1:
-    case InstEncoding::SOPP:
-    case InstEncoding::SOPC:
-    case InstEncoding::SOPK:
-    case InstEncoding::SOP2:
-    case InstEncoding::VOP1:
-    case InstEncoding::VOPC:
-    case InstEncoding::VOP2:
-    case InstEncoding::SMRD:
-    case InstEncoding::VINTRP:
-        instLength = sizeof(uint32_t);
-        break;
-
-    case InstEncoding::VOP3:
-    case InstEncoding::MUBUF:
-    case InstEncoding::MTBUF:
-    case InstEncoding::MIMG:
-    case InstEncoding::DS:
-    case InstEncoding::EXP:
-        instLength = sizeof(uint64_t);
-        break;
-    default:
-        break;
-    }
-    return instLength;
-}
-
-uint32_t GcnDecodeContext::getOpMapOffset(InstEncoding encoding) {
-    uint32_t offset = 0;
-    switch (encoding) {
-    case InstEncoding::SOP1:
-        offset = (uint32_t)OpcodeMap::OP_MAP_SOP1;
-        break;
-    case InstEncoding::SOPP:
-        offset = (uint32_t)OpcodeMap::OP_MAP_SOPP;
-        break;
-    case InstEncoding::SOPC:
-        offset = (uint32_t)OpcodeMap::OP_MAP_SOPC;
-        break;
-    case InstEncoding::VOP1:
-        offset = (uint32_t)OpcodeMap::OP_MAP_VOP1;
-        break;
-    case InstEncoding::VOPC:
-        offset = (uint32_t)OpcodeMap::OP_MAP_VOPC;
-        break;
-    case InstEncoding::VOP3:
-        offset = (uint32_t)OpcodeMap::OP_MAP_VOP3;
-        break;
-    case InstEncoding::EXP:
-        offset = (uint32_t)OpcodeMap::OP_MAP_EXP;
-        break;
-    case InstEncoding::VINTRP:
-        offset = (uint32_t)OpcodeMap::OP_MAP_VINTRP;
-        break;
-    case InstEncoding::DS:
-        offset = (uint32_t)OpcodeMap::OP_MAP_DS;
-        break;
-    case InstEncoding::MUBUF:
-        offset = (uint32_t)OpcodeMap::OP_MAP_MUBUF;
-        break;
-    case InstEncoding::MTBUF:
-        offset = (uint32_t)OpcodeMap::OP_MAP_MTBUF;
-        break;
-    case InstEncoding::MIMG:
-        offset = (uint32_t)OpcodeMap::OP_MAP_MIMG;
-        break;
-    case InstEncoding::SMRD:
-        offset = (uint32_t)OpcodeMap::OP_MAP_SMRD;
-        break;
-    case InstEncoding::SOPK:
-        offset = (uint32_t)OpcodeMap::OP_MAP_SOPK;
-        break;
-    case InstEncoding::SOP2:
-        offset = (uint32_t)OpcodeMap::OP_MAP_SOP2;
-        break;
-    case InstEncoding::VOP2:
-        offset = (uint32_t)OpcodeMap::OP_MAP_VOP2;
-        break;
-    default:
-        break;
-    }
-    return offset;
-}
-
-uint32_t GcnDecodeContext::mapEncodingOp(InstEncoding encoding, Opcode opcode) {
-    // Map from uniform opcode to encoding specific opcode.
-    uint32_t encodingOp = 0;
-    if (encoding == InstEncoding::VOP3) {
-        if (opcode >= Opcode::V_CMP_F_F32 && opcode <= Opcode::V_CMPX_T_U64) {
-            uint32_t op =
-                static_cast<uint32_t>(opcode) - static_cast<uint32_t>(OpcodeMap::OP_MAP_VOPC);
-            encodingOp = op + static_cast<uint32_t>(OpMapVOP3VOPX::VOP3_TO_VOPC);
-        } else if (opcode >= Opcode::V_CNDMASK_B32 && opcode <= Opcode::V_CVT_PK_I16_I32) {
-            uint32_t op =
-                static_cast<uint32_t>(opcode) - static_cast<uint32_t>(OpcodeMap::OP_MAP_VOP2);
-            encodingOp = op + static_cast<uint32_t>(OpMapVOP3VOPX::VOP3_TO_VOP2);
-        } else if (opcode >= Opcode::V_NOP && opcode <= Opcode::V_MOVRELSD_B32) {
-            uint32_t op =
-                static_cast<uint32_t>(opcode) - static_cast<uint32_t>(OpcodeMap::OP_MAP_VOP1);
-            encodingOp = op + static_cast<uint32_t>(OpMapVOP3VOPX::VOP3_TO_VOP1);
-        } else {
-            encodingOp =
-                static_cast<uint32_t>(opcode) - static_cast<uint32_t>(OpcodeMap::OP_MAP_VOP3);
-        }
-    } else {
-        uint32_t mapOffset = getOpMapOffset(encoding);
-        encodingOp = static_cast<uint32_t>(opcode) - mapOffset;
-    }
-
-    return encodingOp;
-}
-
-void GcnDecodeContext::updateInstructionMeta(InstEncoding encoding) {
-    uint32_t encodingOp = mapEncodingOp(encoding, m_instruction.opcode);
-    InstFormat instFormat = InstructionFormat(encoding, encodingOp);
-
+void GcnDecodeContext::updateInstructionMeta(const EncodingInfo& info,
+                                             const InstFormat& instFormat) {
     ASSERT_MSG(instFormat.src_type != ScalarType::Undefined &&
                    instFormat.dst_type != ScalarType::Undefined,
                "Instruction format table incomplete for opcode {} ({}, encoding = {})",
                magic_enum::enum_name(m_instruction.opcode), u32(m_instruction.opcode),
-               magic_enum::enum_name(encoding));
+               magic_enum::enum_name(info.encoding));
 
     m_instruction.inst_class = instFormat.inst_class;
     m_instruction.category = instFormat.inst_category;
-    m_instruction.encoding = encoding;
+    m_instruction.encoding = info.encoding;
     m_instruction.src_count = instFormat.src_count;
-    m_instruction.length = getEncodingLength(encoding);
+    m_instruction.length = info.length;
 
     // Update src operand scalar type.
     auto setOperandType = [&instFormat](InstOperand& src) {
@@ -401,12 +221,11 @@ void GcnDecodeContext::decodeInstruction64(InstEncoding encoding, GcnCodeSlice&
     }
 }
 
-void GcnDecodeContext::decodeLiteralConstant(InstEncoding encoding, GcnCodeSlice& code) {
+void GcnDecodeContext::decodeLiteralConstant(InstEncoding encoding, const InstFormat& format,
+                                             GcnCodeSlice& code) {
     if (HasAdditionalLiteral(encoding, m_instruction.opcode)) {
-        u32 encoding_op = mapEncodingOp(encoding, m_instruction.opcode);
-        InstFormat instFormat = InstructionFormat(encoding, encoding_op);
         m_instruction.src[m_instruction.src_count].field = OperandField::LiteralConst;
-        m_instruction.src[m_instruction.src_count].type = instFormat.src_type;
+        m_instruction.src[m_instruction.src_count].type = format.src_type;
         m_instruction.src[m_instruction.src_count].code = code.readu32();
         ++m_instruction.src_count;
         m_instruction.length += sizeof(u32);
@@ -16,6 +16,19 @@ struct InstFormat {
     ScalarType dst_type = ScalarType::Undefined;
 };
 
+/// Decoding properties of the instructions sharing an encoding.
+struct EncodingInfo {
+    InstEncoding encoding = InstEncoding::ILLEGAL;
+    u8 length = 0;   ///< Size of the instruction without literal constant, in bytes
+    u8 op_shift = 0; ///< Position of the encoding opcode in the first dword
+    u16 op_mask = 0;
+    const InstFormat* formats = nullptr; ///< Formats indexed by encoding opcode
+    u32 num_formats = 0;
+};
+
+/// Returns the decoding properties of the instruction starting with the token.
+const EncodingInfo& GetEncodingInfo(u32 token);
+
 InstEncoding GetInstructionEncoding(u32 token);
 
 u32 GetEncodingLength(InstEncoding encoding);
@@ -58,10 +71,7 @@ public:
     GcnInst decodeInstruction(GcnCodeSlice& code);
 
 private:
-    uint32_t getEncodingLength(InstEncoding encoding);
-    uint32_t getOpMapOffset(InstEncoding encoding);
-    uint32_t mapEncodingOp(InstEncoding encoding, Opcode opcode);
-    void updateInstructionMeta(InstEncoding encoding);
+    void updateInstructionMeta(const EncodingInfo& info, const InstFormat& format);
     uint32_t getMimgModifier(Opcode opcode);
     void repairOperandType();
 
@@ -69,7 +79,8 @@ private:
 
     void decodeInstruction32(InstEncoding encoding, GcnCodeSlice& code);
     void decodeInstruction64(InstEncoding encoding, GcnCodeSlice& code);
-    void decodeLiteralConstant(InstEncoding encoding, GcnCodeSlice& code);
+    void decodeLiteralConstant(InstEncoding encoding, const InstFormat& format,
+                               GcnCodeSlice& code);
 
     // 32 bits encodings
     void decodeInstructionSOP1(uint32_t hexInstruction);
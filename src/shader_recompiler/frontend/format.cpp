@@ -1,6 +1,8 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <utility>
+
 #include "common/assert.h"
 #include "shader_recompiler/frontend/decode.h"
 
@@ -3724,4 +3726,110 @@ InstFormat InstructionFormat(InstEncoding encoding, uint32_t opcode) {
     return {};
 }
 
+namespace {
+
+/// Resolves the encoding of a token by testing the encoding masks from the longest to the
+/// shortest.
+constexpr InstEncoding EncodingOf(u32 token) {
+    constexpr std::array<std::pair<EncodingMask, InstEncoding>, 16> Encodings = {{
+        {EncodingMask::MASK_9bit, InstEncoding::SOP1},
+        {EncodingMask::MASK_9bit, InstEncoding::SOPP},
+        {EncodingMask::MASK_9bit, InstEncoding::SOPC},
+        {EncodingMask::MASK_7bit, InstEncoding::VOP1},
+        {EncodingMask::MASK_7bit, InstEncoding::VOPC},
+        {EncodingMask::MASK_6bit, InstEncoding::VOP3},
+        {EncodingMask::MASK_6bit, InstEncoding::EXP},
+        {EncodingMask::MASK_6bit, InstEncoding::VINTRP},
+        {EncodingMask::MASK_6bit, InstEncoding::DS},
+        {EncodingMask::MASK_6bit, InstEncoding::MUBUF},
+        {EncodingMask::MASK_6bit, InstEncoding::MTBUF},
+        {EncodingMask::MASK_6bit, InstEncoding::MIMG},
+        {EncodingMask::MASK_5bit, InstEncoding::SMRD},
+        {EncodingMask::MASK_4bit, InstEncoding::SOPK},
+        {EncodingMask::MASK_2bit, InstEncoding::SOP2},
+        {EncodingMask::MASK_1bit, InstEncoding::VOP2},
+    }};
+    for (const auto& [mask, encoding] : Encodings) {
+        if ((token & static_cast<u32>(mask)) == static_cast<u32>(encoding)) {
+            return encoding;
+        }
+    }
+    return InstEncoding::ILLEGAL;
+}
+
+template <size_t N>
+constexpr EncodingInfo MakeEncodingInfo(InstEncoding encoding, u32 length, u32 op_lsb,
+                                        u32 op_bits, const std::array<InstFormat, N>& formats) {
+    return EncodingInfo{
+        .encoding = encoding,
+        .length = static_cast<u8>(length),
+        .op_shift = static_cast<u8>(op_lsb),
+        .op_mask = static_cast<u16>((1U << op_bits) - 1),
+        .formats = formats.data(),
+        .num_formats = static_cast<u32>(N),
+    };
+}
+
+constexpr EncodingInfo MakeEncodingInfo(InstEncoding encoding) {
+    switch (encoding) {
+    case InstEncoding::SOP1:
+        return MakeEncodingInfo(encoding, 4, 8, 8, InstructionFormatSOP1);
+    case InstEncoding::SOPP:
+        return MakeEncodingInfo(encoding, 4, 16, 7, InstructionFormatSOPP);
+    case InstEncoding::SOPC:
+        return MakeEncodingInfo(encoding, 4, 16, 7, InstructionFormatSOPC);
+    case InstEncoding::SOPK:
+        return MakeEncodingInfo(encoding, 4, 23, 5, InstructionFormatSOPK);
+    case InstEncoding::SOP2:
+        return MakeEncodingInfo(encoding, 4, 23, 7, InstructionFormatSOP2);
+    case InstEncoding::VOP1:
+        return MakeEncodingInfo(encoding, 4, 9, 8, InstructionFormatVOP1);
+    case InstEncoding::VOPC:
+        return MakeEncodingInfo(encoding, 4, 17, 8, InstructionFormatVOPC);
+    case InstEncoding::VOP2:
+        return MakeEncodingInfo(encoding, 4, 25, 6, InstructionFormatVOP2);
+    case InstEncoding::SMRD:
+        return MakeEncodingInfo(encoding, 4, 22, 5, InstructionFormatSMRD);
+    case InstEncoding::VINTRP:
+        return MakeEncodingInfo(encoding, 4, 16, 2, InstructionFormatVINTRP);
+    case InstEncoding::VOP3:
+        // Opcodes promoted from VOPC, VOP2 and VOP1 keep their VOP3 number in the table.
+        return MakeEncodingInfo(encoding, 8, 17, 9, InstructionFormatVOP3);
+    case InstEncoding::MUBUF:
+        return MakeEncodingInfo(encoding, 8, 18, 7, InstructionFormatMUBUF);
+    case InstEncoding::MTBUF:
+        return MakeEncodingInfo(encoding, 8, 16, 3, InstructionFormatMTBUF);
+    case InstEncoding::MIMG:
+        return MakeEncodingInfo(encoding, 8, 18, 7, InstructionFormatMIMG);
+    case InstEncoding::DS:
+        return MakeEncodingInfo(encoding, 8, 18, 8, InstructionFormatDS);
+    case InstEncoding::EXP:
+        return MakeEncodingInfo(encoding, 8, 0, 0, InstructionFormatEXP);
+    default:
+        return {};
+    }
+}
+
+/// Every encoding is identified by the upper 9 bits of its first dword, so a table indexed by
+/// them resolves the encoding, its length and the location of the opcode in one lookup.
+constexpr std::array<EncodingInfo, 512> EncodingTable = [] {
+    std::array<EncodingInfo, 512> table{};
+    for (u32 i = 0; i < table.size(); i++) {
+        table[i] = MakeEncodingInfo(EncodingOf(i << 23));
+    }
+    return table;
+}();
+
+static_assert(EncodingTable[0x17D].encoding == InstEncoding::SOP1);
+static_assert(EncodingTable[0x160].encoding == InstEncoding::SOPK);
+static_assert(EncodingTable[0x1A0].encoding == InstEncoding::VOP3);
+static_assert(EncodingTable[0x0FC].encoding == InstEncoding::VOP1);
+static_assert(EncodingTable[0x07B].encoding == InstEncoding::VOP2);
+
+} // Anonymous namespace
+
+const EncodingInfo& GetEncodingInfo(u32 token) {
+    return EncodingTable[token >> 23];
+}
+
 } // namespace Shader::Gcn
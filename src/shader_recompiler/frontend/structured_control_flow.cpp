@@ -823,17 +823,15 @@ private:
 };
 } // Anonymous namespace
 
-IR::AbstractSyntaxList BuildASL(Common::ObjectPool<IR::Inst>& inst_pool,
-                                Common::ObjectPool<IR::Block>& block_pool, CFG& cfg, Info& info,
-                                const RuntimeInfo& runtime_info, const Profile& profile) {
+void BuildASL(Common::ObjectPool<IR::Inst>& inst_pool, Common::ObjectPool<IR::Block>& block_pool,
+              CFG& cfg, Info& info, const RuntimeInfo& runtime_info, const Profile& profile,
+              IR::AbstractSyntaxList& syntax_list) {
     Common::ObjectPool<Statement> stmt_pool{64};
     GotoPass goto_pass{cfg, stmt_pool};
     Statement& root{goto_pass.RootStatement()};
-    IR::AbstractSyntaxList syntax_list;
     TranslatePass{inst_pool,     block_pool, stmt_pool,    root,   syntax_list,
                   cfg.inst_list, info,       runtime_info, profile};
     ASSERT_MSG(!info.translation_failed, "Shader translation has failed");
-    return syntax_list;
 }
 
 } // namespace Shader::Gcn
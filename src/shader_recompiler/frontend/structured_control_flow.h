@@ -16,9 +16,10 @@ struct RuntimeInfo;
 
 namespace Shader::Gcn {
 
-[[nodiscard]] IR::AbstractSyntaxList BuildASL(Common::ObjectPool<IR::Inst>& inst_pool,
-                                              Common::ObjectPool<IR::Block>& block_pool, CFG& cfg,
-                                              Info& info, const RuntimeInfo& runtime_info,
-                                              const Profile& profile);
+/// Structurizes the control flow graph and translates it, appending to the given list so that
+/// the nodes are stored in the memory resource of the caller.
+void BuildASL(Common::ObjectPool<IR::Inst>& inst_pool, Common::ObjectPool<IR::Block>& block_pool,
+              CFG& cfg, Info& info, const RuntimeInfo& runtime_info, const Profile& profile,
+              IR::AbstractSyntaxList& syntax_list);
 
 } // namespace Shader::Gcn
@@ -364,6 +364,7 @@ void Translator::EmitFetch(const GcnInst& inst) {
         file.WriteRaw<u8>(code, fetch_size);
     }
 
+    info.fetch_shader_sgpr = static_cast<s8>(sgpr_base);
     info.vertex_offset_sgpr = fetch_data.vertex_offset_sgpr;
     info.instance_offset_sgpr = fetch_data.instance_offset_sgpr;
 
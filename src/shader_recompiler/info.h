@@ -171,6 +171,7 @@ struct Info {
 
     s8 vertex_offset_sgpr = -1;
     s8 instance_offset_sgpr = -1;
+    s8 fetch_shader_sgpr = -1;
 
     BufferResourceList buffers;
     TextureBufferResourceList texture_buffers;
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <memory_resource>
 #include <vector>
 #include "shader_recompiler/ir/value.h"
 
@@ -51,6 +52,6 @@ struct AbstractSyntaxNode {
     Data data{};
     Type type{};
 };
-using AbstractSyntaxList = std::vector<AbstractSyntaxNode>;
+using AbstractSyntaxList = std::pmr::vector<AbstractSyntaxNode>;
 
 } // namespace Shader::IR
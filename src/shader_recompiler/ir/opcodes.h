@@ -73,8 +73,87 @@ constexpr u8 NUM_ARGS[]{
 #include "opcodes.inc"
 #undef OPCODE
 };
+/// Opcodes whose result only depends on their arguments. They have no side effects and read no
+/// memory or invocation state, so equal instructions always produce equal values.
+constexpr Opcode PURE_OPCODES[]{
+    // Vector utility
+    Opcode::CompositeConstructU32x2, Opcode::CompositeConstructU32x3,
+    Opcode::CompositeConstructU32x4, Opcode::CompositeExtractU32x2, Opcode::CompositeExtractU32x3,
+    Opcode::CompositeExtractU32x4, Opcode::CompositeInsertU32x2, Opcode::CompositeInsertU32x3,
+    Opcode::CompositeInsertU32x4, Opcode::CompositeConstructF16x2, Opcode::CompositeConstructF16x3,
+    Opcode::CompositeConstructF16x4, Opcode::CompositeExtractF16x2, Opcode::CompositeExtractF16x3,
+    Opcode::CompositeExtractF16x4, Opcode::CompositeInsertF16x2, Opcode::CompositeInsertF16x3,
+    Opcode::CompositeInsertF16x4, Opcode::CompositeConstructF32x2, Opcode::CompositeConstructF32x3,
+    Opcode::CompositeConstructF32x4, Opcode::CompositeExtractF32x2, Opcode::CompositeExtractF32x3,
+    Opcode::CompositeExtractF32x4, Opcode::CompositeInsertF32x2, Opcode::CompositeInsertF32x3,
+    Opcode::CompositeInsertF32x4, Opcode::CompositeConstructF64x2, Opcode::CompositeConstructF64x3,
+    Opcode::CompositeConstructF64x4, Opcode::CompositeExtractF64x2, Opcode::CompositeExtractF64x3,
+    Opcode::CompositeExtractF64x4, Opcode::CompositeInsertF64x2, Opcode::CompositeInsertF64x3,
+    Opcode::CompositeInsertF64x4,
+    // Select operations
+    Opcode::SelectU1, Opcode::SelectU8, Opcode::SelectU16, Opcode::SelectU32, Opcode::SelectU64,
+    Opcode::SelectF32, Opcode::SelectF64,
+    // Bitwise conversions
+    Opcode::BitCastU16F16, Opcode::BitCastU32F32, Opcode::BitCastU64F64, Opcode::BitCastF16U16,
+    Opcode::BitCastF32U32, Opcode::BitCastF64U64, Opcode::PackUint2x32, Opcode::UnpackUint2x32,
+    Opcode::PackFloat2x32, Opcode::PackFloat2x16, Opcode::UnpackFloat2x16, Opcode::PackHalf2x16,
+    Opcode::UnpackHalf2x16,
+    // Floating-point operations
+    Opcode::FPAbs32, Opcode::FPAbs64, Opcode::FPAdd32, Opcode::FPAdd64, Opcode::FPSub32,
+    Opcode::FPFma32, Opcode::FPFma64, Opcode::FPMax32, Opcode::FPMax64, Opcode::FPMin32,
+    Opcode::FPMin64, Opcode::FPMul32, Opcode::FPMul64, Opcode::FPNeg32, Opcode::FPNeg64,
+    Opcode::FPRecip32, Opcode::FPRecip64, Opcode::FPRecipSqrt32, Opcode::FPRecipSqrt64,
+    Opcode::FPSqrt, Opcode::FPSin, Opcode::FPExp2, Opcode::FPLdexp, Opcode::FPCos, Opcode::FPLog2,
+    Opcode::FPSaturate32, Opcode::FPSaturate64, Opcode::FPClamp32, Opcode::FPClamp64,
+    Opcode::FPRoundEven32, Opcode::FPRoundEven64, Opcode::FPFloor32, Opcode::FPFloor64,
+    Opcode::FPCeil32, Opcode::FPCeil64, Opcode::FPTrunc32, Opcode::FPTrunc64, Opcode::FPFract,
+    Opcode::FPOrdEqual32, Opcode::FPOrdEqual64, Opcode::FPUnordEqual32, Opcode::FPUnordEqual64,
+    Opcode::FPOrdNotEqual32, Opcode::FPOrdNotEqual64, Opcode::FPUnordNotEqual32,
+    Opcode::FPUnordNotEqual64, Opcode::FPOrdLessThan32, Opcode::FPOrdLessThan64,
+    Opcode::FPUnordLessThan32, Opcode::FPUnordLessThan64, Opcode::FPOrdGreaterThan32,
+    Opcode::FPOrdGreaterThan64, Opcode::FPUnordGreaterThan32, Opcode::FPUnordGreaterThan64,
+    Opcode::FPOrdLessThanEqual32, Opcode::FPOrdLessThanEqual64, Opcode::FPUnordLessThanEqual32,
+    Opcode::FPUnordLessThanEqual64, Opcode::FPOrdGreaterThanEqual32,
+    Opcode::FPOrdGreaterThanEqual64, Opcode::FPUnordGreaterThanEqual32,
+    Opcode::FPUnordGreaterThanEqual64, Opcode::FPIsNan32, Opcode::FPIsNan64, Opcode::FPIsInf32,
+    Opcode::FPIsInf64, Opcode::FPCmpClass32,
+    // Integer operations
+    Opcode::IAdd32, Opcode::IAdd64, Opcode::IAddCary32, Opcode::ISub32, Opcode::ISub64,
+    Opcode::IMul32, Opcode::IMul64, Opcode::SMulExt, Opcode::UMulExt, Opcode::SDiv32,
+    Opcode::UDiv32, Opcode::SMod32, Opcode::UMod32, Opcode::INeg32, Opcode::INeg64, Opcode::IAbs32,
+    Opcode::ShiftLeftLogical32, Opcode::ShiftLeftLogical64, Opcode::ShiftRightLogical32,
+    Opcode::ShiftRightLogical64, Opcode::ShiftRightArithmetic32, Opcode::ShiftRightArithmetic64,
+    Opcode::BitwiseAnd32, Opcode::BitwiseAnd64, Opcode::BitwiseOr32, Opcode::BitwiseOr64,
+    Opcode::BitwiseXor32, Opcode::BitFieldInsert, Opcode::BitFieldSExtract,
+    Opcode::BitFieldUExtract, Opcode::BitReverse32, Opcode::BitCount32, Opcode::BitwiseNot32,
+    Opcode::FindSMsb32, Opcode::FindUMsb32, Opcode::FindILsb32, Opcode::SMin32, Opcode::UMin32,
+    Opcode::SMax32, Opcode::UMax32, Opcode::SClamp32, Opcode::UClamp32, Opcode::SLessThan32,
+    Opcode::SLessThan64, Opcode::ULessThan32, Opcode::ULessThan64, Opcode::IEqual,
+    Opcode::SLessThanEqual, Opcode::ULessThanEqual, Opcode::SGreaterThan, Opcode::UGreaterThan,
+    Opcode::INotEqual, Opcode::SGreaterThanEqual, Opcode::UGreaterThanEqual,
+    // Logical operations
+    Opcode::LogicalOr, Opcode::LogicalAnd, Opcode::LogicalXor, Opcode::LogicalNot,
+    // Conversion operations
+    Opcode::ConvertS32F32, Opcode::ConvertS32F64, Opcode::ConvertU32F32, Opcode::ConvertF16F32,
+    Opcode::ConvertF32F16, Opcode::ConvertF32F64, Opcode::ConvertF64F32, Opcode::ConvertF32S32,
+    Opcode::ConvertF32U32, Opcode::ConvertF64S32, Opcode::ConvertF64U32, Opcode::ConvertF32U16,
+    Opcode::ConvertU16U32, Opcode::ConvertU32U16,
+};
+
+constexpr auto PURE_TABLE = [] {
+    std::array<bool, std::size(META_TABLE)> table{};
+    for (const Opcode op : PURE_OPCODES) {
+        table[static_cast<size_t>(op)] = true;
+    }
+    return table;
+}();
 } // namespace Detail
 
+/// Returns true when the result of an opcode only depends on its arguments
+[[nodiscard]] inline bool IsPure(Opcode op) noexcept {
+    return Detail::PURE_TABLE[static_cast<size_t>(op)];
+}
+
 /// Get return type of an opcode
 [[nodiscard]] inline Type TypeOf(Opcode op) noexcept {
     return Detail::META_TABLE[static_cast<size_t>(op)].type;
@@ -0,0 +1,273 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <bit>
+#include <unordered_set>
+#include <vector>
+#include <boost/container/small_vector.hpp>
+#include <tsl/robin_map.h>
+
+#include "common/logging/log.h"
+#include "shader_recompiler/ir/program.h"
+
+namespace Shader::Optimization {
+
+namespace {
+
+/// Returns true when no resource of the program is written, so memory reads always return the
+/// same value within an invocation. Resources may alias, so a single written one counts.
+bool IsMemoryReadOnly(const Info& info) {
+    return std::ranges::none_of(info.buffers, &BufferResource::is_written) &&
+           std::ranges::none_of(info.texture_buffers, &TextureBufferResource::is_written) &&
+           std::ranges::none_of(info.images, &ImageResource::is_storage);
+}
+
+/// Returns true when equal instructions always produce equal values within an invocation.
+bool CanNumber(IR::Opcode op, bool memory_read_only) {
+    switch (op) {
+    case IR::Opcode::GetUserData:
+    case IR::Opcode::GetAttribute:
+    case IR::Opcode::GetAttributeU32:
+    case IR::Opcode::LaneId:
+    case IR::Opcode::WarpId:
+        return true;
+    case IR::Opcode::ReadConst:
+    case IR::Opcode::ReadConstBuffer:
+        return memory_read_only;
+    default:
+        return IR::IsPure(op);
+    }
+}
+
+bool IsCommutative(IR::Opcode op) {
+    switch (op) {
+    case IR::Opcode::FPAdd32:
+    case IR::Opcode::FPAdd64:
+    case IR::Opcode::FPMul32:
+    case IR::Opcode::FPMul64:
+    case IR::Opcode::FPOrdEqual32:
+    case IR::Opcode::FPOrdEqual64:
+    case IR::Opcode::FPUnordEqual32:
+    case IR::Opcode::FPUnordEqual64:
+    case IR::Opcode::FPOrdNotEqual32:
+    case IR::Opcode::FPOrdNotEqual64:
+    case IR::Opcode::FPUnordNotEqual32:
+    case IR::Opcode::FPUnordNotEqual64:
+    case IR::Opcode::IAdd32:
+    case IR::Opcode::IAdd64:
+    case IR::Opcode::IMul32:
+    case IR::Opcode::IMul64:
+    case IR::Opcode::BitwiseAnd32:
+    case IR::Opcode::BitwiseAnd64:
+    case IR::Opcode::BitwiseOr32:
+    case IR::Opcode::BitwiseOr64:
+    case IR::Opcode::BitwiseXor32:
+    case IR::Opcode::SMin32:
+    case IR::Opcode::UMin32:
+    case IR::Opcode::SMax32:
+    case IR::Opcode::UMax32:
+    case IR::Opcode::IEqual:
+    case IR::Opcode::INotEqual:
+    case IR::Opcode::LogicalOr:
+    case IR::Opcode::LogicalAnd:
+    case IR::Opcode::LogicalXor:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t HashValue(const IR::Value& value) {
+    if (!value.IsImmediate()) {
+        return std::hash<const IR::Inst*>{}(value.InstRecursive());
+    }
+    switch (value.Type()) {
+    case IR::Type::U1:
+        return value.U1();
+    case IR::Type::U8:
+        return value.U8();
+    case IR::Type::U16:
+        return value.U16();
+    case IR::Type::U32:
+        return value.U32();
+    case IR::Type::F32:
+        return std::bit_cast<u32>(value.F32());
+    case IR::Type::U64:
+        return value.U64();
+    case IR::Type::F64:
+        return std::bit_cast<u64>(value.F64());
+    case IR::Type::Attribute:
+        return static_cast<size_t>(value.Attribute());
+    default:
+        return static_cast<size_t>(value.Type());
+    }
+}
+
+struct InstHash {
+    size_t operator()(const IR::Inst* inst) const {
+        const IR::Opcode op = inst->GetOpcode();
+        size_t seed = static_cast<size_t>(op) ^ (size_t(inst->Flags<u32>()) << 16);
+        const auto combine = [&seed](size_t value) {
+            seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        };
+        const size_t num_args = inst->NumArgs();
+        if (IsCommutative(op)) {
+            // Order independent, so that a + b and b + a land in the same bucket.
+            combine(HashValue(inst->Arg(0)) + HashValue(inst->Arg(1)));
+        } else {
+            for (size_t i = 0; i < num_args; ++i) {
+                combine(HashValue(inst->Arg(i)));
+            }
+        }
+        return seed;
+    }
+};
+
+struct InstEqual {
+    bool operator()(const IR::Inst* a, const IR::Inst* b) const {
+        const IR::Opcode op = a->GetOpcode();
+        if (op != b->GetOpcode() || a->Flags<u32>() != b->Flags<u32>()) {
+            return false;
+        }
+        const size_t num_args = a->NumArgs();
+        bool equal = true;
+        for (size_t i = 0; i < num_args && equal; ++i) {
+            equal = a->Arg(i) == b->Arg(i);
+        }
+        if (!equal && IsCommutative(op)) {
+            equal = a->Arg(0) == b->Arg(1) && a->Arg(1) == b->Arg(0);
+        }
+        return equal;
+    }
+};
+
+/// Immediate dominators of the reachable blocks, computed with the iterative algorithm of
+/// Cooper, Harvey and Kennedy over the reverse post order.
+tsl::robin_map<IR::Block*, IR::Block*> ComputeDominators(const IR::BlockList& post_order) {
+    tsl::robin_map<IR::Block*, size_t> po_index;
+    for (size_t i = 0; i < post_order.size(); ++i) {
+        po_index.emplace(post_order[i], i);
+    }
+    IR::Block* const entry = post_order.back();
+    tsl::robin_map<IR::Block*, IR::Block*> idom;
+    idom.emplace(entry, entry);
+
+    const auto intersect = [&](IR::Block* a, IR::Block* b) {
+        while (a != b) {
+            while (po_index.at(a) < po_index.at(b)) {
+                a = idom.at(a);
+            }
+            while (po_index.at(b) < po_index.at(a)) {
+                b = idom.at(b);
+            }
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = post_order.rbegin() + 1; it != post_order.rend(); ++it) {
+            IR::Block* const block = *it;
+            IR::Block* new_idom = nullptr;
+            for (IR::Block* const pred : block->ImmPredecessors()) {
+                if (!idom.contains(pred)) {
+                    // Not processed yet or unreachable.
+                    continue;
+                }
+                new_idom = new_idom ? intersect(pred, new_idom) : pred;
+            }
+            if (!new_idom) {
+                continue;
+            }
+            const auto [idom_it, inserted] = idom.try_emplace(block, new_idom);
+            if (!inserted && idom_it->second != new_idom) {
+                idom_it.value() = new_idom;
+                changed = true;
+            } else if (inserted) {
+                changed = true;
+            }
+        }
+    }
+    return idom;
+}
+
+} // Anonymous namespace
+
+void GlobalValueNumberingPass(IR::Program& program) {
+    const IR::BlockList& post_order = program.post_order_blocks;
+    if (post_order.empty()) {
+        return;
+    }
+
+    // Build the dominator tree.
+    const auto idom = ComputeDominators(post_order);
+    const bool memory_read_only = IsMemoryReadOnly(program.info);
+    tsl::robin_map<IR::Block*, boost::container::small_vector<IR::Block*, 2>> children;
+    for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+        const auto idom_it = idom.find(*it);
+        if (idom_it != idom.end() && idom_it->second != *it) {
+            children[idom_it->second].push_back(*it);
+        }
+    }
+
+    // Walk the dominator tree, an instruction is available to everything its block dominates.
+    std::unordered_set<IR::Inst*, InstHash, InstEqual> available;
+    std::vector<IR::Inst*> scope_insts;
+    struct Frame {
+        IR::Block* block;
+        size_t scope_begin;
+        size_t next_child;
+    };
+    std::vector<Frame> stack;
+    stack.push_back({post_order.back(), 0, 0});
+
+    size_t num_insts{};
+    size_t num_removed{};
+    bool block_entered = false;
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (!block_entered) {
+            frame.scope_begin = scope_insts.size();
+            for (IR::Inst& inst : frame.block->Instructions()) {
+                ++num_insts;
+                if (!CanNumber(inst.GetOpcode(), memory_read_only)) {
+                    continue;
+                }
+                for (size_t i = 0; i < inst.NumArgs(); ++i) {
+                    if (const IR::Value arg = inst.Arg(i); arg.IsIdentity()) {
+                        inst.SetArg(i, arg.Resolve());
+                    }
+                }
+                const auto [it, inserted] = available.insert(&inst);
+                if (inserted) {
+                    scope_insts.push_back(&inst);
+                } else {
+                    inst.ReplaceUsesWith(IR::Value{*it});
+                    ++num_removed;
+                }
+            }
+        }
+        const auto child_it = children.find(frame.block);
+        if (child_it != children.end() && frame.next_child < child_it->second.size()) {
+            IR::Block* const child = child_it->second[frame.next_child++];
+            stack.push_back({child, 0, 0});
+            block_entered = false;
+            continue;
+        }
+        for (size_t i = frame.scope_begin; i < scope_insts.size(); ++i) {
+            available.erase(scope_insts[i]);
+        }
+        scope_insts.resize(frame.scope_begin);
+        stack.pop_back();
+        block_entered = true;
+    }
+
+    if (num_removed != 0) {
+        LOG_DEBUG(Render_Recompiler, "Value numbering removed {} of {} instructions of {:#x}",
+                  num_removed, num_insts, program.info.pgm_hash);
+    }
+}
+
+} // namespace Shader::Optimization
@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <unordered_set>
+
+#include "common/logging/log.h"
+#include "shader_recompiler/ir/program.h"
+
+namespace Shader::Optimization {
+
+namespace {
+
+enum class Uniformity {
+    Divergent,     ///< May differ between invocations of a subgroup
+    Uniform,       ///< Always the same for the whole subgroup
+    FollowArgs,    ///< Uniform when all arguments are uniform
+    FollowControl, ///< Uniform when all arguments and the control flow are uniform (phis)
+};
+
+Uniformity UniformityOf(const IR::Inst& inst) {
+    switch (inst.GetOpcode()) {
+    case IR::Opcode::ReadFirstLane:
+    case IR::Opcode::ReadLane:
+    case IR::Opcode::WarpId:
+        return Uniformity::Uniform;
+    case IR::Opcode::Phi:
+        return Uniformity::FollowControl;
+    case IR::Opcode::Identity:
+    case IR::Opcode::ConditionRef:
+    case IR::Opcode::GetUserData:
+    case IR::Opcode::ReadConst:
+    case IR::Opcode::ReadConstBuffer:
+        return Uniformity::FollowArgs;
+    case IR::Opcode::GetAttributeU32:
+        return inst.Arg(0).Attribute() == IR::Attribute::WorkgroupId ? Uniformity::FollowArgs
+                                                                      : Uniformity::Divergent;
+    default:
+        return IR::IsPure(inst.GetOpcode()) ? Uniformity::FollowArgs : Uniformity::Divergent;
+    }
+}
+
+class DivergenceAnalysis {
+public:
+    explicit DivergenceAnalysis(const IR::Program& program) {
+        // Optimistically assume uniformity and propagate divergence until nothing changes.
+        // Phis are only uniform while all branch conditions of the program are, which is
+        // conservative but keeps values that differ per loop trip count or branch divergent.
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto it = program.post_order_blocks.rbegin();
+                 it != program.post_order_blocks.rend(); ++it) {
+                for (const IR::Inst& inst : (*it)->Instructions()) {
+                    if (!divergent.contains(&inst) && IsDivergent(inst)) {
+                        divergent.insert(&inst);
+                        changed = true;
+                    }
+                }
+            }
+            if (!divergent_control && HasDivergentCondition(program.syntax_list)) {
+                divergent_control = true;
+                changed = true;
+            }
+        }
+    }
+
+    [[nodiscard]] bool IsUniform(const IR::Value& value) const {
+        return value.IsImmediate() || !divergent.contains(value.InstRecursive());
+    }
+
+private:
+    bool IsDivergent(const IR::Inst& inst) const {
+        switch (UniformityOf(inst)) {
+        case Uniformity::Divergent:
+            return true;
+        case Uniformity::Uniform:
+            return false;
+        case Uniformity::FollowControl:
+            if (divergent_control) {
+                return true;
+            }
+            [[fallthrough]];
+        case Uniformity::FollowArgs:
+            for (size_t i = 0; i < inst.NumArgs(); ++i) {
+                if (!IsUniform(inst.Arg(i))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return true;
+    }
+
+    bool HasDivergentCondition(const IR::AbstractSyntaxList& syntax_list) const {
+        for (const auto& node : syntax_list) {
+            switch (node.type) {
+            case IR::AbstractSyntaxNode::Type::If:
+                if (!IsUniform(node.data.if_node.cond)) {
+                    return true;
+                }
+                break;
+            case IR::AbstractSyntaxNode::Type::Repeat:
+                if (!IsUniform(node.data.repeat.cond)) {
+                    return true;
+                }
+                break;
+            case IR::AbstractSyntaxNode::Type::Break:
+                if (!IsUniform(node.data.break_node.cond)) {
+                    return true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        return false;
+    }
+
+    std::unordered_set<const IR::Inst*> divergent;
+    bool divergent_control{};
+};
+
+} // Anonymous namespace
+
+void UniformityAnalysisPass(IR::Program& program) {
+    const DivergenceAnalysis analysis{program};
+
+    // Reading a lane of a value that is the same in every invocation yields the value itself,
+    // so the subgroup operation can be skipped.
+    u32 num_removed{};
+    for (IR::Block* const block : program.blocks) {
+        for (IR::Inst& inst : block->Instructions()) {
+            const IR::Opcode op = inst.GetOpcode();
+            if (op != IR::Opcode::ReadFirstLane && op != IR::Opcode::ReadLane) {
+                continue;
+            }
+            if (const IR::Value value = inst.Arg(0); analysis.IsUniform(value)) {
+                inst.ReplaceUsesWith(value);
+                ++num_removed;
+            }
+        }
+    }
+    if (num_removed != 0) {
+        LOG_DEBUG(Render_Recompiler, "Removed {} subgroup reads of uniform values from {:#x}",
+                  num_removed, program.info.pgm_hash);
+    }
+}
+
+} // namespace Shader::Optimization
@@ -30,6 +30,8 @@ struct Profile {
     bool has_broken_spirv_clamp{};
     bool lower_left_origin_mode{};
     u64 min_ssbo_alignment{};
+
+    bool operator==(const Profile&) const = default;
 };
 
 } // namespace Shader
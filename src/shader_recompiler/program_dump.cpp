@@ -0,0 +1,258 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "shader_recompiler/frontend/fetch_shader.h"
+#include "shader_recompiler/program_dump.h"
+
+namespace Shader {
+
+namespace {
+
+constexpr u32 DumpMagic = 0x50445053; // "SPDP"
+constexpr u32 DumpVersion = 2;
+
+/// Mask applied by Info::ReadUd to pointers stored in user data.
+constexpr u64 PointerMask = 0xFFFFFFFFFFFFULL;
+
+class Writer {
+public:
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    void Write(const T& value) {
+        const auto* bytes = reinterpret_cast<const u8*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename Container>
+    void WriteList(const Container& list) {
+        Write<u32>(static_cast<u32>(list.size()));
+        for (const auto& elem : list) {
+            Write(elem);
+        }
+    }
+
+    std::vector<u8> data;
+};
+
+class Reader {
+public:
+    explicit Reader(std::span<const u8> data_) : data{data_} {}
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    bool Read(T& value) {
+        if (data.size() - pos < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    template <typename Container>
+    bool ReadList(Container& list) {
+        u32 size{};
+        if (!Read(size) || size > list.max_size() || size > data.size() - pos) {
+            return false;
+        }
+        list.resize(size);
+        for (auto& elem : list) {
+            if (!Read(elem)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool AtEnd() const noexcept {
+        return pos == data.size();
+    }
+
+private:
+    std::span<const u8> data;
+    size_t pos{};
+};
+
+/// Profile is written field by field so that its padding bytes never reach the dump.
+void WriteProfile(Writer& writer, const Profile& profile) {
+    writer.Write(profile.supported_spirv);
+    writer.Write(profile.subgroup_size);
+    writer.Write(profile.unified_descriptor_binding);
+    writer.Write(profile.support_descriptor_aliasing);
+    writer.Write(profile.support_int8);
+    writer.Write(profile.support_int16);
+    writer.Write(profile.support_int64);
+    writer.Write(profile.support_vertex_instance_id);
+    writer.Write(profile.support_float_controls);
+    writer.Write(profile.support_separate_denorm_behavior);
+    writer.Write(profile.support_separate_rounding_mode);
+    writer.Write(profile.support_fp16_denorm_preserve);
+    writer.Write(profile.support_fp32_denorm_preserve);
+    writer.Write(profile.support_fp16_denorm_flush);
+    writer.Write(profile.support_fp32_denorm_flush);
+    writer.Write(profile.support_fp16_signed_zero_nan_preserve);
+    writer.Write(profile.support_fp32_signed_zero_nan_preserve);
+    writer.Write(profile.support_fp64_signed_zero_nan_preserve);
+    writer.Write(profile.support_explicit_workgroup_layout);
+    writer.Write(profile.has_broken_spirv_clamp);
+    writer.Write(profile.lower_left_origin_mode);
+    writer.Write(profile.min_ssbo_alignment);
+}
+
+bool ReadProfile(Reader& reader, Profile& profile) {
+    return reader.Read(profile.supported_spirv) && reader.Read(profile.subgroup_size) &&
+           reader.Read(profile.unified_descriptor_binding) &&
+           reader.Read(profile.support_descriptor_aliasing) && reader.Read(profile.support_int8) &&
+           reader.Read(profile.support_int16) && reader.Read(profile.support_int64) &&
+           reader.Read(profile.support_vertex_instance_id) &&
+           reader.Read(profile.support_float_controls) &&
+           reader.Read(profile.support_separate_denorm_behavior) &&
+           reader.Read(profile.support_separate_rounding_mode) &&
+           reader.Read(profile.support_fp16_denorm_preserve) &&
+           reader.Read(profile.support_fp32_denorm_preserve) &&
+           reader.Read(profile.support_fp16_denorm_flush) &&
+           reader.Read(profile.support_fp32_denorm_flush) &&
+           reader.Read(profile.support_fp16_signed_zero_nan_preserve) &&
+           reader.Read(profile.support_fp32_signed_zero_nan_preserve) &&
+           reader.Read(profile.support_fp64_signed_zero_nan_preserve) &&
+           reader.Read(profile.support_explicit_workgroup_layout) &&
+           reader.Read(profile.has_broken_spirv_clamp) &&
+           reader.Read(profile.lower_left_origin_mode) && reader.Read(profile.min_ssbo_alignment);
+}
+
+const u32* UserDataPointer(std::span<const u32> user_data, u32 sgpr) {
+    u64 address{};
+    std::memcpy(&address, &user_data[sgpr], sizeof(address));
+    return reinterpret_cast<const u32*>(address & PointerMask);
+}
+
+} // Anonymous namespace
+
+ProgramDump ProgramDump::Capture(const Info& info, const RuntimeInfo& runtime_info,
+                                 const Profile& profile) {
+    ProgramDump dump{};
+    dump.stage = info.stage;
+    dump.pgm_hash = info.pgm_hash;
+    dump.profile = profile;
+    dump.runtime_info = runtime_info;
+    std::copy_n(info.user_data.begin(), std::min(info.user_data.size(), NumUserDataRegs),
+                dump.user_data.begin());
+
+    // Find out how many dwords the program reads through each user data pointer. Resources
+    // with an sgpr base past the user data are read from the registers directly.
+    std::array<u32, NumUserDataRegs> extents{};
+    const auto add_read = [&](u32 sgpr_base, u32 dword_offset, size_t size) {
+        if (sgpr_base + 1 < NumUserDataRegs) {
+            const u32 end = dword_offset + static_cast<u32>(size / sizeof(u32));
+            extents[sgpr_base] = std::max(extents[sgpr_base], end);
+        }
+    };
+    for (const auto& buffer : info.buffers) {
+        if (!buffer.inline_cbuf) {
+            add_read(buffer.sgpr_base, buffer.dword_offset, sizeof(AmdGpu::Buffer));
+        }
+    }
+    for (const auto& tex_buffer : info.texture_buffers) {
+        add_read(tex_buffer.sgpr_base, tex_buffer.dword_offset, sizeof(AmdGpu::Buffer));
+    }
+    for (const auto& image : info.images) {
+        add_read(image.sgpr_base, image.dword_offset, sizeof(AmdGpu::Image));
+    }
+    for (const auto& sampler : info.samplers) {
+        if (!sampler.inline_sampler) {
+            add_read(sampler.sgpr_base, sampler.dword_offset, sizeof(AmdGpu::Sampler));
+        }
+    }
+    for (const auto& input : info.vs_inputs) {
+        add_read(input.sgpr_base, input.dword_offset, sizeof(AmdGpu::Buffer));
+    }
+    if (info.fetch_shader_sgpr != -1) {
+        u32 fetch_size{};
+        const u32 sgpr = static_cast<u32>(info.fetch_shader_sgpr);
+        Gcn::ParseFetchShader(UserDataPointer(info.user_data, sgpr), &fetch_size);
+        add_read(sgpr, 0, fetch_size);
+    }
+
+    for (u32 sgpr = 0; sgpr < NumUserDataRegs; sgpr++) {
+        if (extents[sgpr] == 0) {
+            continue;
+        }
+        const u32* memory = UserDataPointer(info.user_data, sgpr);
+        dump.memory.push_back({sgpr, std::vector<u32>(memory, memory + extents[sgpr])});
+    }
+    return dump;
+}
+
+std::vector<u8> ProgramDump::Serialize() const {
+    Writer writer;
+    writer.Write(DumpMagic);
+    writer.Write(DumpVersion);
+    writer.Write(stage);
+    writer.Write(pgm_hash);
+    WriteProfile(writer, profile);
+    writer.Write(runtime_info.num_user_data);
+    writer.Write(runtime_info.num_input_vgprs);
+    writer.Write(runtime_info.num_allocated_vgprs);
+    writer.WriteList(runtime_info.vs_info.outputs);
+    writer.Write(runtime_info.vs_info.emulate_depth_negative_one_to_one);
+    writer.WriteList(runtime_info.fs_info.inputs);
+    writer.Write(runtime_info.fs_info.color_buffers);
+    writer.Write(runtime_info.cs_info);
+    writer.Write(user_data);
+    writer.Write(static_cast<u32>(memory.size()));
+    for (const auto& range : memory) {
+        writer.Write(range.sgpr_base);
+        writer.WriteList(range.data);
+    }
+    return std::move(writer.data);
+}
+
+std::optional<ProgramDump> ProgramDump::Deserialize(std::span<const u8> data) {
+    Reader reader{data};
+    u32 magic{};
+    u32 version{};
+    if (!reader.Read(magic) || !reader.Read(version) || magic != DumpMagic ||
+        version != DumpVersion) {
+        return std::nullopt;
+    }
+
+    ProgramDump dump{};
+    auto& runtime_info = dump.runtime_info;
+    bool ok = reader.Read(dump.stage) && reader.Read(dump.pgm_hash) &&
+              ReadProfile(reader, dump.profile) && reader.Read(runtime_info.num_user_data) &&
+              reader.Read(runtime_info.num_input_vgprs) &&
+              reader.Read(runtime_info.num_allocated_vgprs) &&
+              reader.ReadList(runtime_info.vs_info.outputs) &&
+              reader.Read(runtime_info.vs_info.emulate_depth_negative_one_to_one) &&
+              reader.ReadList(runtime_info.fs_info.inputs) &&
+              reader.Read(runtime_info.fs_info.color_buffers) &&
+              reader.Read(runtime_info.cs_info) && reader.Read(dump.user_data);
+    u32 num_ranges{};
+    ok = ok && reader.Read(num_ranges) && num_ranges <= NumUserDataRegs;
+    for (u32 i = 0; ok && i < num_ranges; i++) {
+        auto& range = dump.memory.emplace_back();
+        ok = reader.Read(range.sgpr_base) && range.sgpr_base + 1 < NumUserDataRegs &&
+             reader.ReadList(range.data);
+    }
+    if (!ok || !reader.AtEnd()) {
+        return std::nullopt;
+    }
+    runtime_info.stage = dump.stage;
+    return dump;
+}
+
+std::array<u32, NumUserDataRegs> ProgramDump::RelocatedUserData() const {
+    auto relocated = user_data;
+    for (const auto& range : memory) {
+        const u64 address = reinterpret_cast<u64>(range.data.data());
+        ASSERT_MSG((address & PointerMask) == address, "Host pointer does not fit in user data");
+        std::memcpy(&relocated[range.sgpr_base], &address, sizeof(address));
+    }
+    return relocated;
+}
+
+} // namespace Shader
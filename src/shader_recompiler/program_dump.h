@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "common/types.h"
+#include "shader_recompiler/info.h"
+#include "shader_recompiler/profile.h"
+#include "shader_recompiler/runtime_info.h"
+
+namespace Shader {
+
+/**
+ * Translation inputs of a program besides its code, written next to dumped shaders so that
+ * they can be recompiled offline. Guest memory is not available offline, so the memory read
+ * through user data pointers (sharp tables and the fetch shader) is captured along with it.
+ */
+struct ProgramDump {
+    struct MemoryRange {
+        u32 sgpr_base;         ///< User data register holding the pointer to the memory
+        std::vector<u32> data; ///< Dwords at the start of the pointed memory
+    };
+
+    Stage stage{};
+    u64 pgm_hash{};
+    Profile profile{};
+    RuntimeInfo runtime_info{Stage::Compute};
+    std::array<u32, NumUserDataRegs> user_data{};
+    std::vector<MemoryRange> memory;
+
+    /// Captures the inputs of a program after it has been translated.
+    [[nodiscard]] static ProgramDump Capture(const Info& info, const RuntimeInfo& runtime_info,
+                                             const Profile& profile);
+
+    [[nodiscard]] std::vector<u8> Serialize() const;
+
+    /// Parses a serialized dump. Returns std::nullopt when the data is malformed or was written
+    /// by an incompatible version.
+    [[nodiscard]] static std::optional<ProgramDump> Deserialize(std::span<const u8> data);
+
+    /// Returns the user data with the captured pointers redirected to the captured memory.
+    /// The result is only valid as long as the dump is alive and unmodified.
+    [[nodiscard]] std::array<u32, NumUserDataRegs> RelocatedUserData() const;
+};
+
+} // namespace Shader
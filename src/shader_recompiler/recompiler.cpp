@@ -1,6 +1,8 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <chrono>
+
 #include "shader_recompiler/frontend/control_flow_graph.h"
 #include "shader_recompiler/frontend/decode.h"
 #include "shader_recompiler/frontend/structured_control_flow.h"
@@ -28,45 +30,88 @@ IR::BlockList GenerateBlocks(const IR::AbstractSyntaxList& syntax_list) {
     return blocks;
 }
 
+/// Records the time elapsed since the previous step when timings were requested.
+class StepTimer {
+public:
+    explicit StepTimer(TranslateTimings* timings_) : timings{timings_} {
+        if (timings) {
+            timings->steps.clear();
+            start = Clock::now();
+        }
+    }
+
+    void Mark(std::string_view step) {
+        if (!timings) {
+            return;
+        }
+        const auto now = Clock::now();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start);
+        timings->steps.emplace_back(step, elapsed.count());
+        start = now;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    TranslateTimings* timings;
+    Clock::time_point start{};
+};
+
 IR::Program TranslateProgram(std::span<const u32> code, Pools& pools, Info& info,
-                             const RuntimeInfo& runtime_info, const Profile& profile) {
+                             const RuntimeInfo& runtime_info, const Profile& profile,
+                             TranslateTimings* timings) {
+    StepTimer timer{timings};
+
     // Ensure first instruction is expected.
     constexpr u32 token_mov_vcchi = 0xBEEB03FF;
     ASSERT_MSG(code[0] == token_mov_vcchi, "First instruction is not s_mov_b32 vcc_hi, #imm");
 
+    // Clear any previous pooled data, the program is allocated from the pools.
+    pools.ReleaseContents();
+
     Gcn::GcnCodeSlice slice(code.data(), code.data() + code.size());
     Gcn::GcnDecodeContext decoder;
 
     // Decode and save instructions
-    IR::Program program{info};
+    IR::Program program{info, &pools.arena};
     program.ins_list.reserve(code.size());
     while (!slice.atEnd()) {
         program.ins_list.emplace_back(decoder.decodeInstruction(slice));
     }
-
-    // Clear any previous pooled data.
-    pools.ReleaseContents();
+    timer.Mark("decode");
 
     // Create control flow graph
-    Common::ObjectPool<Gcn::Block> gcn_block_pool{64};
-    Gcn::CFG cfg{gcn_block_pool, program.ins_list};
+    Gcn::CFG cfg{pools.gcn_block_pool, program.ins_list};
+    timer.Mark("cfg");
 
     // Structurize control flow graph and create program.
-    program.syntax_list = Shader::Gcn::BuildASL(pools.inst_pool, pools.block_pool, cfg,
-                                                program.info, runtime_info, profile);
+    Shader::Gcn::BuildASL(pools.inst_pool, pools.block_pool, cfg, program.info, runtime_info,
+                          profile, program.syntax_list);
     program.blocks = GenerateBlocks(program.syntax_list);
     program.post_order_blocks = Shader::IR::PostOrder(program.syntax_list.front());
+    timer.Mark("structurize");
 
     // Run optimization passes
     Shader::Optimization::SsaRewritePass(program.post_order_blocks);
+    timer.Mark("ssa_rewrite");
     Shader::Optimization::ConstantPropagationPass(program.post_order_blocks);
+    timer.Mark("constant_propagation");
     if (program.info.stage != Stage::Compute) {
         Shader::Optimization::LowerSharedMemToRegisters(program);
+        timer.Mark("lower_shared_mem");
     }
     Shader::Optimization::ResourceTrackingPass(program);
+    timer.Mark("resource_tracking");
+    Shader::Optimization::UniformityAnalysisPass(program);
+    timer.Mark("uniformity_analysis");
+    Shader::Optimization::GlobalValueNumberingPass(program);
+    timer.Mark("global_value_numbering");
     Shader::Optimization::IdentityRemovalPass(program.blocks);
+    timer.Mark("identity_removal");
     Shader::Optimization::DeadCodeEliminationPass(program);
+    timer.Mark("dead_code_elimination");
     Shader::Optimization::CollectShaderInfoPass(program);
+    timer.Mark("collect_shader_info");
 
     return program;
 }
@@ -3,7 +3,12 @@
 
 #pragma once
 
+#include <string_view>
+#include <boost/container/static_vector.hpp>
+
+#include "common/arena.h"
 #include "common/object_pool.h"
+#include "shader_recompiler/frontend/control_flow_graph.h"
 #include "shader_recompiler/ir/basic_block.h"
 #include "shader_recompiler/ir/program.h"
 
@@ -12,22 +17,38 @@ namespace Shader {
 struct Profile;
 struct RuntimeInfo;
 
+/// Per-thread storage reused across translations. Everything allocated from it is released
+/// by the next translation, the program returned must not outlive it.
 struct Pools {
     static constexpr u32 InstPoolSize = 8192;
     static constexpr u32 BlockPoolSize = 32;
+    static constexpr u32 GcnBlockPoolSize = 64;
 
     Common::ObjectPool<IR::Inst> inst_pool;
     Common::ObjectPool<IR::Block> block_pool;
+    Common::ObjectPool<Gcn::Block> gcn_block_pool;
+    Common::Arena arena; ///< Decoded instructions and the syntax list
 
-    explicit Pools() : inst_pool{InstPoolSize}, block_pool{BlockPoolSize} {}
+    explicit Pools()
+        : inst_pool{InstPoolSize}, block_pool{BlockPoolSize}, gcn_block_pool{GcnBlockPoolSize} {}
 
     void ReleaseContents() {
         inst_pool.ReleaseContents();
         block_pool.ReleaseContents();
+        gcn_block_pool.ReleaseContents();
+        arena.Reset();
     }
 };
 
+/// Time spent in each step of a translation, in nanoseconds.
+struct TranslateTimings {
+    static constexpr size_t MaxSteps = 16;
+
+    boost::container::static_vector<std::pair<std::string_view, u64>, MaxSteps> steps;
+};
+
 [[nodiscard]] IR::Program TranslateProgram(std::span<const u32> code, Pools& pools, Info& info,
-                                           const RuntimeInfo& runtime_info, const Profile& profile);
+                                           const RuntimeInfo& runtime_info, const Profile& profile,
+                                           TranslateTimings* timings = nullptr);
 
 } // namespace Shader
@@ -107,6 +107,54 @@ struct StageSpecialization {
         }
         return true;
     }
+
+    /// Returns a hash of the specialization that is stable across runs, for use as a
+    /// persistent cache key. Specializations that compare equal have the same hash as long
+    /// as they bind the same set of resources.
+    [[nodiscard]] u64 Hash() const noexcept {
+        u64 seed{};
+        const auto combine = [&seed](u64 value) {
+            seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        };
+        combine(static_cast<u64>(runtime_info.stage));
+        combine(start.unified);
+        combine(start.buffer);
+        combine(start.user_data);
+        switch (runtime_info.stage) {
+        case Stage::Fragment:
+            for (const auto& input : runtime_info.fs_info.inputs) {
+                combine(input.param_index | (u32(input.is_default) << 8) |
+                        (u32(input.is_flat) << 9) | (u32(input.default_value) << 16));
+            }
+            for (const auto& cb : runtime_info.fs_info.color_buffers) {
+                combine(static_cast<u32>(cb.num_format) | (static_cast<u32>(cb.mrt_swizzle) << 8));
+            }
+            break;
+        case Stage::Vertex:
+            combine(runtime_info.vs_info.emulate_depth_negative_one_to_one);
+            break;
+        case Stage::Compute:
+            for (u32 i = 0; i < 3; i++) {
+                combine(runtime_info.cs_info.workgroup_size[i]);
+                combine(runtime_info.cs_info.tgid_enable[i]);
+            }
+            break;
+        default:
+            break;
+        }
+        u32 binding{};
+        for (const auto& buffer : buffers) {
+            combine(bitset[binding++] ? (buffer.stride | (u32(buffer.is_storage) << 14)) : ~0U);
+        }
+        for (const auto& tex_buffer : tex_buffers) {
+            combine(bitset[binding++] ? u32(tex_buffer.is_integer) : ~0U);
+        }
+        for (const auto& image : images) {
+            const u32 value = static_cast<u32>(image.type) | (u32(image.is_integer) << 8);
+            combine(bitset[binding++] ? value : ~0U);
+        }
+        return seed;
+    }
 };
 
 } // namespace Shader
@@ -0,0 +1,364 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Recompiles shaders dumped by the emulator without a GPU or a running title. Every dumped
+// program (<stage>_<hash>_<perm>.bin) is translated and emitted to SPIR-V using the inputs
+// stored next to it (.ctx), the output is checked and per-step timings are reported. With -d
+// the programs are only decoded, to benchmark the instruction decoder on its own.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/core.h>
+
+#include "common/assert.h"
+#include "common/io_file.h"
+#include "common/logging/backend.h"
+#include "common/thread.h"
+#include "shader_recompiler/backend/spirv/emit_spirv.h"
+#include "shader_recompiler/frontend/decode.h"
+#include "shader_recompiler/program_dump.h"
+#include "shader_recompiler/recompiler.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr u32 SpirvMagic = 0x07230203;
+constexpr u32 SpirvOpMemoryModel = 14;
+constexpr u32 SpirvOpEntryPoint = 15;
+
+struct Options {
+    u32 num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    u32 iterations = 1;
+    bool decode_only = false;
+    std::optional<std::filesystem::path> output_dir;
+    std::vector<std::filesystem::path> inputs;
+};
+
+struct Job {
+    std::filesystem::path path;
+    std::vector<u32> code;
+    Shader::ProgramDump dump;
+};
+
+struct Stats {
+    std::vector<std::pair<std::string_view, u64>> steps; ///< Total nanoseconds per step
+    u64 num_compiled{};
+    u64 num_decoded{}; ///< GCN instructions decoded
+    u64 num_insts{};   ///< IR instructions left after optimization
+    u64 spirv_words{}; ///< Size of the emitted modules
+    u64 arena_bytes{}; ///< Translation memory taken from the per-thread arenas
+    u64 peak_arena_bytes{};
+    std::vector<std::string> failures;
+
+    void AddStep(std::string_view name, u64 ns) {
+        const auto it = std::ranges::find(steps, name, &std::pair<std::string_view, u64>::first);
+        if (it == steps.end()) {
+            steps.emplace_back(name, ns);
+        } else {
+            it->second += ns;
+        }
+    }
+
+    void Merge(const Stats& other) {
+        for (const auto& [name, ns] : other.steps) {
+            AddStep(name, ns);
+        }
+        num_compiled += other.num_compiled;
+        num_decoded += other.num_decoded;
+        num_insts += other.num_insts;
+        spirv_words += other.spirv_words;
+        arena_bytes += other.arena_bytes;
+        peak_arena_bytes = std::max(peak_arena_bytes, other.peak_arena_bytes);
+        failures.insert(failures.end(), other.failures.begin(), other.failures.end());
+    }
+};
+
+void PrintUsage(const char* program) {
+    fmt::print("Usage: {} [options] <dump directory or .bin files...>\n"
+               "  -j <threads>     Number of compiler threads (default: all cores)\n"
+               "  -n <iterations>  Times every shader is compiled (default: 1)\n"
+               "  -d               Only decode the shaders\n"
+               "  -o <directory>   Write the generated SPIR-V to the directory\n",
+               program);
+}
+
+std::optional<Options> ParseOptions(int argc, char* argv[]) {
+    Options options{};
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg{argv[i]};
+        const bool has_value = i + 1 < argc;
+        if (arg == "-j" && has_value) {
+            options.num_threads = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-n" && has_value) {
+            options.iterations = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-d") {
+            options.decode_only = true;
+        } else if (arg == "-o" && has_value) {
+            options.output_dir = argv[++i];
+        } else if (arg.starts_with('-')) {
+            return std::nullopt;
+        } else {
+            options.inputs.emplace_back(arg);
+        }
+    }
+    if (options.inputs.empty()) {
+        return std::nullopt;
+    }
+    return options;
+}
+
+template <typename T>
+std::optional<std::vector<T>> ReadFile(const std::filesystem::path& path) {
+    const Common::FS::IOFile file{path, Common::FS::FileAccessMode::Read};
+    if (!file.IsOpen()) {
+        return std::nullopt;
+    }
+    std::vector<T> data(file.GetSize() / sizeof(T));
+    if (file.ReadSpan(std::span{data}) != data.size()) {
+        return std::nullopt;
+    }
+    return data;
+}
+
+std::vector<std::filesystem::path> CollectPrograms(const Options& options) {
+    std::vector<std::filesystem::path> programs;
+    const auto add = [&](const std::filesystem::path& path) {
+        // Fetch shaders are dumped next to the vertex shaders that call them.
+        if (path.extension() == ".bin" && !path.stem().string().ends_with("_fetch")) {
+            programs.push_back(path);
+        }
+    };
+    for (const auto& input : options.inputs) {
+        if (!std::filesystem::is_directory(input)) {
+            add(input);
+            continue;
+        }
+        for (const auto& entry : std::filesystem::directory_iterator{input}) {
+            if (entry.is_regular_file()) {
+                add(entry.path());
+            }
+        }
+    }
+    std::ranges::sort(programs);
+    return programs;
+}
+
+/// Checks the module header and that the instruction stream is well formed. Semantic
+/// validation is left to spirv-val, which can be run on the modules written with -o.
+std::optional<std::string> CheckSpirv(std::span<const u32> spv) {
+    if (spv.size() < 5 || spv[0] != SpirvMagic) {
+        return "invalid module header";
+    }
+    if (spv[3] == 0) {
+        return "module has no id bound";
+    }
+    bool has_memory_model = false;
+    bool has_entry_point = false;
+    for (size_t pos = 5; pos < spv.size();) {
+        const u32 word_count = spv[pos] >> 16;
+        const u32 opcode = spv[pos] & 0xFFFF;
+        if (word_count == 0 || pos + word_count > spv.size()) {
+            return fmt::format("malformed instruction at word {}", pos);
+        }
+        has_memory_model |= opcode == SpirvOpMemoryModel;
+        has_entry_point |= opcode == SpirvOpEntryPoint;
+        pos += word_count;
+    }
+    if (!has_memory_model || !has_entry_point) {
+        return "module has no memory model or entry point";
+    }
+    return std::nullopt;
+}
+
+u64 ElapsedNs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+void DecodeJob(const Job& job, Stats& stats) {
+    Shader::Gcn::GcnCodeSlice slice(job.code.data(), job.code.data() + job.code.size());
+    Shader::Gcn::GcnDecodeContext decoder;
+    u64 num_insts{};
+    u64 num_dwords{};
+    const auto start = Clock::now();
+    while (!slice.atEnd()) {
+        num_dwords += decoder.decodeInstruction(slice).length / sizeof(u32);
+        ++num_insts;
+    }
+    stats.AddStep("decode", ElapsedNs(start));
+    ASSERT(num_dwords == job.code.size());
+    ++stats.num_compiled;
+    stats.num_decoded += num_insts;
+}
+
+void CompileJob(const Job& job, const Options& options, Shader::Pools& pools, Stats& stats) {
+    // Sharps are read through pointers in user data, point them at the captured memory.
+    const auto user_data = job.dump.RelocatedUserData();
+    const Shader::ShaderParams params{user_data, job.code, job.dump.pgm_hash};
+    Shader::Info info{job.dump.stage, params};
+
+    Shader::TranslateTimings timings{};
+    const auto program = Shader::TranslateProgram(job.code, pools, info, job.dump.runtime_info,
+                                                  job.dump.profile, &timings);
+    for (const auto& [name, ns] : timings.steps) {
+        stats.AddStep(name, ns);
+    }
+    const u64 arena_bytes = pools.arena.UsedBytes();
+
+    Shader::Backend::Bindings binding{};
+    const auto emit_start = Clock::now();
+    const auto spv = Shader::Backend::SPIRV::EmitSPIRV(job.dump.profile, job.dump.runtime_info,
+                                                       program, binding);
+    stats.AddStep("spirv_emit", ElapsedNs(emit_start));
+
+    if (const auto error = CheckSpirv(spv)) {
+        stats.failures.push_back(fmt::format("{}: {}", job.path.filename().string(), *error));
+        return;
+    }
+    ++stats.num_compiled;
+    stats.num_decoded += program.ins_list.size();
+    for (const Shader::IR::Block* block : program.blocks) {
+        stats.num_insts += block->size();
+    }
+    stats.spirv_words += spv.size();
+    stats.arena_bytes += arena_bytes;
+    stats.peak_arena_bytes = std::max(stats.peak_arena_bytes, arena_bytes);
+
+    if (options.output_dir) {
+        auto spv_path = *options.output_dir / job.path.filename();
+        spv_path.replace_extension(".spv");
+        const Common::FS::IOFile file{spv_path, Common::FS::FileAccessMode::Write};
+        file.WriteSpan(std::span{spv});
+    }
+}
+
+void PrintReport(const Stats& stats, size_t num_jobs, u32 iterations, double wall_ms) {
+    const u64 total_ns = [&] {
+        u64 total{};
+        for (const auto& [name, ns] : stats.steps) {
+            total += ns;
+        }
+        return total;
+    }();
+    const u64 num_runs = std::max<u64>(num_jobs * iterations, 1);
+
+    fmt::print("{:<24} {:>12} {:>12} {:>8}\n", "step", "total (ms)", "mean (us)", "share");
+    for (const auto& [name, ns] : stats.steps) {
+        fmt::print("{:<24} {:>12.3f} {:>12.3f} {:>7.1f}%\n", name, ns / 1e6,
+                   ns / 1e3 / num_runs, total_ns ? 100.0 * ns / total_ns : 0.0);
+    }
+    fmt::print("{:<24} {:>12.3f} {:>12.3f}\n", "total (cpu)", total_ns / 1e6,
+               total_ns / 1e3 / num_runs);
+    fmt::print("\n{} shaders x {} iterations in {:.3f} ms wall time, {} compiled, {} failed\n",
+               num_jobs, iterations, wall_ms, stats.num_compiled, stats.failures.size());
+    const auto decode_it = std::ranges::find(stats.steps, std::string_view{"decode"},
+                                             &std::pair<std::string_view, u64>::first);
+    if (decode_it != stats.steps.end() && decode_it->second != 0) {
+        fmt::print("{} GCN instructions decoded, {:.2f} M instructions/s per thread\n",
+                   stats.num_decoded, stats.num_decoded * 1e3 / decode_it->second);
+    }
+    if (stats.num_compiled != 0 && stats.spirv_words != 0) {
+        fmt::print("{:.1f} IR instructions and {:.1f} SPIR-V words per shader\n",
+                   double(stats.num_insts) / stats.num_compiled,
+                   double(stats.spirv_words) / stats.num_compiled);
+        fmt::print("{:.1f} KiB of arena memory per shader, {:.1f} KiB peak\n",
+                   stats.arena_bytes / 1024.0 / stats.num_compiled,
+                   stats.peak_arena_bytes / 1024.0);
+    }
+    for (const auto& failure : stats.failures) {
+        fmt::print("FAILED {}\n", failure);
+    }
+}
+
+/// Failed asserts abort only the shader being compiled instead of the whole batch.
+[[noreturn]] void ThrowOnAssert() {
+    throw std::runtime_error("assertion failed, see shader_tool.log");
+}
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[]) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage(argv[0]);
+        return -1;
+    }
+
+    Common::Log::Initialize("shader_tool.log");
+    Common::Log::Start();
+    set_assert_handler(&ThrowOnAssert);
+
+    std::vector<Job> jobs;
+    size_t num_skipped{};
+    for (const auto& path : CollectPrograms(*options)) {
+        auto ctx_path = path;
+        ctx_path.replace_extension(".ctx");
+        auto code = ReadFile<u32>(path);
+        const auto ctx = ReadFile<u8>(ctx_path);
+        auto dump = ctx ? Shader::ProgramDump::Deserialize(*ctx) : std::nullopt;
+        if (!code || code->empty() || !dump) {
+            fmt::print("Skipping {}: missing or incompatible program inputs\n",
+                       path.filename().string());
+            ++num_skipped;
+            continue;
+        }
+        jobs.push_back(Job{path, std::move(*code), std::move(*dump)});
+    }
+    if (jobs.empty()) {
+        fmt::print("No shaders to compile\n");
+        return -1;
+    }
+    if (options->output_dir) {
+        std::filesystem::create_directories(*options->output_dir);
+    }
+
+    const size_t num_runs = jobs.size() * options->iterations;
+    std::atomic<size_t> next_run{};
+    std::vector<Stats> thread_stats(options->num_threads);
+    const auto wall_start = Clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (u32 i = 0; i < options->num_threads; i++) {
+            threads.emplace_back([&, i] {
+                Common::SetCurrentThreadName(fmt::format("ShaderTool{}", i).c_str());
+                Shader::Pools pools;
+                for (size_t run = next_run++; run < num_runs; run = next_run++) {
+                    const auto& job = jobs[run % jobs.size()];
+                    try {
+                        if (options->decode_only) {
+                            DecodeJob(job, thread_stats[i]);
+                            continue;
+                        }
+                        CompileJob(job, *options, pools, thread_stats[i]);
+                    } catch (const std::exception& e) {
+                        thread_stats[i].failures.push_back(
+                            fmt::format("{}: {}", job.path.filename().string(), e.what()));
+                    }
+                }
+            });
+        }
+    }
+    const double wall_ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - wall_start).count();
+
+    Stats stats{};
+    for (const auto& thread : thread_stats) {
+        stats.Merge(thread);
+    }
+    PrintReport(stats, jobs.size(), options->iterations, wall_ms);
+    if (num_skipped != 0) {
+        fmt::print("{} shaders skipped\n", num_skipped);
+    }
+
+    Common::Log::Stop();
+    return stats.failures.empty() ? 0 : 1;
+}
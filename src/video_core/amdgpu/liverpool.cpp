@@ -1,11 +1,14 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <chrono>
+
 #include "common/assert.h"
 #include "common/config.h"
 #include "common/debug.h"
 #include "common/polyfill_thread.h"
 #include "common/thread.h"
+#include "core/debug_state.h"
 #include "core/libraries/videoout/driver.h"
 #include "video_core/amdgpu/liverpool.h"
 #include "video_core/amdgpu/pm4_cmds.h"
@@ -20,6 +23,13 @@ static const char* acb_task_name{"ACB_TASK"};
 
 std::array<u8, 48_KB> Liverpool::ConstantEngine::constants_heap;
 
+static_assert(Liverpool::NumTotalQueues <= DebugStateType::DebugStateImpl::MaxGpuQueues);
+
+static u64 SteadyNanoseconds() {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
 static std::span<const u32> NextPacket(std::span<const u32> span, size_t offset) {
     if (offset > span.size()) {
         LOG_ERROR(
@@ -46,11 +56,22 @@ Liverpool::~Liverpool() {
 void Liverpool::Process(std::stop_token stoken) {
     Common::SetCurrentThreadName("shadPS4:GPU_CommandProcessor");
 
+    std::stop_callback stop_wake{stoken, [this] { Wake(); }};
+
+    u64 frames_handled{};
+    const auto frame_pending = [&] {
+        return frames_done.load(std::memory_order::acquire) != frames_handled;
+    };
+
     while (!stoken.stop_requested()) {
-        {
-            std::unique_lock lk{submit_mutex};
-            Common::CondvarWait(submit_cv, lk, stoken,
-                                [this] { return num_commands || num_submits || submit_done; });
+        for (;;) {
+            // Sample the wake counter before checking for work, so that a wake between the
+            // check and the wait is not lost.
+            const u32 seq = wake_count.load(std::memory_order::acquire);
+            if (num_commands || num_submits || frame_pending() || stoken.stop_requested()) {
+                break;
+            }
+            wake_count.wait(seq, std::memory_order::acquire);
         }
         if (stoken.stop_requested()) {
             break;
@@ -60,60 +81,84 @@ void Liverpool::Process(std::stop_token stoken) {
 
         int qid = -1;
 
-        while (num_submits || num_commands) {
+        while (num_submits || num_commands || frame_pending()) {
 
             // Process incoming commands with high priority
-            while (num_commands) {
-
-                Common::UniqueFunction<void> callback{};
-                {
-                    std::unique_lock lk{submit_mutex};
-                    callback = std::move(command_queue.back());
-                    command_queue.pop();
-                }
-
+            Common::UniqueFunction<void> callback{};
+            while (command_queue.TryPop(callback)) {
                 callback();
-
                 --num_commands;
             }
 
+            // End the frame as soon as its graphics submissions are done, even if the guest
+            // keeps the queues busy with the next one.
+            if (const u64 frames = frames_done.load(std::memory_order::acquire);
+                frames != frames_handled &&
+                gfx_completed.load(std::memory_order::acquire) >=
+                    last_frame_fence.load(std::memory_order::relaxed)) {
+                frames_handled = frames;
+                EndFrame();
+            }
+
             qid = (qid + 1) % NumTotalQueues;
 
             auto& queue = mapped_queues[qid];
 
-            Task::Handle task{};
-            {
-                std::scoped_lock lock{queue.m_access};
-                if (queue.submits.empty()) {
+            if (!queue.active.task) {
+                if (!queue.submits.TryPop(queue.active)) {
                     continue;
                 }
-                task = queue.submits.front();
+                DebugState.OnGpuSubmitStart(qid, SteadyNanoseconds() - queue.active.submit_time);
             }
+
+            Task::Handle task = queue.active.task;
             task.resume();
 
             if (task.done()) {
                 task.destroy();
 
-                std::scoped_lock lock{queue.m_access};
-                queue.submits.pop();
+                if (queue.active.ring_end != 0) {
+                    // The command buffer copies of this submission are no longer needed.
+                    queue.ring_tail.store(queue.active.ring_end, std::memory_order::release);
+                    queue.ring_tail.notify_all();
+                }
+                queue.active = {};
+                DebugState.OnGpuSubmitDone(qid);
 
+                if (qid == GfxQueueId) {
+                    gfx_completed.fetch_add(1, std::memory_order::release);
+                    gfx_completed.notify_all();
+                }
                 --num_submits;
-                std::scoped_lock lock2{submit_mutex};
-                submit_cv.notify_all();
+                num_submits.notify_all();
             }
         }
 
-        if (submit_done) {
-            VideoCore::EndCapture();
+        Platform::IrqC::Instance()->Signal(Platform::InterruptId::GpuIdle);
+    }
+}
+
+void Liverpool::EndFrame() {
+    VideoCore::EndCapture();
 
-            if (rasterizer) {
-                rasterizer->Flush();
-            }
-            submit_done = false;
-        }
+    if (rasterizer) {
+        rasterizer->Flush();
+    }
 
-        Platform::IrqC::Instance()->Signal(Platform::InterruptId::GpuIdle);
+    Platform::IrqC::Instance()->Signal(Platform::InterruptId::GpuIdle);
+    VideoCore::StartCapture();
+}
+
+bool Liverpool::HasOtherWork(u32 qid) const noexcept {
+    if (num_commands.load(std::memory_order::acquire) != 0) {
+        return true;
     }
+    for (u32 i = 0; i < NumTotalQueues; i++) {
+        if (i != qid && (mapped_queues[i].active.task || !mapped_queues[i].submits.Empty())) {
+            return true;
+        }
+    }
+    return false;
 }
 
 Liverpool::Task Liverpool::ProcessCeUpdate(std::span<const u32> ccb) {
@@ -513,12 +558,12 @@ Liverpool::Task Liverpool::ProcessGraphics(std::span<const u32> dcb, std::span<c
                 const auto* wait_reg_mem = reinterpret_cast<const PM4CmdWaitRegMem*>(header);
                 // ASSERT(wait_reg_mem->engine.Value() == PM4CmdWaitRegMem::Engine::Me);
                 // Optimization: VO label waits are special because the emulator
-                // will write to the label when presentation is finished. So if
-                // there are no other submits to yield to we can sleep the thread
+                // will write to the label when presentation is finished. So as long
+                // as no other queue can make progress we can sleep the thread
                 // instead and allow other tasks to run.
                 const u64* wait_addr = wait_reg_mem->Address<u64*>();
-                if (vo_port->IsVoLabel(wait_addr) && num_submits == 1) {
-                    vo_port->WaitVoLabel([&] { return wait_reg_mem->Test(); });
+                if (vo_port->IsVoLabel(wait_addr)) {
+                    WaitVoLabel(GfxQueueId, [&] { return wait_reg_mem->Test(); });
                 }
                 while (!wait_reg_mem->Test()) {
                     mapped_queues[GfxQueueId].cs_state = regs.cs_program;
@@ -661,55 +706,47 @@ Liverpool::Task Liverpool::ProcessCompute(std::span<const u32> acb, int vqid) {
 std::pair<std::span<const u32>, std::span<const u32>> Liverpool::CopyCmdBuffers(
     std::span<const u32> dcb, std::span<const u32> ccb) {
     auto& queue = mapped_queues[GfxQueueId];
-
-    // std::vector resize can invalidate spans for commands in flight
-    ASSERT_MSG(queue.dcb_buffer.capacity() >= queue.dcb_buffer_offset + dcb.size(),
-               "dcb copy buffer out of reserved space");
-    ASSERT_MSG(queue.ccb_buffer.capacity() >= queue.ccb_buffer_offset + ccb.size(),
-               "ccb copy buffer out of reserved space");
-
-    queue.dcb_buffer.resize(
-        std::max(queue.dcb_buffer.size(), queue.dcb_buffer_offset + dcb.size()));
-    queue.ccb_buffer.resize(
-        std::max(queue.ccb_buffer.size(), queue.ccb_buffer_offset + ccb.size()));
-
-    u32 prev_dcb_buffer_offset = queue.dcb_buffer_offset;
-    u32 prev_ccb_buffer_offset = queue.ccb_buffer_offset;
-    if (!dcb.empty()) {
-        std::memcpy(queue.dcb_buffer.data() + queue.dcb_buffer_offset, dcb.data(),
-                    dcb.size_bytes());
-        queue.dcb_buffer_offset += dcb.size();
-        dcb = std::span<const u32>{queue.dcb_buffer.begin() + prev_dcb_buffer_offset,
-                                   queue.dcb_buffer.begin() + queue.dcb_buffer_offset};
-    }
-
-    if (!ccb.empty()) {
-        std::memcpy(queue.ccb_buffer.data() + queue.ccb_buffer_offset, ccb.data(),
-                    ccb.size_bytes());
-        queue.ccb_buffer_offset += ccb.size();
-        ccb = std::span<const u32>{queue.ccb_buffer.begin() + prev_ccb_buffer_offset,
-                                   queue.ccb_buffer.begin() + queue.ccb_buffer_offset};
-    }
-
-    return std::make_pair(dcb, ccb);
+    const u64 ring_size = queue.cmd_ring.size();
+    const u64 size = dcb.size() + ccb.size();
+    ASSERT_MSG(size <= ring_size, "Command buffers do not fit in the copy ring");
+
+    // Copies are contiguous, skip the end of the ring if they would wrap around.
+    const u64 offset = queue.ring_head % ring_size;
+    const u64 begin = queue.ring_head + (offset + size > ring_size ? ring_size - offset : 0);
+
+    // Only block when the command processor still uses the space we need.
+    WaitFor(queue.ring_tail, [&](u64 tail) { return begin + size - tail <= ring_size; });
+    queue.ring_head = begin + size;
+
+    u32* const dcb_copy = queue.cmd_ring.data() + begin % ring_size;
+    u32* const ccb_copy = dcb_copy + dcb.size();
+    std::memcpy(dcb_copy, dcb.data(), dcb.size_bytes());
+    std::memcpy(ccb_copy, ccb.data(), ccb.size_bytes());
+    return std::make_pair(std::span<const u32>{dcb_copy, dcb.size()},
+                          std::span<const u32>{ccb_copy, ccb.size()});
 }
 
 void Liverpool::SubmitGfx(std::span<const u32> dcb, std::span<const u32> ccb) {
     auto& queue = mapped_queues[GfxQueueId];
 
-    if (Config::copyGPUCmdBuffers()) {
-        std::tie(dcb, ccb) = CopyCmdBuffers(dcb, ccb);
-    }
-
-    auto task = ProcessGraphics(dcb, ccb);
     {
+        // The copy is reserved with the submission queued, so that ring space is released in
+        // the order it was handed out.
         std::scoped_lock lock{queue.m_access};
-        queue.submits.emplace(task.handle);
+        Submission submission{};
+        if (Config::copyGPUCmdBuffers()) {
+            std::tie(dcb, ccb) = CopyCmdBuffers(dcb, ccb);
+            submission.ring_end = queue.ring_head;
+        }
+        submission.task = ProcessGraphics(dcb, ccb).handle;
+        submission.submit_time = SteadyNanoseconds();
+        // Counters are raised first so that they never go below zero on completion.
+        ++num_submits;
+        ++gfx_submitted;
+        DebugState.OnGpuSubmit(GfxQueueId);
+        queue.submits.EmplaceWait(submission);
     }
-
-    std::scoped_lock lk{submit_mutex};
-    ++num_submits;
-    submit_cv.notify_one();
+    Wake();
 }
 
 void Liverpool::SubmitAsc(u32 vqid, std::span<const u32> acb) {
@@ -719,12 +756,11 @@ void Liverpool::SubmitAsc(u32 vqid, std::span<const u32> acb) {
     const auto& task = ProcessCompute(acb, vqid);
     {
         std::scoped_lock lock{queue.m_access};
-        queue.submits.emplace(task.handle);
+        ++num_submits;
+        DebugState.OnGpuSubmit(vqid);
+        queue.submits.EmplaceWait(Submission{task.handle, 0, SteadyNanoseconds()});
     }
-
-    std::scoped_lock lk{submit_mutex};
-    ++num_submits;
-    submit_cv.notify_one();
+    Wake();
 }
 
 } // namespace AmdGpu
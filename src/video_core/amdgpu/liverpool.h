@@ -4,7 +4,6 @@
 #pragma once
 
 #include <array>
-#include <condition_variable>
 #include <coroutine>
 #include <exception>
 #include <mutex>
@@ -15,6 +14,7 @@
 
 #include "common/assert.h"
 #include "common/bit_field.h"
+#include "common/bounded_threadsafe_queue.h"
 #include "common/polyfill_thread.h"
 #include "common/types.h"
 #include "common/unique_function.h"
@@ -1127,23 +1127,45 @@ public:
     void SubmitGfx(std::span<const u32> dcb, std::span<const u32> ccb);
     void SubmitAsc(u32 vqid, std::span<const u32> acb);
 
+    /// Marks the end of a frame. Blocks while the command processor is more than
+    /// MaxFramesInFlight frames behind the guest.
     void SubmitDone() noexcept {
-        std::scoped_lock lk{submit_mutex};
-        mapped_queues[GfxQueueId].ccb_buffer_offset = 0;
-        mapped_queues[GfxQueueId].dcb_buffer_offset = 0;
-        submit_done = true;
-        submit_cv.notify_one();
+        u64 fence{};
+        {
+            std::scoped_lock lk{frame_mutex};
+            const u64 submitted = gfx_submitted.load();
+            frame_fences.push(submitted);
+            if (frame_fences.size() > MaxFramesInFlight) {
+                fence = frame_fences.front();
+                frame_fences.pop();
+            }
+            last_frame_fence.store(submitted, std::memory_order::relaxed);
+            frames_done.fetch_add(1, std::memory_order::release);
+        }
+        Wake();
+        WaitFor(gfx_completed, [fence](u64 completed) { return completed >= fence; });
+    }
+
+    /// Returns false while the next SubmitDone would block on the command processor.
+    bool AreSubmitsAllowed() noexcept {
+        std::scoped_lock lk{frame_mutex};
+        return frame_fences.size() < MaxFramesInFlight ||
+               gfx_completed.load() >= frame_fences.front();
     }
 
     void WaitGpuIdle() noexcept {
-        std::unique_lock lk{submit_mutex};
-        submit_cv.wait(lk, [this] { return num_submits == 0; });
+        WaitFor(num_submits, [](u32 submits) { return submits == 0; });
     }
 
     bool IsGpuIdle() const {
         return num_submits == 0;
     }
 
+    /// Wakes the command processor if it sleeps on a video out label that was written.
+    void SignalVoLabel() noexcept {
+        Wake();
+    }
+
     void SetVoPort(Libraries::VideoOut::VideoOutPort* port) {
         vo_port = port;
     }
@@ -1153,19 +1175,15 @@ public:
     }
 
     void SendCommand(Common::UniqueFunction<void>&& func) {
-        std::scoped_lock lk{submit_mutex};
-        command_queue.emplace(std::move(func));
         ++num_commands;
-        submit_cv.notify_one();
+        command_queue.EmplaceWait(std::move(func));
+        Wake();
     }
 
     void reserveCopyBufferSpace() {
         GpuQueue& gfx_queue = mapped_queues[GfxQueueId];
         std::scoped_lock<std::mutex> lk(gfx_queue.m_access);
-
-        constexpr size_t GfxReservedSize = 2_MB >> 2;
-        gfx_queue.ccb_buffer.reserve(GfxReservedSize);
-        gfx_queue.dcb_buffer.reserve(GfxReservedSize);
+        gfx_queue.cmd_ring.resize(CmdRingSize);
     }
 
 private:
@@ -1202,20 +1220,74 @@ private:
     };
 
     std::pair<std::span<const u32>, std::span<const u32>> CopyCmdBuffers(std::span<const u32> dcb,
-                                                                         std::span<const u32> ccb);
+                                                                          std::span<const u32> ccb);
     Task ProcessGraphics(std::span<const u32> dcb, std::span<const u32> ccb);
     Task ProcessCeUpdate(std::span<const u32> ccb);
     Task ProcessCompute(std::span<const u32> acb, int vqid);
 
     void Process(std::stop_token stoken);
+    void EndFrame();
+
+    /// Returns true if any queue other than qid, or a host command, has work pending.
+    bool HasOtherWork(u32 qid) const noexcept;
+
+    /// Sleeps until the predicate holds or another queue receives work it could make progress
+    /// on. Only called from the command processor thread.
+    template <typename Pred>
+    void WaitVoLabel(u32 qid, Pred&& pred) noexcept {
+        for (;;) {
+            const u32 seq = wake_count.load(std::memory_order::acquire);
+            if (pred() || HasOtherWork(qid)) {
+                return;
+            }
+            wake_count.wait(seq, std::memory_order::acquire);
+        }
+    }
+
+    /// Wakes the command processor after new work was queued.
+    void Wake() noexcept {
+        wake_count.fetch_add(1, std::memory_order::release);
+        wake_count.notify_one();
+    }
+
+    /// Blocks until the predicate holds for the value of the counter.
+    template <typename T, typename Pred>
+    static void WaitFor(std::atomic<T>& counter, Pred&& pred) noexcept {
+        T value = counter.load(std::memory_order::acquire);
+        while (!pred(value)) {
+            counter.wait(value, std::memory_order::acquire);
+            value = counter.load(std::memory_order::acquire);
+        }
+    }
+
+    /// Frames the guest may submit ahead of the command processor.
+    static constexpr size_t MaxFramesInFlight = 2;
+    /// Size in dwords of the ring holding copies of guest command buffers. Fits the largest
+    /// possible DCB and CCB pair.
+    static constexpr size_t CmdRingSize = 16_MB >> 2;
+
+    /// Submissions a queue can hold before the guest blocks.
+    static constexpr size_t MaxQueuedSubmits = 256;
+
+    struct Submission {
+        Task::Handle task{};
+        u64 ring_end{};    ///< End of the copy ring space used by the submission, if any
+        u64 submit_time{}; ///< Time the submission was queued, in nanoseconds
+    };
 
+    /**
+     * Submissions are handed from the guest to the command processor through a lock-free
+     * ring. Producers serialize on m_access, so that ring space is reserved in the order the
+     * submissions are queued. The command processor only touches the active submission, the
+     * consumer side of the ring and the release counter of the copy ring.
+     */
     struct GpuQueue {
         std::mutex m_access{};
-        std::atomic<u32> dcb_buffer_offset;
-        std::atomic<u32> ccb_buffer_offset;
-        std::vector<u32> dcb_buffer;
-        std::vector<u32> ccb_buffer;
-        std::queue<Task::Handle> submits{};
+        std::vector<u32> cmd_ring;    ///< Copies of the command buffers of submissions
+        u64 ring_head{};              ///< Dwords of the ring handed out so far
+        std::atomic<u64> ring_tail{}; ///< Dwords of the ring released so far
+        Common::SPSCQueue<Submission, MaxQueuedSubmits> submits{};
+        Submission active{}; ///< Submission being processed
         ComputeProgram cs_state{};
         VAddr indirect_args_addr{};
     };
@@ -1244,10 +1316,14 @@ private:
     std::jthread process_thread{};
     std::atomic<u32> num_submits{};
     std::atomic<u32> num_commands{};
-    std::atomic<bool> submit_done{};
-    std::mutex submit_mutex;
-    std::condition_variable_any submit_cv;
-    std::queue<Common::UniqueFunction<void>> command_queue{};
+    std::atomic<u32> wake_count{};
+    std::atomic<u64> frames_done{};      ///< Number of SubmitDone calls
+    std::atomic<u64> last_frame_fence{}; ///< gfx_submitted at the last SubmitDone
+    std::atomic<u64> gfx_submitted{};
+    std::atomic<u64> gfx_completed{};
+    std::mutex frame_mutex;
+    std::queue<u64> frame_fences{};
+    Common::MPSCQueue<Common::UniqueFunction<void>, 256> command_queue{};
 };
 
 static_assert(GFX6_3D_REG_INDEX(ps_program) == 0x2C08);
@@ -3,6 +3,7 @@
 
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "common/logging/log.h"
 #include "video_core/buffer_cache/buffer.h"
 #include "video_core/renderer_vulkan/liverpool_to_vk.h"
 #include "video_core/renderer_vulkan/vk_instance.h"
@@ -23,6 +24,8 @@ std::string_view BufferTypeName(MemoryUsage type) {
         return "Stream";
     case MemoryUsage::DeviceLocal:
         return "DeviceLocal";
+    case MemoryUsage::Imported:
+        return "Imported";
     default:
         return "Invalid";
     }
@@ -42,6 +45,7 @@ std::string_view BufferTypeName(MemoryUsage type) {
     case MemoryUsage::Download:
         return VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
     case MemoryUsage::DeviceLocal:
+    case MemoryUsage::Imported:
         return {};
     }
     return {};
@@ -51,6 +55,7 @@ std::string_view BufferTypeName(MemoryUsage type) {
     switch (usage) {
     case MemoryUsage::DeviceLocal:
     case MemoryUsage::Stream:
+    case MemoryUsage::Imported:
         return VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
     case MemoryUsage::Upload:
     case MemoryUsage::Download:
@@ -63,7 +68,10 @@ UniqueBuffer::UniqueBuffer(vk::Device device_, VmaAllocator allocator_)
     : device{device_}, allocator{allocator_} {}
 
 UniqueBuffer::~UniqueBuffer() {
-    if (buffer) {
+    if (imported_memory) {
+        device.destroyBuffer(buffer);
+        device.freeMemory(imported_memory);
+    } else if (buffer) {
         vmaDestroyBuffer(allocator, buffer, allocation);
     }
 }
@@ -88,6 +96,76 @@ void UniqueBuffer::Create(const vk::BufferCreateInfo& buffer_ci, MemoryUsage usa
     buffer = vk::Buffer{unsafe_buffer};
 }
 
+bool UniqueBuffer::Import(const Vulkan::Instance& instance, vk::BufferCreateInfo buffer_ci,
+                          VAddr host_addr) {
+    static constexpr auto HandleType = vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT;
+    static constexpr auto RequiredFlags =
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+    // The imported range must be aligned, the buffer is then bound at its offset within it.
+    const u64 alignment = instance.GetMinImportedHostPointerAlignment();
+    const VAddr import_addr = Common::AlignDown(host_addr, alignment);
+    const u64 import_size = Common::AlignUp(host_addr + buffer_ci.size, alignment) - import_addr;
+    void* const host_pointer = std::bit_cast<void*>(import_addr);
+
+    const auto [props_result, host_props] =
+        device.getMemoryHostPointerPropertiesEXT(HandleType, host_pointer);
+    if (props_result != vk::Result::eSuccess) {
+        return false;
+    }
+
+    const vk::ExternalMemoryBufferCreateInfo external_ci = {
+        .handleTypes = HandleType,
+    };
+    buffer_ci.pNext = &external_ci;
+    const auto [buffer_result, new_buffer] = device.createBuffer(buffer_ci);
+    if (buffer_result != vk::Result::eSuccess) {
+        return false;
+    }
+
+    // Only coherent memory types keep guest CPU writes visible without explicit flushes.
+    const vk::MemoryRequirements requirements = device.getBufferMemoryRequirements(new_buffer);
+    const vk::PhysicalDeviceMemoryProperties memory_props =
+        instance.GetPhysicalDevice().getMemoryProperties();
+    const u32 type_bits = host_props.memoryTypeBits & requirements.memoryTypeBits;
+    const u64 bind_offset = host_addr - import_addr;
+    std::optional<u32> type_index;
+    for (u32 i = 0; i < memory_props.memoryTypeCount; ++i) {
+        const auto flags = memory_props.memoryTypes[i].propertyFlags;
+        if ((type_bits & (1U << i)) != 0 && (flags & RequiredFlags) == RequiredFlags) {
+            type_index = i;
+            break;
+        }
+    }
+    if (!type_index || bind_offset % requirements.alignment != 0) {
+        device.destroyBuffer(new_buffer);
+        return false;
+    }
+
+    const vk::ImportMemoryHostPointerInfoEXT import_info = {
+        .handleType = HandleType,
+        .pHostPointer = host_pointer,
+    };
+    const vk::MemoryAllocateInfo alloc_info = {
+        .pNext = &import_info,
+        .allocationSize = import_size,
+        .memoryTypeIndex = *type_index,
+    };
+    const auto [alloc_result, memory] = device.allocateMemory(alloc_info);
+    if (alloc_result != vk::Result::eSuccess) {
+        device.destroyBuffer(new_buffer);
+        return false;
+    }
+    if (device.bindBufferMemory(new_buffer, memory, bind_offset) != vk::Result::eSuccess) {
+        device.destroyBuffer(new_buffer);
+        device.freeMemory(memory);
+        return false;
+    }
+    buffer = new_buffer;
+    imported_memory = memory;
+    return true;
+}
+
 Buffer::Buffer(const Vulkan::Instance& instance_, Vulkan::Scheduler& scheduler_, MemoryUsage usage_,
                VAddr cpu_addr_, vk::BufferUsageFlags flags, u64 size_bytes_)
     : cpu_addr{cpu_addr_}, size_bytes{size_bytes_}, instance{&instance_}, scheduler{&scheduler_},
@@ -98,10 +176,22 @@ Buffer::Buffer(const Vulkan::Instance& instance_, Vulkan::Scheduler& scheduler_,
         // When maintenance5 is not supported, use all flags since we can't add flags to views.
         .usage = instance->IsMaintenance5Supported() ? flags : AllFlags,
     };
+    const auto device = instance->GetDevice();
+    if (usage == MemoryUsage::Imported) {
+        if (buffer.Import(*instance, buffer_ci, cpu_addr)) {
+            Vulkan::SetObjectName(device, Handle(), "Imported Buffer {:#x}:{:#x}", cpu_addr,
+                                  size_bytes);
+            mapped_data = std::span<u8>{std::bit_cast<u8*>(cpu_addr), size_bytes};
+            is_coherent = true;
+            return;
+        }
+        LOG_DEBUG(Render_Vulkan, "Unable to import memory {:#x}:{:#x}, falling back to copies",
+                  cpu_addr, size_bytes);
+        usage = MemoryUsage::DeviceLocal;
+    }
     VmaAllocationInfo alloc_info{};
     buffer.Create(buffer_ci, usage, &alloc_info);
 
-    const auto device = instance->GetDevice();
     Vulkan::SetObjectName(device, Handle(), "Buffer {:#x}:{:#x}", cpu_addr, size_bytes);
 
     // Map it if it is host visible.
@@ -29,6 +29,7 @@ enum class MemoryUsage {
     Upload,      ///< Requires a host visible memory type optimized for CPU to GPU uploads
     Download,    ///< Requires a host visible memory type optimized for GPU to CPU readbacks
     Stream,      ///< Requests device local host visible buffer, falling back host memory.
+    Imported,    ///< Imports the guest memory of the buffer, falling back to device local memory.
 };
 
 constexpr vk::BufferUsageFlags ReadFlags =
@@ -48,19 +49,26 @@ struct UniqueBuffer {
     UniqueBuffer& operator=(const UniqueBuffer&) = delete;
 
     UniqueBuffer(UniqueBuffer&& other)
-        : allocator{std::exchange(other.allocator, VK_NULL_HANDLE)},
+        : device{other.device}, allocator{std::exchange(other.allocator, VK_NULL_HANDLE)},
           allocation{std::exchange(other.allocation, VK_NULL_HANDLE)},
+          imported_memory{std::exchange(other.imported_memory, VK_NULL_HANDLE)},
           buffer{std::exchange(other.buffer, VK_NULL_HANDLE)} {}
     UniqueBuffer& operator=(UniqueBuffer&& other) {
+        device = other.device;
         buffer = std::exchange(other.buffer, VK_NULL_HANDLE);
         allocator = std::exchange(other.allocator, VK_NULL_HANDLE);
         allocation = std::exchange(other.allocation, VK_NULL_HANDLE);
+        imported_memory = std::exchange(other.imported_memory, VK_NULL_HANDLE);
         return *this;
     }
 
     void Create(const vk::BufferCreateInfo& image_ci, MemoryUsage usage,
                 VmaAllocationInfo* out_alloc_info);
 
+    /// Creates the buffer on top of imported host memory, returns false when the driver refuses
+    /// the host range.
+    bool Import(const Vulkan::Instance& instance, vk::BufferCreateInfo buffer_ci, VAddr host_addr);
+
     operator vk::Buffer() const {
         return buffer;
     }
@@ -68,6 +76,7 @@ struct UniqueBuffer {
     vk::Device device;
     VmaAllocator allocator;
     VmaAllocation allocation;
+    vk::DeviceMemory imported_memory{};
     vk::Buffer buffer{};
 };
 
@@ -119,6 +128,11 @@ public:
         return buffer;
     }
 
+    /// Returns true when the buffer aliases guest memory instead of holding a copy of it
+    [[nodiscard]] bool IsImported() const noexcept {
+        return usage == MemoryUsage::Imported;
+    }
+
     std::optional<vk::BufferMemoryBarrier2> GetBarrier(vk::AccessFlagBits2 dst_acess_mask,
                                                        vk::PipelineStageFlagBits2 dst_stage) {
         if (dst_acess_mask == access_mask && stage == dst_stage) {
@@ -144,6 +158,7 @@ public:
     bool is_coherent{};
     int stream_score = 0;
     size_t size_bytes = 0;
+    u64 generation = 0; ///< Unique value that changes whenever the buffer contents are written
     std::span<u8> mapped_data;
     const Vulkan::Instance* instance;
     Vulkan::Scheduler* scheduler;
@@ -2,7 +2,10 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <algorithm>
+#include <bit>
 #include "common/alignment.h"
+#include "common/config.h"
+#include "common/div_ceil.h"
 #include "common/scope_exit.h"
 #include "shader_recompiler/info.h"
 #include "video_core/amdgpu/liverpool.h"
@@ -10,14 +13,47 @@
 #include "video_core/renderer_vulkan/liverpool_to_vk.h"
 #include "video_core/renderer_vulkan/vk_instance.h"
 #include "video_core/renderer_vulkan/vk_scheduler.h"
+#include "video_core/renderer_vulkan/vk_shader_util.h"
 #include "video_core/texture_cache/texture_cache.h"
 
+#include "video_core/host_shaders/quad_list_comp.h"
+
 namespace VideoCore {
 
 static constexpr size_t NumVertexBuffers = 32;
 static constexpr size_t GdsBufferSize = 64_KB;
 static constexpr size_t StagingBufferSize = 1_GB;
 static constexpr size_t UboStreamBufferSize = 64_MB;
+static constexpr u32 MinCachedQuads = 4096;
+static constexpr u32 QuadListGroupSize = 64;
+static constexpr size_t MaxQuadIndexEntries = 1024;
+
+/// Index source of the quad list expansion shader.
+enum QuadIndexType : u32 {
+    Generated = 0,
+    Index16 = 1,
+    Index32 = 2,
+};
+
+struct QuadListParams {
+    u32 num_quads;
+    u32 index_type;
+    u32 first_index;
+};
+
+/// Writes the triangle list indices of the quads in a guest index buffer, like quad_list.comp.
+template <typename T>
+static void ExpandQuadsOnCpu(const T* in, u32 num_quads, u8* out_data) {
+    auto* out = reinterpret_cast<u32*>(out_data);
+    for (u32 quad = 0; quad < num_quads; quad++, in += 4, out += 6) {
+        out[0] = in[0];
+        out[1] = in[1];
+        out[2] = in[2];
+        out[3] = in[0];
+        out[4] = in[2];
+        out[5] = in[3];
+    }
+}
 
 BufferCache::BufferCache(const Vulkan::Instance& instance_, Vulkan::Scheduler& scheduler_,
                          const AmdGpu::Liverpool* liverpool_, TextureCache& texture_cache_,
@@ -30,12 +66,20 @@ BufferCache::BufferCache(const Vulkan::Instance& instance_, Vulkan::Scheduler& s
       memory_tracker{&tracker} {
     Vulkan::SetObjectName(instance.GetDevice(), gds_buffer.Handle(), "GDS Buffer");
 
+    import_host_memory = Config::hostMemoryImport() && instance.IsExternalMemoryHostSupported();
+    if (import_host_memory) {
+        LOG_INFO(Render_Vulkan, "Importing guest memory into buffers, import alignment {:#x}",
+                 instance.GetMinImportedHostPointerAlignment());
+    }
+
     // Ensure the first slot is used for the null buffer
     const auto null_id =
         slot_buffers.insert(instance, scheduler, MemoryUsage::DeviceLocal, 0, ReadFlags, 1);
     ASSERT(null_id.index == 0);
     const vk::Buffer& null_buffer = slot_buffers[null_id].buffer;
     Vulkan::SetObjectName(instance.GetDevice(), null_buffer, "Null Buffer");
+
+    CreateQuadListPipeline();
 }
 
 BufferCache::~BufferCache() = default;
@@ -56,46 +100,33 @@ void BufferCache::InvalidateMemory(VAddr device_addr, u64 size) {
     }
 }
 
-void BufferCache::DownloadBufferMemory(Buffer& buffer, VAddr device_addr, u64 size) {
-    boost::container::small_vector<vk::BufferCopy, 1> copies;
-    u64 total_size_bytes = 0;
-    u64 largest_copy = 0;
-    memory_tracker.ForEachDownloadRange<true>(
-        device_addr, size, [&](u64 device_addr_out, u64 range_size) {
-            const VAddr buffer_addr = buffer.CpuAddr();
-            const auto add_download = [&](VAddr start, VAddr end, u64) {
-                const u64 new_offset = start - buffer_addr;
-                const u64 new_size = end - start;
-                copies.push_back(vk::BufferCopy{
-                    .srcOffset = new_offset,
-                    .dstOffset = total_size_bytes,
-                    .size = new_size,
-                });
-                // Align up to avoid cache conflicts
-                constexpr u64 align = 64ULL;
-                constexpr u64 mask = ~(align - 1ULL);
-                total_size_bytes += (new_size + align - 1) & mask;
-                largest_copy = std::max(largest_copy, new_size);
-            };
-        });
-    if (total_size_bytes == 0) {
-        return;
-    }
-    const auto [staging, offset] = staging_buffer.Map(total_size_bytes);
-    for (auto& copy : copies) {
-        // Modify copies to have the staging offset in mind
-        copy.dstOffset += offset;
+bool BufferCache::UnmapMemory(VAddr device_addr, u64 size) {
+    std::scoped_lock lk{mutex};
+    // Imported buffers alias the guest memory, so they can't outlive its mapping.
+    const size_t num_unmapped = unmapped_imports.size();
+    ForEachBufferInRange(device_addr, size, [&](BufferId buffer_id, Buffer& buffer) {
+        if (buffer.IsImported()) {
+            unmapped_imports.push_back(buffer_id);
+        }
+    });
+    for (size_t i = num_unmapped; i < unmapped_imports.size(); ++i) {
+        const BufferId buffer_id = unmapped_imports[i];
+        const Buffer& buffer = slot_buffers[buffer_id];
+        memory_tracker.MarkRegionAsCpuModified(buffer.CpuAddr(), buffer.SizeBytes());
+        Unregister(buffer_id);
     }
-    staging_buffer.Commit();
-    scheduler.EndRendering();
-    const auto cmdbuf = scheduler.CommandBuffer();
-    cmdbuf.copyBuffer(buffer.buffer, staging_buffer.Handle(), copies);
+    return !unmapped_imports.empty();
+}
+
+void BufferCache::FreeUnmappedBuffers() {
+    // Pending work may still access the imported memory, and freeing the buffer memory is only
+    // allowed while the host pointer is valid.
     scheduler.Finish();
-    for (const auto& copy : copies) {
-        const VAddr copy_device_addr = buffer.CpuAddr() + copy.srcOffset;
-        const u64 dst_offset = copy.dstOffset - offset;
-        std::memcpy(std::bit_cast<u8*>(copy_device_addr), staging + dst_offset, copy.size);
+    std::scoped_lock lk{mutex};
+    for (const BufferId buffer_id : unmapped_imports) {
+        slot_buffers.erase(buffer_id);
     }
+    unmapped_imports.clear();
 }
 
 bool BufferCache::BindVertexBuffers(const Shader::Info& vs_info) {
@@ -222,21 +253,12 @@ bool BufferCache::BindVertexBuffers(const Shader::Info& vs_info) {
 }
 
 u32 BufferCache::BindIndexBuffer(bool& is_indexed, u32 index_offset) {
-    // Emulate QuadList primitive type with CPU made index buffer.
+    // Emulate QuadList primitive type with a triangle list index buffer made on the GPU.
     const auto& regs = liverpool->regs;
     if (regs.primitive_type == AmdGpu::Liverpool::PrimitiveType::QuadList) {
+        const u32 num_indices = BindQuadListIndices(is_indexed, index_offset);
         is_indexed = true;
-
-        // Emit indices.
-        const u32 index_size = 3 * regs.num_indices;
-        const auto [data, offset] = stream_buffer.Map(index_size);
-        Vulkan::LiverpoolToVK::EmitQuadToTriangleListIndices(data, regs.num_indices);
-        stream_buffer.Commit();
-
-        // Bind index buffer.
-        const auto cmdbuf = scheduler.CommandBuffer();
-        cmdbuf.bindIndexBuffer(stream_buffer.Handle(), offset, vk::IndexType::eUint16);
-        return index_size / sizeof(u16);
+        return num_indices;
     }
     if (!is_indexed) {
         return regs.num_indices;
@@ -258,6 +280,261 @@ u32 BufferCache::BindIndexBuffer(bool& is_indexed, u32 index_offset) {
     return regs.num_indices;
 }
 
+u32 BufferCache::BindQuadListIndices(bool is_indexed, u32 index_offset) {
+    const auto& regs = liverpool->regs;
+    const u32 num_quads = regs.num_indices / 4;
+    const u32 num_indices = num_quads * 6;
+    if (!is_indexed) {
+        // Non-indexed quads always expand to the same indices, so they are generated once.
+        if (!quad_index_buffer || num_quads > num_cached_quads) {
+            GrowQuadIndexBuffer(num_quads);
+        }
+        const auto cmdbuf = scheduler.CommandBuffer();
+        cmdbuf.bindIndexBuffer(quad_index_buffer->Handle(), 0, vk::IndexType::eUint32);
+        return num_indices;
+    }
+
+    const bool is_index16 =
+        regs.index_buffer_type.index_type == AmdGpu::Liverpool::IndexType::Index16;
+    const u32 index_size = is_index16 ? sizeof(u16) : sizeof(u32);
+    VAddr index_address = regs.index_base_address.Address<VAddr>();
+    index_address += index_offset * index_size;
+    const u32 index_buffer_size = regs.num_indices * index_size;
+    const auto cmdbuf = scheduler.CommandBuffer();
+
+    // Small index buffers the GPU has not written would be copied to the stream buffer by the CPU
+    // anyway. Expand them during the copy instead of breaking the render pass for a dispatch.
+    if (index_buffer_size <= CACHING_PAGESIZE &&
+        !memory_tracker.IsRegionGpuModified(index_address, index_buffer_size)) {
+        const auto [data, out_offset] = stream_buffer.Map(num_indices * sizeof(u32), sizeof(u32));
+        if (is_index16) {
+            ExpandQuadsOnCpu(std::bit_cast<const u16*>(index_address), num_quads, data);
+        } else {
+            ExpandQuadsOnCpu(std::bit_cast<const u32*>(index_address), num_quads, data);
+        }
+        stream_buffer.Commit();
+        cmdbuf.bindIndexBuffer(stream_buffer.Handle(), out_offset, vk::IndexType::eUint32);
+        return num_indices;
+    }
+
+    const auto [vk_buffer, offset] = ObtainBuffer(index_address, index_buffer_size, false);
+    const u32 index_type = is_index16 ? Index16 : Index32;
+
+    // Static index buffers are expanded once and reused until their buffer is written. Imported
+    // buffers see CPU writes without an upload, so their generation does not track them.
+    if (num_quads != 0 && vk_buffer->generation != 0 && !vk_buffer->IsImported()) {
+        const u64 key = index_address | (u64{is_index16} << 63);
+        if (quad_index_cache.size() >= MaxQuadIndexEntries && !quad_index_cache.contains(key)) {
+            ClearQuadIndexCache();
+        }
+        auto [it, inserted] = quad_index_cache.try_emplace(key);
+        QuadIndexEntry& entry = it.value();
+        if (inserted) {
+            entry.src_generation = vk_buffer->generation;
+            entry.num_quads = num_quads;
+            entry.buffer.emplace(instance, scheduler, MemoryUsage::DeviceLocal, 0, AllFlags,
+                                 num_indices * sizeof(u32));
+            ExpandQuads(vk_buffer->Handle(), offset, index_type, num_quads,
+                        entry.buffer->Handle(), 0);
+        }
+        if (entry.buffer && entry.num_quads == num_quads &&
+            entry.src_generation == vk_buffer->generation) {
+            cmdbuf.bindIndexBuffer(entry.buffer->Handle(), 0, vk::IndexType::eUint32);
+            return num_indices;
+        }
+        // The indices change between draws, expand them into the stream buffer from now on.
+        if (entry.buffer) {
+            scheduler.DeferOperation([buffer = std::move(*entry.buffer)] {});
+            entry.buffer.reset();
+        }
+    }
+
+    // The expanded indices are only written by the GPU, reserve space for them.
+    const u32 out_offset = static_cast<u32>(
+        stream_buffer.Map(num_indices * sizeof(u32), instance.StorageMinAlignment()).second);
+    stream_buffer.Commit();
+    if (num_quads != 0) {
+        ExpandQuads(vk_buffer->Handle(), offset, index_type, num_quads, stream_buffer.Handle(),
+                    out_offset);
+    }
+    cmdbuf.bindIndexBuffer(stream_buffer.Handle(), out_offset, vk::IndexType::eUint32);
+    return num_indices;
+}
+
+void BufferCache::ClearQuadIndexCache() {
+    for (auto it = quad_index_cache.begin(); it != quad_index_cache.end(); ++it) {
+        if (auto& buffer = it.value().buffer) {
+            scheduler.DeferOperation([buffer = std::move(*buffer)] {});
+        }
+    }
+    quad_index_cache.clear();
+}
+
+void BufferCache::GrowQuadIndexBuffer(u32 num_quads) {
+    const u32 new_num_quads = std::bit_ceil(std::max(num_quads, MinCachedQuads));
+    if (quad_index_buffer) {
+        // Keep the previous buffer alive until the GPU is done with it.
+        scheduler.DeferOperation([buffer = std::move(*quad_index_buffer)] {});
+    }
+    const u32 size = new_num_quads * 6 * sizeof(u32);
+    quad_index_buffer.emplace(instance, scheduler, MemoryUsage::DeviceLocal, 0, AllFlags, size);
+    Vulkan::SetObjectName(instance.GetDevice(), quad_index_buffer->Handle(),
+                          "Quad Index Buffer:{:#x}", size);
+    ExpandQuads(quad_index_buffer->Handle(), 0, Generated, new_num_quads,
+                quad_index_buffer->Handle(), 0);
+    num_cached_quads = new_num_quads;
+}
+
+void BufferCache::ExpandQuads(vk::Buffer in_buffer, u32 in_offset, u32 index_type, u32 num_quads,
+                              vk::Buffer out_buffer, u32 out_offset) {
+    scheduler.EndRendering();
+    const auto cmdbuf = scheduler.CommandBuffer();
+    cmdbuf.bindPipeline(vk::PipelineBindPoint::eCompute, *quad_pipeline);
+
+    // Storage buffer offsets must be aligned, the shader skips the indices in between.
+    const u32 index_size = index_type == Index16 ? sizeof(u16) : sizeof(u32);
+    const u32 in_offset_aligned = Common::AlignDown(in_offset, instance.StorageMinAlignment());
+    ASSERT((in_offset - in_offset_aligned) % index_size == 0);
+    const u32 out_size = num_quads * 6 * sizeof(u32);
+
+    if (index_type != Generated) {
+        // Guest indices may have just been uploaded or written by a shader.
+        const vk::BufferMemoryBarrier2 pre_barrier = {
+            .srcStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+            .srcAccessMask =
+                vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderWrite,
+            .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+            .dstAccessMask = vk::AccessFlagBits2::eShaderRead,
+            .buffer = in_buffer,
+            .offset = in_offset_aligned,
+            .size = VK_WHOLE_SIZE,
+        };
+        cmdbuf.pipelineBarrier2(vk::DependencyInfo{
+            .dependencyFlags = vk::DependencyFlagBits::eByRegion,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers = &pre_barrier,
+        });
+    }
+
+    const vk::DescriptorBufferInfo input_buffer_info{
+        .buffer = in_buffer,
+        .offset = in_offset_aligned,
+        .range = VK_WHOLE_SIZE,
+    };
+    const vk::DescriptorBufferInfo output_buffer_info{
+        .buffer = out_buffer,
+        .offset = out_offset,
+        .range = out_size,
+    };
+    const std::array<vk::WriteDescriptorSet, 2> set_writes{{
+        {
+            .dstSet = VK_NULL_HANDLE,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &input_buffer_info,
+        },
+        {
+            .dstSet = VK_NULL_HANDLE,
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &output_buffer_info,
+        },
+    }};
+    cmdbuf.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, *quad_pl_layout, 0, set_writes);
+
+    const QuadListParams params{
+        .num_quads = num_quads,
+        .index_type = index_type,
+        .first_index = (in_offset - in_offset_aligned) / index_size,
+    };
+    cmdbuf.pushConstants(*quad_pl_layout, vk::ShaderStageFlagBits::eCompute, 0U, sizeof(params),
+                         &params);
+    cmdbuf.dispatch(Common::DivCeil(num_quads, QuadListGroupSize), 1, 1);
+
+    const vk::BufferMemoryBarrier2 post_barrier = {
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eIndexInput,
+        .dstAccessMask = vk::AccessFlagBits2::eIndexRead,
+        .buffer = out_buffer,
+        .offset = out_offset,
+        .size = out_size,
+    };
+    cmdbuf.pipelineBarrier2(vk::DependencyInfo{
+        .dependencyFlags = vk::DependencyFlagBits::eByRegion,
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers = &post_barrier,
+    });
+}
+
+void BufferCache::CreateQuadListPipeline() {
+    const vk::Device device = instance.GetDevice();
+    const std::array<vk::DescriptorSetLayoutBinding, 2> bindings{{
+        {
+            .binding = 0,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        },
+        {
+            .binding = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        },
+    }};
+    const vk::DescriptorSetLayoutCreateInfo desc_layout_ci = {
+        .flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR,
+        .bindingCount = static_cast<u32>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+    auto [desc_layout_result, desc_layout] =
+        device.createDescriptorSetLayoutUnique(desc_layout_ci);
+    ASSERT_MSG(desc_layout_result == vk::Result::eSuccess,
+               "Failed to create descriptor set layout: {}", vk::to_string(desc_layout_result));
+    quad_desc_layout = std::move(desc_layout);
+
+    const vk::PushConstantRange push_constants = {
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset = 0,
+        .size = sizeof(QuadListParams),
+    };
+    const vk::DescriptorSetLayout set_layout = *quad_desc_layout;
+    const vk::PipelineLayoutCreateInfo layout_info = {
+        .setLayoutCount = 1U,
+        .pSetLayouts = &set_layout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constants,
+    };
+    auto [layout_result, layout] = device.createPipelineLayoutUnique(layout_info);
+    ASSERT_MSG(layout_result == vk::Result::eSuccess, "Failed to create pipeline layout: {}",
+               vk::to_string(layout_result));
+    quad_pl_layout = std::move(layout);
+
+    const auto module =
+        Vulkan::Compile(HostShaders::QUAD_LIST_COMP, vk::ShaderStageFlagBits::eCompute, device);
+    Vulkan::SetObjectName(device, module, "QuadList");
+    const vk::ComputePipelineCreateInfo compute_pipeline_ci = {
+        .stage =
+            {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = module,
+                .pName = "main",
+            },
+        .layout = *quad_pl_layout,
+    };
+    auto [pipeline_result, pipeline] =
+        device.createComputePipelineUnique(/*pipeline_cache*/ {}, compute_pipeline_ci);
+    ASSERT_MSG(pipeline_result == vk::Result::eSuccess, "Quad list pipeline creation failed: {}",
+               vk::to_string(pipeline_result));
+    quad_pipeline = std::move(pipeline);
+    device.destroyShaderModule(module);
+}
+
 void BufferCache::InlineDataToGds(u32 gds_offset, u32 value) {
     ASSERT_MSG(gds_offset % 4 == 0, "GDS offset must be dword aligned");
     scheduler.EndRendering();
@@ -295,6 +572,7 @@ std::pair<Buffer*, u32> BufferCache::ObtainBuffer(VAddr device_addr, u32 size, b
     SynchronizeBuffer(buffer, device_addr, size, is_texel_buffer);
     if (is_written) {
         memory_tracker.MarkRegionAsGpuModified(device_addr, size);
+        MarkBufferWritten(buffer);
     }
     return {&buffer, buffer.Offset(device_addr)};
 }
@@ -440,6 +718,13 @@ void BufferCache::JoinOverlap(BufferId new_buffer_id, BufferId overlap_id,
     if (accumulate_stream_score) {
         new_buffer.IncreaseStreamScore(overlap.StreamScore() + 1);
     }
+    if (new_buffer.IsImported() &&
+        (overlap.IsImported() ||
+         !memory_tracker.IsRegionGpuModified(overlap.CpuAddr(), overlap.SizeBytes()))) {
+        // Guest memory already holds the contents, only copy results of GPU writes to it.
+        DeleteBuffer(overlap_id, true);
+        return;
+    }
     const size_t dst_base_offset = overlap.CpuAddr() - new_buffer.CpuAddr();
     const vk::BufferCopy copy = {
         .srcOffset = 0,
@@ -472,13 +757,17 @@ BufferId BufferCache::CreateBuffer(VAddr device_addr, u32 wanted_size) {
     wanted_size = static_cast<u32>(device_addr_end - device_addr);
     const OverlapResult overlap = ResolveOverlaps(device_addr, wanted_size);
     const u32 size = static_cast<u32>(overlap.end - overlap.begin);
-    const BufferId new_buffer_id = slot_buffers.insert(
-        instance, scheduler, MemoryUsage::DeviceLocal, overlap.begin, AllFlags, size);
+    const MemoryUsage usage = import_host_memory ? MemoryUsage::Imported : MemoryUsage::DeviceLocal;
+    const BufferId new_buffer_id =
+        slot_buffers.insert(instance, scheduler, usage, overlap.begin, AllFlags, size);
     auto& new_buffer = slot_buffers[new_buffer_id];
-    const size_t size_bytes = new_buffer.SizeBytes();
-    const auto cmdbuf = scheduler.CommandBuffer();
-    scheduler.EndRendering();
-    cmdbuf.fillBuffer(new_buffer.buffer, 0, size_bytes, 0);
+    MarkBufferWritten(new_buffer);
+    if (!new_buffer.IsImported()) {
+        const size_t size_bytes = new_buffer.SizeBytes();
+        const auto cmdbuf = scheduler.CommandBuffer();
+        scheduler.EndRendering();
+        cmdbuf.fillBuffer(new_buffer.buffer, 0, size_bytes, 0);
+    }
     for (const BufferId overlap_id : overlap.ids) {
         JoinOverlap(new_buffer_id, overlap_id, !overlap.has_stream_leap);
     }
@@ -514,6 +803,13 @@ void BufferCache::ChangeRegister(BufferId buffer_id) {
 void BufferCache::SynchronizeBuffer(Buffer& buffer, VAddr device_addr, u32 size,
                                     bool is_texel_buffer) {
     std::scoped_lock lk{mutex};
+    if (buffer.IsImported()) {
+        // CPU writes are visible to the GPU through the imported memory, nothing to upload.
+        if (is_texel_buffer) {
+            SynchronizeBufferFromImage(buffer, device_addr, size);
+        }
+        return;
+    }
     boost::container::small_vector<vk::BufferCopy, 4> copies;
     u64 total_size_bytes = 0;
     u64 largest_copy = 0;
@@ -540,6 +836,7 @@ void BufferCache::SynchronizeBuffer(Buffer& buffer, VAddr device_addr, u32 size,
     if (total_size_bytes == 0) {
         return;
     }
+    MarkBufferWritten(buffer);
     vk::Buffer src_buffer = staging_buffer.Handle();
     if (total_size_bytes < StagingBufferSize) {
         const auto [staging, offset] = staging_buffer.Map(total_size_bytes);
@@ -634,6 +931,7 @@ bool BufferCache::SynchronizeBufferFromImage(Buffer& buffer, VAddr device_addr,
         });
     }
     if (!copies.empty()) {
+        MarkBufferWritten(buffer);
         scheduler.EndRendering();
         image.Transit(vk::ImageLayout::eTransferSrcOptimal, vk::AccessFlagBits2::eTransferRead, {});
         const auto cmdbuf = scheduler.CommandBuffer();
@@ -4,6 +4,8 @@
 #pragma once
 
 #include <mutex>
+#include <optional>
+#include <vector>
 #include <boost/container/small_vector.hpp>
 #include <boost/icl/interval_map.hpp>
 #include <tsl/robin_map.h>
@@ -70,6 +72,14 @@ public:
     /// Invalidates any buffer in the logical page range.
     void InvalidateMemory(VAddr device_addr, u64 size);
 
+    /// Unregisters the buffers that import guest memory in the unmapped range. Returns true when
+    /// they have to be freed by FreeUnmappedBuffers before the memory is unmapped from the host.
+    bool UnmapMemory(VAddr device_addr, u64 size);
+
+    /// Waits for the GPU to finish and destroys the buffers unregistered by UnmapMemory.
+    /// Must be called from the thread that records commands.
+    void FreeUnmappedBuffers();
+
     /// Binds host vertex buffers for the current draw.
     bool BindVertexBuffers(const Shader::Info& vs_info);
 
@@ -113,8 +123,6 @@ private:
         }
     }
 
-    void DownloadBufferMemory(Buffer& buffer, VAddr device_addr, u64 size);
-
     [[nodiscard]] BufferId FindBuffer(VAddr device_addr, u32 size);
 
     [[nodiscard]] OverlapResult ResolveOverlaps(VAddr device_addr, u32 wanted_size);
@@ -136,6 +144,22 @@ private:
 
     void DeleteBuffer(BufferId buffer_id, bool do_not_mark = false);
 
+    void CreateQuadListPipeline();
+
+    u32 BindQuadListIndices(bool is_indexed, u32 index_offset);
+
+    void GrowQuadIndexBuffer(u32 num_quads);
+
+    void ClearQuadIndexCache();
+
+    /// Records that the contents of the buffer changed.
+    void MarkBufferWritten(Buffer& buffer) noexcept {
+        buffer.generation = ++next_generation;
+    }
+
+    void ExpandQuads(vk::Buffer in_buffer, u32 in_offset, u32 index_type, u32 num_quads,
+                     vk::Buffer out_buffer, u32 out_offset);
+
     const Vulkan::Instance& instance;
     Vulkan::Scheduler& scheduler;
     const AmdGpu::Liverpool* liverpool;
@@ -146,8 +170,24 @@ private:
     Buffer gds_buffer;
     std::mutex mutex;
     Common::SlotVector<Buffer> slot_buffers;
+    std::vector<BufferId> unmapped_imports;
     MemoryTracker memory_tracker;
     PageTable page_table;
+    bool import_host_memory{};
+    vk::UniqueDescriptorSetLayout quad_desc_layout;
+    vk::UniquePipelineLayout quad_pl_layout;
+    vk::UniquePipeline quad_pipeline;
+    std::optional<Buffer> quad_index_buffer; ///< Triangle list indices of non-indexed quads
+    u32 num_cached_quads{};
+    u64 next_generation{};
+
+    /// Expanded indices of an indexed quad draw, valid while the guest indices are unchanged.
+    struct QuadIndexEntry {
+        u64 src_generation{};
+        u32 num_quads{};
+        std::optional<Buffer> buffer; ///< Empty once the guest indices changed between draws
+    };
+    tsl::robin_map<u64, QuadIndexEntry> quad_index_cache;
 };
 
 } // namespace VideoCore
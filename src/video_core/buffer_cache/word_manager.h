@@ -227,9 +227,10 @@ public:
     void ChangeRegionState(u64 dirty_addr, u64 size) noexcept(type == Type::GPU) {
         std::span<u64> state_words = words.template Span<type>();
         [[maybe_unused]] std::span<u64> untracked_words = words.template Span<Type::Untracked>();
+        PageTrackerBatch<!enable> tracker_batch{*this};
         IterateWords(dirty_addr - cpu_addr, size, [&](size_t index, u64 mask) {
             if constexpr (type == Type::CPU) {
-                NotifyPageTracker<!enable>(index, untracked_words[index], mask);
+                NotifyPageTracker(tracker_batch, index, untracked_words[index], mask);
             }
             if constexpr (enable) {
                 state_words[index] |= mask;
@@ -263,7 +264,10 @@ public:
         bool pending = false;
         size_t pending_offset{};
         size_t pending_pointer{};
+        PageTrackerBatch<true> tracker_batch{*this};
         const auto release = [&]() {
+            // Pages must be protected again before their contents are consumed.
+            tracker_batch.Flush();
             func(cpu_addr + pending_offset * BYTES_PER_PAGE,
                  (pending_pointer - pending_offset) * BYTES_PER_PAGE);
         };
@@ -274,7 +278,7 @@ public:
             const u64 word = state_words[index] & mask;
             if constexpr (clear) {
                 if constexpr (type == Type::CPU) {
-                    NotifyPageTracker<true>(index, untracked_words[index], mask);
+                    NotifyPageTracker(tracker_batch, index, untracked_words[index], mask);
                 }
                 state_words[index] &= ~mask;
                 if constexpr (type == Type::CPU) {
@@ -371,23 +375,60 @@ private:
         }
     }
 
+    /**
+     * Accumulates pages whose CPU tracking state changes and notifies the tracker once per
+     * contiguous run, even when the run spans several words. Pending pages are flushed on
+     * destruction.
+     *
+     * @tparam add_to_tracker True when the tracker should start tracking the pages
+     */
+    template <bool add_to_tracker>
+    class PageTrackerBatch {
+    public:
+        explicit PageTrackerBatch(const WordManager& manager_) : manager{manager_} {}
+
+        ~PageTrackerBatch() {
+            Flush();
+        }
+
+        void Add(u64 page, u64 num_pages) {
+            if (page != run_end) {
+                Flush();
+                run_start = page;
+            }
+            run_end = page + num_pages;
+        }
+
+        void Flush() {
+            if (run_end != run_start) {
+                manager.tracker->UpdatePagesCachedCount(
+                    manager.cpu_addr + run_start * BYTES_PER_PAGE,
+                    (run_end - run_start) * BYTES_PER_PAGE, add_to_tracker ? 1 : -1);
+            }
+            run_start = run_end = 0;
+        }
+
+    private:
+        const WordManager& manager;
+        u64 run_start = 0;
+        u64 run_end = 0;
+    };
+
     /**
      * Notify tracker about changes in the CPU tracking state of a word in the buffer
      *
+     * @param batch        Batch collecting the pages to notify to the tracker
      * @param word_index   Index to the word to notify to the tracker
      * @param current_bits Current state of the word
      * @param new_bits     New state of the word
-     *
-     * @tparam add_to_tracker True when the tracker should start tracking the new pages
      */
     template <bool add_to_tracker>
-    void NotifyPageTracker(u64 word_index, u64 current_bits, u64 new_bits) const {
+    void NotifyPageTracker(PageTrackerBatch<add_to_tracker>& batch, u64 word_index,
+                           u64 current_bits, u64 new_bits) const {
         u64 changed_bits = (add_to_tracker ? current_bits : ~current_bits) & new_bits;
-        VAddr addr = cpu_addr + word_index * BYTES_PER_WORD;
-        IteratePages(changed_bits, [&](size_t offset, size_t size) {
-            tracker->UpdatePagesCachedCount(addr + offset * BYTES_PER_PAGE, size * BYTES_PER_PAGE,
-                                            add_to_tracker ? 1 : -1);
-        });
+        const u64 base_page = word_index * PAGES_PER_WORD;
+        IteratePages(changed_bits,
+                     [&](size_t offset, size_t size) { batch.Add(base_page + offset, size); });
     }
 
     PageManager* tracker;
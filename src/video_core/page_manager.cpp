@@ -1,6 +1,8 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include <algorithm>
+#include <array>
 #include <thread>
 #include <boost/icl/interval_set.hpp>
 #include "common/alignment.h"
@@ -101,23 +103,42 @@ struct PageManager::Impl {
                 continue;
             }
 
-            // Read message from kernel.
-            uffd_msg msg;
-            const int readret = read(uffd, &msg, sizeof(msg));
-            ASSERT_MSG(readret != -1 || errno == EAGAIN, "Unexpected result of uffd read");
-            if (errno == EAGAIN) {
+            // Drain every pending message with a single read. Faults raised while the handler
+            // was busy invalidating pile up in the queue and are serviced together.
+            std::array<uffd_msg, MaxFaultsPerRead> msgs;
+            const ssize_t readret = read(uffd, msgs.data(), sizeof(msgs));
+            if (readret == -1) {
+                ASSERT_MSG(errno == EAGAIN, "Unexpected result of uffd read");
                 continue;
             }
-            ASSERT_MSG(readret == sizeof(msg), "Unexpected short read, exiting");
-            ASSERT(msg.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WP);
+            ASSERT_MSG(readret % sizeof(uffd_msg) == 0, "Unexpected short read, exiting");
+            const size_t num_msgs = readret / sizeof(uffd_msg);
+
+            std::array<VAddr, MaxFaultsPerRead> fault_pages;
+            for (size_t i = 0; i < num_msgs; ++i) {
+                const auto& msg = msgs[i];
+                ASSERT(msg.event == UFFD_EVENT_PAGEFAULT);
+                ASSERT(msg.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WP);
+                fault_pages[i] = Common::AlignDown(msg.arg.pagefault.address, PAGESIZE);
+            }
 
-            // Notify rasterizer about the fault.
-            const VAddr addr = msg.arg.pagefault.address;
-            const VAddr addr_page = Common::AlignDown(addr, PAGESIZE);
-            rasterizer->InvalidateMemory(addr_page, PAGESIZE);
+            // Notify rasterizer once per run of contiguous faulting pages. Several threads may
+            // fault on the same page, duplicates fold into the current run.
+            std::sort(fault_pages.begin(), fault_pages.begin() + num_msgs);
+            size_t i = 0;
+            while (i < num_msgs) {
+                const VAddr run_start = fault_pages[i];
+                VAddr run_end = run_start + PAGESIZE;
+                while (++i < num_msgs && fault_pages[i] <= run_end) {
+                    run_end = fault_pages[i] + PAGESIZE;
+                }
+                rasterizer->InvalidateMemory(run_start, run_end - run_start);
+            }
         }
     }
 
+    static constexpr size_t MaxFaultsPerRead = 64;
+
     Vulkan::Rasterizer* rasterizer;
     std::jthread ufd_thread;
     int uffd;
@@ -199,20 +220,40 @@ void PageManager::UpdatePagesCachedCount(VAddr addr, u64 size, s32 delta) {
         cached_pages.add({pages_interval, delta});
     }
 
+    // Neighbouring intervals that flip protection the same way are merged, so that a range
+    // spanning several differently counted intervals costs one protection call per run.
+    VAddr run_start = 0;
+    VAddr run_end = 0;
+    bool run_allow_write = false;
+    const auto flush = [&] {
+        if (run_end != run_start) {
+            impl->Protect(run_start, run_end - run_start, run_allow_write);
+        }
+        run_start = run_end = 0;
+    };
+    const auto protect = [&](VAddr start, VAddr end, bool allow_write) {
+        if (start != run_end || allow_write != run_allow_write) {
+            flush();
+            run_start = start;
+            run_allow_write = allow_write;
+        }
+        run_end = end;
+    };
+
     const auto& range = cached_pages.equal_range(pages_interval);
     for (const auto& [range, count] : boost::make_iterator_range(range)) {
         const auto interval = range & pages_interval;
         const VAddr interval_start_addr = boost::icl::first(interval) << PageShift;
         const VAddr interval_end_addr = boost::icl::last_next(interval) << PageShift;
-        const u32 interval_size = interval_end_addr - interval_start_addr;
         if (delta > 0 && count == delta) {
-            impl->Protect(interval_start_addr, interval_size, false);
+            protect(interval_start_addr, interval_end_addr, false);
         } else if (delta < 0 && count == -delta) {
-            impl->Protect(interval_start_addr, interval_size, true);
+            protect(interval_start_addr, interval_end_addr, true);
         } else {
             ASSERT(count >= 0);
         }
     }
+    flush();
 
     if (delta < 0) {
         cached_pages.add({pages_interval, delta});
@@ -2,11 +2,13 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <algorithm>
+#include <iterator>
 #include <boost/container/small_vector.hpp>
 #include <boost/container/static_vector.hpp>
 
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "core/debug_state.h"
 #include "video_core/amdgpu/resource.h"
 #include "video_core/buffer_cache/buffer_cache.h"
 #include "video_core/renderer_vulkan/vk_graphics_pipeline.h"
@@ -374,7 +376,7 @@ void GraphicsPipeline::BindResources(const Liverpool::Regs& regs,
     // Bind resource buffers and textures.
     boost::container::static_vector<vk::BufferView, 8> buffer_views;
     boost::container::static_vector<vk::DescriptorBufferInfo, 32> buffer_infos;
-    boost::container::small_vector<vk::WriteDescriptorSet, 16> set_writes;
+    DescriptorWrites set_writes;
     boost::container::small_vector<vk::BufferMemoryBarrier2, 16> buffer_barriers;
     Shader::PushData push_data{};
     Shader::Backend::Bindings binding{};
@@ -504,7 +506,13 @@ void GraphicsPipeline::BindResources(const Liverpool::Regs& regs,
         cmdbuf.pipelineBarrier2(dependencies);
     }
 
-    if (!set_writes.empty()) {
+    // Resources still have to be looked up on every draw to synchronize guest memory, but the
+    // descriptors themselves only need to be written again when they changed.
+    const bool is_bound = IsBound(set_writes);
+    if (is_bound) {
+        DebugState.OnDescriptorWritesSkipped(set_writes.size());
+    } else if (!set_writes.empty()) {
+        DebugState.OnDescriptorWrites(set_writes.size());
         if (uses_push_descriptors) {
             cmdbuf.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *pipeline_layout, 0,
                                         set_writes);
@@ -521,7 +529,42 @@ void GraphicsPipeline::BindResources(const Liverpool::Regs& regs,
     cmdbuf.pushConstants(*pipeline_layout,
                          vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0U,
                          sizeof(push_data), &push_data);
-    cmdbuf.bindPipeline(vk::PipelineBindPoint::eGraphics, Handle());
+    if (!is_bound) {
+        cmdbuf.bindPipeline(vk::PipelineBindPoint::eGraphics, Handle());
+    }
+}
+
+bool GraphicsPipeline::IsBound(const DescriptorWrites& set_writes) const {
+    const auto make_key = [](const vk::WriteDescriptorSet& write) -> DescriptorKey {
+        const u64 type = static_cast<u64>(write.descriptorType);
+        if (write.pBufferInfo) {
+            const auto& info = *write.pBufferInfo;
+            return {type, reinterpret_cast<u64>(static_cast<VkBuffer>(info.buffer)), info.offset,
+                    info.range};
+        }
+        if (write.pTexelBufferView) {
+            return {type, reinterpret_cast<u64>(static_cast<VkBufferView>(*write.pTexelBufferView)),
+                    0, 0};
+        }
+        const auto& info = *write.pImageInfo;
+        return {type, reinterpret_cast<u64>(static_cast<VkSampler>(info.sampler)),
+                reinterpret_cast<u64>(static_cast<VkImageView>(info.imageView)),
+                static_cast<u64>(info.imageLayout)};
+    };
+
+    // Descriptors and pipeline bindings don't survive the command buffer, the scheduler forgets
+    // the bound pipeline when it begins a new one.
+    bool is_bound = scheduler.BoundGraphicsPipeline() == this &&
+                    bound_descriptors.size() == set_writes.size();
+    for (size_t i = 0; i < set_writes.size() && is_bound; ++i) {
+        is_bound = bound_descriptors[i] == make_key(set_writes[i]);
+    }
+    if (!is_bound) {
+        bound_descriptors.clear();
+        std::ranges::transform(set_writes, std::back_inserter(bound_descriptors), make_key);
+        scheduler.SetBoundGraphicsPipeline(this);
+    }
+    return is_bound;
 }
 
 } // namespace Vulkan
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <xxhash.h>
+#include <boost/container/small_vector.hpp>
 #include "common/types.h"
 #include "video_core/renderer_vulkan/liverpool_to_vk.h"
 #include "video_core/renderer_vulkan/vk_common.h"
@@ -98,10 +99,18 @@ public:
 private:
     void BuildDescSetLayout();
 
+    /// Returns true when the pipeline and the descriptors are still bound from the previous
+    /// draw in the current command buffer. Updates the bound state otherwise.
+    bool IsBound(const DescriptorWrites& set_writes) const;
+
 private:
+    /// Identifies the resource written by a descriptor: type and handles or buffer range.
+    using DescriptorKey = std::array<u64, 4>;
+
     std::array<const Shader::Info*, MaxShaderStages> stages{};
     GraphicsPipelineKey key;
     bool uses_push_descriptors{};
+    mutable boost::container::small_vector<DescriptorKey, 32> bound_descriptors;
 };
 
 } // namespace Vulkan
@@ -2,12 +2,14 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include <ranges>
+#include <thread>
 
 #include "common/config.h"
 #include "common/io_file.h"
 #include "common/path_util.h"
 #include "shader_recompiler/backend/spirv/emit_spirv.h"
 #include "shader_recompiler/info.h"
+#include "shader_recompiler/program_dump.h"
 #include "video_core/renderer_vulkan/renderer_vulkan.h"
 #include "video_core/renderer_vulkan/vk_instance.h"
 #include "video_core/renderer_vulkan/vk_pipeline_cache.h"
@@ -138,13 +140,35 @@ PipelineCache::PipelineCache(const Instance& instance_, Scheduler& scheduler_,
         .subgroup_size = instance.SubgroupSize(),
         .support_explicit_workgroup_layout = true,
     };
-    auto [cache_result, cache] = instance.GetDevice().createPipelineCacheUnique({});
+    std::vector<u8> cache_data;
+    if (Config::shaderCache()) {
+        disk_cache = std::make_unique<ShaderDiskCache>(instance, profile);
+        disk_cache->Precompile(Config::shaderCachePrecompileThreads());
+        cache_data = disk_cache->LoadPipelineCacheData();
+    }
+    const vk::PipelineCacheCreateInfo cache_ci = {
+        .initialDataSize = cache_data.size(),
+        .pInitialData = cache_data.data(),
+    };
+    auto [cache_result, cache] = instance.GetDevice().createPipelineCacheUnique(cache_ci);
     ASSERT_MSG(cache_result == vk::Result::eSuccess, "Failed to create pipeline cache: {}",
                vk::to_string(cache_result));
     pipeline_cache = std::move(cache);
+
+    async_compile = Config::asyncShaderCompile();
+    u32 num_workers = Config::shaderCompileThreads();
+    if (num_workers == 0) {
+        num_workers = std::max(1U, std::thread::hardware_concurrency() / 2);
+    }
+    compile_workers = std::make_unique<Common::StatefulThreadWorker<Shader::Pools>>(
+        num_workers, "shadPS4:ShaderCompile", [] { return Shader::Pools{}; });
 }
 
-PipelineCache::~PipelineCache() = default;
+PipelineCache::~PipelineCache() {
+    if (disk_cache) {
+        disk_cache->StorePipelineCacheData(*pipeline_cache);
+    }
+}
 
 const GraphicsPipeline* PipelineCache::GetGraphicsPipeline() {
     const auto& regs = liverpool->regs;
@@ -317,7 +341,11 @@ bool PipelineCache::RefreshGraphicsKey() {
             return false;
         }
 
-        std::tie(infos[i], modules[i], key.stage_hashes[i]) = GetProgram(stage, params, binding);
+        const auto program = GetProgram(stage, params, binding, async_compile);
+        if (!program) {
+            return false;
+        }
+        std::tie(infos[i], modules[i], key.stage_hashes[i]) = *program;
     }
 
     const auto* vs_info = infos[static_cast<u32>(Shader::Stage::Vertex)];
@@ -370,25 +398,40 @@ bool PipelineCache::RefreshComputeKey() {
     if (ShouldSkipShader(cs_params.hash, "compute")) {
         return false;
     }
+    // Skipping a dispatch could leave data the following work depends on unwritten, so always
+    // wait for compute shaders.
     std::tie(infos[0], modules[0], compute_key) =
-        GetProgram(Shader::Stage::Compute, cs_params, binding);
+        *GetProgram(Shader::Stage::Compute, cs_params, binding, false);
     return true;
 }
 
-vk::ShaderModule PipelineCache::CompileModule(Shader::Info& info,
+vk::ShaderModule PipelineCache::CompileModule(Shader::Pools& pools, Shader::Info& info,
                                               const Shader::RuntimeInfo& runtime_info,
                                               std::span<const u32> code, size_t perm_idx,
                                               Shader::Backend::Bindings& binding) {
     LOG_INFO(Render_Vulkan, "Compiling {} shader {:#x} {}", info.stage, info.pgm_hash,
              perm_idx != 0 ? "(permutation)" : "");
     if (Config::dumpShaders()) {
-        DumpShader(code, info.pgm_hash, info.stage, perm_idx, "bin");
+        DumpShader(std::as_bytes(code), info.pgm_hash, info.stage, perm_idx, "bin");
     }
 
+    const auto start = binding;
     const auto ir_program = Shader::TranslateProgram(code, pools, info, runtime_info, profile);
+    LOG_DEBUG(Render_Vulkan, "Translation used {} of {} arena bytes", pools.arena.UsedBytes(),
+              pools.arena.ReservedBytes());
     const auto spv = Shader::Backend::SPIRV::EmitSPIRV(profile, runtime_info, ir_program, binding);
     if (Config::dumpShaders()) {
-        DumpShader(spv, info.pgm_hash, info.stage, perm_idx, "spv");
+        DumpShader(std::as_bytes(std::span{spv}), info.pgm_hash, info.stage, perm_idx, "spv");
+        // Inputs of the translation besides the code, for the offline shader tool.
+        const auto dump = Shader::ProgramDump::Capture(info, runtime_info, profile).Serialize();
+        DumpShader(std::as_bytes(std::span{dump}), info.pgm_hash, info.stage, perm_idx, "ctx");
+    }
+    if (disk_cache) {
+        if (perm_idx == 0) {
+            disk_cache->StoreInfo(info);
+        }
+        const auto spec = Shader::StageSpecialization(info, runtime_info, start);
+        disk_cache->StoreModule(info.pgm_hash, spec.Hash(), binding, spv);
     }
 
     const auto module = CompileSPV(spv, instance.GetDevice());
@@ -397,40 +440,136 @@ vk::ShaderModule PipelineCache::CompileModule(Shader::Info& info,
     return module;
 }
 
-std::tuple<const Shader::Info*, vk::ShaderModule, u64> PipelineCache::GetProgram(
-    Shader::Stage stage, Shader::ShaderParams params, Shader::Backend::Bindings& binding) {
+vk::ShaderModule PipelineCache::LoadCachedModule(Shader::Info& info,
+                                                 const Shader::RuntimeInfo& runtime_info,
+                                                 size_t perm_idx,
+                                                 Shader::Backend::Bindings& binding) {
+    if (!disk_cache) {
+        return {};
+    }
+    // The first permutation also needs the program info, which is otherwise produced by the
+    // translation we are trying to skip. Later permutations reuse the info of the program.
+    auto cached_info = info;
+    if (perm_idx == 0 && !disk_cache->LoadInfo(info.pgm_hash, cached_info)) {
+        return {};
+    }
+    const auto spec = Shader::StageSpecialization(cached_info, runtime_info, binding);
+    const auto module = disk_cache->LoadModule(info.pgm_hash, spec.Hash(), binding);
+    if (!module) {
+        return {};
+    }
+    LOG_INFO(Render_Vulkan, "Loaded {} shader {:#x} {}from disk cache", info.stage, info.pgm_hash,
+             perm_idx != 0 ? "(permutation) " : "");
+    if (perm_idx == 0) {
+        info = std::move(cached_info);
+    }
+    const auto name = fmt::format("{}_{:#x}_{}", info.stage, info.pgm_hash, perm_idx);
+    Vulkan::SetObjectName(instance.GetDevice(), module, name);
+    return module;
+}
+
+void PipelineCache::CompileJob(ProgramCompileJob& job, Shader::Pools& pools) {
+    job.module = LoadCachedModule(job.info, job.runtime_info, job.perm_idx, job.binding);
+    if (!job.module) {
+        const Shader::ShaderParams params = {job.user_data, job.code, job.info.pgm_hash};
+        if (job.perm_idx != 0) {
+            // Translate into a fresh info and keep the program info for the specialization.
+            auto new_info = Shader::Info(job.info.stage, params);
+            job.module = CompileModule(pools, new_info, job.runtime_info, job.code, job.perm_idx,
+                                       job.binding);
+        } else {
+            job.module = CompileModule(pools, job.info, job.runtime_info, job.code, 0, job.binding);
+        }
+    }
+    job.spec.emplace(job.info, job.runtime_info, job.start);
+    job.done = true;
+    job.done.notify_all();
+}
+
+ProgramCompileJob* PipelineCache::GetCompileJob(u64 job_key, const Program& program,
+                                                Shader::ShaderParams params,
+                                                const Shader::RuntimeInfo& runtime_info,
+                                                size_t perm_idx,
+                                                const Shader::Backend::Bindings& binding,
+                                                bool can_skip) {
+    auto [it, is_new] = compile_jobs.try_emplace(job_key);
+    if (is_new) {
+        auto job = std::make_unique<ProgramCompileJob>(program.info.stage, params, runtime_info,
+                                                       perm_idx, binding);
+        if (perm_idx != 0) {
+            job->info = program.info;
+            job->info.user_data = job->user_data;
+        }
+        compile_workers->QueueWork(
+            [this, job = job.get()](Shader::Pools* pools) { CompileJob(*job, *pools); });
+        it.value() = std::move(job);
+    }
+    ProgramCompileJob* job = it->second.get();
+    if (!job->done) {
+        if (can_skip) {
+            return nullptr;
+        }
+        job->done.wait(false);
+    }
+    return job;
+}
+
+std::optional<std::tuple<const Shader::Info*, vk::ShaderModule, u64>> PipelineCache::GetProgram(
+    Shader::Stage stage, Shader::ShaderParams params, Shader::Backend::Bindings& binding,
+    bool can_skip) {
     const auto runtime_info = BuildRuntimeInfo(stage);
     auto [it_pgm, new_program] = program_cache.try_emplace(params.hash);
     if (new_program) {
-        Program* program = program_pool.Create(stage, params);
-        auto start = binding;
-        const auto module = CompileModule(program->info, runtime_info, params.code, 0, binding);
-        const auto spec = Shader::StageSpecialization(program->info, runtime_info, start);
-        program->AddPermut(module, std::move(spec));
-        it_pgm.value() = program;
-        return std::make_tuple(&program->info, module, HashCombine(params.hash, 0));
+        it_pgm.value() = program_pool.Create(stage, params);
     }
-
     Program* program = it_pgm->second;
+
+    // A permutation compiled for the current state returns the bindings as advanced by the
+    // SPIR-V emitter, the same way a synchronous compilation would.
+    std::optional<Shader::Backend::Bindings> compiled_binding;
+    if (program->modules.empty()) {
+        // The first compilation of a program also produces its info.
+        auto* job = GetCompileJob(params.hash, *program, params, runtime_info, 0, binding,
+                                  can_skip);
+        if (!job) {
+            return std::nullopt;
+        }
+        program->info = std::move(job->info);
+        program->info.user_data = params.user_data;
+        program->AddPermut(job->module, std::move(*job->spec));
+        program->modules.back().spec.info = &program->info;
+        compiled_binding = job->binding;
+        compile_jobs.erase(params.hash);
+    }
+
     const auto& info = program->info;
     const auto spec = Shader::StageSpecialization(info, runtime_info, binding);
-    size_t perm_idx = program->modules.size();
-    vk::ShaderModule module{};
-
     const auto it = std::ranges::find(program->modules, spec, &Program::Module::spec);
-    if (it == program->modules.end()) {
-        auto new_info = Shader::Info(stage, params);
-        module = CompileModule(new_info, runtime_info, params.code, perm_idx, binding);
-        program->AddPermut(module, std::move(spec));
-    } else {
-        info.AddBindings(binding);
-        module = it->module;
-        perm_idx = std::distance(program->modules.begin(), it);
+    if (it != program->modules.end()) {
+        const size_t perm_idx = std::distance(program->modules.begin(), it);
+        if (perm_idx == 0 && compiled_binding) {
+            binding = *compiled_binding;
+        } else {
+            info.AddBindings(binding);
+        }
+        return std::make_tuple(&info, it->module, HashCombine(params.hash, perm_idx));
+    }
+
+    const size_t perm_idx = program->modules.size();
+    const u64 job_key = HashCombine(params.hash, spec.Hash());
+    auto* job =
+        GetCompileJob(job_key, *program, params, runtime_info, perm_idx, binding, can_skip);
+    if (!job) {
+        return std::nullopt;
     }
+    const auto module = job->module;
+    binding = job->binding;
+    program->AddPermut(module, std::move(spec));
+    compile_jobs.erase(job_key);
     return std::make_tuple(&info, module, HashCombine(params.hash, perm_idx));
 }
 
-void PipelineCache::DumpShader(std::span<const u32> code, u64 hash, Shader::Stage stage,
+void PipelineCache::DumpShader(std::span<const std::byte> data, u64 hash, Shader::Stage stage,
                                size_t perm_idx, std::string_view ext) {
     using namespace Common::FS;
     const auto dump_dir = GetUserPath(PathType::ShaderDir) / "dumps";
@@ -439,7 +578,7 @@ void PipelineCache::DumpShader(std::span<const u32> code, u64 hash, Shader::Stag
     }
     const auto filename = fmt::format("{}_{:#018x}_{}.{}", stage, hash, perm_idx, ext);
     const auto file = IOFile{dump_dir / filename, FileAccessMode::Write};
-    file.WriteSpan(code);
+    file.WriteSpan(data);
 }
 
 } // namespace Vulkan
@@ -3,13 +3,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <optional>
 #include <tsl/robin_map.h>
+#include "common/thread_worker.h"
 #include "shader_recompiler/profile.h"
 #include "shader_recompiler/recompiler.h"
 #include "shader_recompiler/specialization.h"
 #include "video_core/renderer_vulkan/vk_compute_pipeline.h"
 #include "video_core/renderer_vulkan/vk_graphics_pipeline.h"
 #include "video_core/renderer_vulkan/vk_resource_pool.h"
+#include "video_core/renderer_vulkan/vk_shader_disk_cache.h"
 
 namespace Shader {
 struct Info;
@@ -37,6 +42,31 @@ struct Program {
     }
 };
 
+/**
+ * A shader translation running on one of the compile workers. Everything the worker reads is
+ * owned by the job, as guest registers keep changing while the compilation is in flight.
+ */
+struct ProgramCompileJob {
+    std::array<u32, Shader::ShaderParams::NumShaderUserData> user_data;
+    Shader::Info info;
+    Shader::RuntimeInfo runtime_info;
+    std::span<const u32> code;
+    size_t perm_idx;
+    Shader::Backend::Bindings start;
+    Shader::Backend::Bindings binding;
+    std::optional<Shader::StageSpecialization> spec;
+    vk::ShaderModule module;
+    std::atomic_bool done{};
+
+    explicit ProgramCompileJob(Shader::Stage stage, const Shader::ShaderParams& params,
+                               const Shader::RuntimeInfo& runtime_info_, size_t perm_idx_,
+                               Shader::Backend::Bindings start_)
+        : info{stage, {user_data, params.code, params.hash}}, runtime_info{runtime_info_},
+          code{params.code}, perm_idx{perm_idx_}, start{start_}, binding{start_} {
+        std::ranges::copy(params.user_data, user_data.begin());
+    }
+};
+
 class PipelineCache {
     static constexpr size_t MaxShaderStages = 5;
 
@@ -49,18 +79,29 @@ public:
 
     const ComputePipeline* GetComputePipeline();
 
-    std::tuple<const Shader::Info*, vk::ShaderModule, u64> GetProgram(
-        Shader::Stage stage, Shader::ShaderParams params, Shader::Backend::Bindings& binding);
+    /// Returns the program permutation matching the current state or std::nullopt when it is
+    /// still being compiled and the caller is allowed to skip the work that needs it.
+    std::optional<std::tuple<const Shader::Info*, vk::ShaderModule, u64>> GetProgram(
+        Shader::Stage stage, Shader::ShaderParams params, Shader::Backend::Bindings& binding,
+        bool can_skip);
 
 private:
     bool RefreshGraphicsKey();
     bool RefreshComputeKey();
 
-    void DumpShader(std::span<const u32> code, u64 hash, Shader::Stage stage, size_t perm_idx,
-                    std::string_view ext);
-    vk::ShaderModule CompileModule(Shader::Info& info, const Shader::RuntimeInfo& runtime_info,
+    void DumpShader(std::span<const std::byte> data, u64 hash, Shader::Stage stage,
+                    size_t perm_idx, std::string_view ext);
+    ProgramCompileJob* GetCompileJob(u64 job_key, const Program& program,
+                                     Shader::ShaderParams params,
+                                     const Shader::RuntimeInfo& runtime_info, size_t perm_idx,
+                                     const Shader::Backend::Bindings& binding, bool can_skip);
+    void CompileJob(ProgramCompileJob& job, Shader::Pools& pools);
+    vk::ShaderModule CompileModule(Shader::Pools& pools, Shader::Info& info,
+                                   const Shader::RuntimeInfo& runtime_info,
                                    std::span<const u32> code, size_t perm_idx,
                                    Shader::Backend::Bindings& binding);
+    vk::ShaderModule LoadCachedModule(Shader::Info& info, const Shader::RuntimeInfo& runtime_info,
+                                      size_t perm_idx, Shader::Backend::Bindings& binding);
     Shader::RuntimeInfo BuildRuntimeInfo(Shader::Stage stage);
 
 private:
@@ -71,8 +112,9 @@ private:
     vk::UniquePipelineCache pipeline_cache;
     vk::UniquePipelineLayout pipeline_layout;
     Shader::Profile profile{};
-    Shader::Pools pools;
+    std::unique_ptr<ShaderDiskCache> disk_cache;
     tsl::robin_map<size_t, Program*> program_cache;
+    tsl::robin_map<u64, std::unique_ptr<ProgramCompileJob>> compile_jobs;
     Common::ObjectPool<Program> program_pool;
     Common::ObjectPool<GraphicsPipeline> graphics_pipeline_pool;
     Common::ObjectPool<ComputePipeline> compute_pipeline_pool;
@@ -82,6 +124,8 @@ private:
     std::array<vk::ShaderModule, MaxShaderStages> modules{};
     GraphicsPipelineKey graphics_key{};
     u64 compute_key{};
+    bool async_compile{};
+    std::unique_ptr<Common::StatefulThreadWorker<Shader::Pools>> compile_workers;
 };
 
 } // namespace Vulkan
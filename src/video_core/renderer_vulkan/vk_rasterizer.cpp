@@ -51,6 +51,10 @@ void Rasterizer::Draw(bool is_indexed, u32 index_offset) {
         return;
     }
 
+    // Quad lists are expanded with a compute dispatch, which must not disturb the push constants
+    // of the graphics pipeline.
+    const u32 num_indices = buffer_cache.BindIndexBuffer(is_indexed, index_offset);
+
     try {
         pipeline->BindResources(regs, buffer_cache, texture_cache);
     } catch (...) {
@@ -59,7 +63,6 @@ void Rasterizer::Draw(bool is_indexed, u32 index_offset) {
 
     const auto& vs_info = pipeline->GetStage(Shader::Stage::Vertex);
     buffer_cache.BindVertexBuffers(vs_info);
-    const u32 num_indices = buffer_cache.BindIndexBuffer(is_indexed, index_offset);
 
     BeginRendering(*pipeline);
     UpdateDynamicState(*pipeline);
@@ -91,6 +94,8 @@ void Rasterizer::DrawIndirect(bool is_indexed, VAddr address, u32 offset, u32 si
     ASSERT_MSG(regs.primitive_type != AmdGpu::Liverpool::PrimitiveType::RectList,
                "Unsupported primitive type for indirect draw");
 
+    const u32 num_indices = buffer_cache.BindIndexBuffer(is_indexed, 0);
+
     try {
         pipeline->BindResources(regs, buffer_cache, texture_cache);
     } catch (...) {
@@ -99,7 +104,6 @@ void Rasterizer::DrawIndirect(bool is_indexed, VAddr address, u32 offset, u32 si
 
     const auto& vs_info = pipeline->GetStage(Shader::Stage::Vertex);
     buffer_cache.BindVertexBuffers(vs_info);
-    const u32 num_indices = buffer_cache.BindIndexBuffer(is_indexed, 0);
 
     BeginRendering(*pipeline);
     UpdateDynamicState(*pipeline);
@@ -283,6 +287,17 @@ void Rasterizer::MapMemory(VAddr addr, u64 size) {
 
 void Rasterizer::UnmapMemory(VAddr addr, u64 size) {
     buffer_cache.InvalidateMemory(addr, size);
+    if (buffer_cache.UnmapMemory(addr, size)) {
+        // Buffers importing the memory must be released on the GPU thread once it is done with
+        // them, and before the host mapping goes away.
+        std::atomic_bool freed{};
+        liverpool->SendCommand([this, &freed] {
+            buffer_cache.FreeUnmappedBuffers();
+            freed.store(true, std::memory_order_release);
+            freed.notify_one();
+        });
+        freed.wait(false, std::memory_order_acquire);
+    }
     texture_cache.UnmapMemory(addr, size);
     page_manager.OnGpuUnmap(addr, size);
 }
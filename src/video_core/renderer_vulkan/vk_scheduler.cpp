@@ -89,6 +89,7 @@ void Scheduler::AllocateWorkerCommandBuffers() {
     };
 
     current_cmdbuf = command_pool.Commit();
+    bound_graphics_pipeline = nullptr;
     auto begin_result = current_cmdbuf.begin(begin_info);
     ASSERT_MSG(begin_result == vk::Result::eSuccess, "Failed to begin command buffer: {}",
                vk::to_string(begin_result));
@@ -13,6 +13,7 @@
 namespace Vulkan {
 
 class Instance;
+class GraphicsPipeline;
 
 struct RenderState {
     std::array<vk::RenderingAttachmentInfo, 8> color_attachments{};
@@ -83,6 +84,18 @@ public:
         return current_cmdbuf;
     }
 
+    /// Returns the graphics pipeline whose resources were bound last in the current command
+    /// buffer, the bound state of other pipelines is stale since binding a pipeline with a
+    /// different layout disturbs the descriptors.
+    [[nodiscard]] const GraphicsPipeline* BoundGraphicsPipeline() const noexcept {
+        return bound_graphics_pipeline;
+    }
+
+    /// Records the graphics pipeline whose resources were bound last.
+    void SetBoundGraphicsPipeline(const GraphicsPipeline* pipeline) noexcept {
+        bound_graphics_pipeline = pipeline;
+    }
+
     /// Returns the current command buffer tick.
     [[nodiscard]] u64 CurrentTick() const noexcept {
         return master_semaphore.CurrentTick();
@@ -123,6 +136,7 @@ private:
     std::queue<PendingOp> pending_ops;
     RenderState render_state;
     bool is_rendering = false;
+    const GraphicsPipeline* bound_graphics_pipeline{};
     tracy::VkCtxScope* profiler_scope{};
 };
 
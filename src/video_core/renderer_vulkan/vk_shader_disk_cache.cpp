@@ -0,0 +1,390 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <chrono>
+#include <cstring>
+#include <xxhash.h>
+
+#include "common/elf_info.h"
+#include "common/logging/log.h"
+#include "common/path_util.h"
+#include "common/scm_rev.h"
+#include "common/thread_worker.h"
+#include "shader_recompiler/info.h"
+#include "video_core/renderer_vulkan/vk_instance.h"
+#include "video_core/renderer_vulkan/vk_shader_disk_cache.h"
+#include "video_core/renderer_vulkan/vk_shader_util.h"
+
+namespace Vulkan {
+
+using Shader::Backend::Bindings;
+
+namespace {
+
+/// Bump whenever the layout of Shader::Info or of the file itself changes.
+constexpr u32 CacheVersion = 2;
+constexpr u32 CacheMagic = 0x48534353; // SCSH
+
+enum EntryType : u32 {
+    InfoEntry = 0,
+    ModuleEntry = 1,
+};
+
+struct FileHeader {
+    u32 magic;
+    u32 version;
+    u64 scm_rev_hash;
+    Shader::Profile profile;
+};
+
+struct EntryHeader {
+    u32 type;
+    u32 size;
+    u64 pgm_hash;
+    u64 spec_hash;
+};
+
+/// Mirrors VkPipelineCacheHeaderVersionOne
+struct PipelineCacheHeader {
+    u32 header_size;
+    u32 header_version;
+    u32 vendor_id;
+    u32 device_id;
+    std::array<u8, VK_UUID_SIZE> uuid;
+};
+
+class BinaryWriter {
+public:
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Data type must be trivially copyable.");
+        const auto* bytes = reinterpret_cast<const u8*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename Container>
+    void WriteList(const Container& list) {
+        Write<u32>(static_cast<u32>(list.size()));
+        for (const auto& elem : list) {
+            Write(elem);
+        }
+    }
+
+    std::vector<u8> data;
+};
+
+class BinaryReader {
+public:
+    explicit BinaryReader(std::span<const u8> data_) : data{data_} {}
+
+    template <typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Data type must be trivially copyable.");
+        if (offset + sizeof(T) > data.size()) {
+            return false;
+        }
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    template <typename Container>
+    bool ReadList(Container& list) {
+        u32 size{};
+        if (!Read(size) || size > list.max_size()) {
+            return false;
+        }
+        list.resize(size);
+        for (auto& elem : list) {
+            if (!Read(elem)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::span<const u8> data;
+    size_t offset{};
+};
+
+constexpr std::array InfoFlags = {
+    &Shader::Info::has_storage_images, &Shader::Info::has_image_buffers,
+    &Shader::Info::has_texel_buffers,  &Shader::Info::has_discard,
+    &Shader::Info::has_image_gather,   &Shader::Info::has_image_query,
+    &Shader::Info::uses_lane_id,       &Shader::Info::uses_group_quad,
+    &Shader::Info::uses_group_ballot,  &Shader::Info::uses_shared,
+    &Shader::Info::uses_fp16,          &Shader::Info::uses_fp64,
+    &Shader::Info::uses_step_rates,    &Shader::Info::translation_failed,
+};
+
+std::vector<u8> SerializeInfo(const Shader::Info& info) {
+    BinaryWriter writer;
+    writer.WriteList(info.vs_inputs);
+    writer.Write(info.loads);
+    writer.Write(info.stores);
+    writer.Write(info.ud_mask);
+    writer.Write(info.vertex_offset_sgpr);
+    writer.Write(info.instance_offset_sgpr);
+    writer.WriteList(info.buffers);
+    writer.WriteList(info.texture_buffers);
+    writer.WriteList(info.images);
+    writer.WriteList(info.samplers);
+    u32 flags{};
+    for (u32 i = 0; i < InfoFlags.size(); i++) {
+        flags |= u32(info.*InfoFlags[i]) << i;
+    }
+    writer.Write(flags);
+    writer.Write(info.mrt_mask);
+    writer.Write(info.fetch_shader_sgpr);
+    return std::move(writer.data);
+}
+
+bool DeserializeInfo(std::span<const u8> data, Shader::Info& info) {
+    BinaryReader reader{data};
+    u32 flags{};
+    const bool success =
+        reader.ReadList(info.vs_inputs) && reader.Read(info.loads) && reader.Read(info.stores) &&
+        reader.Read(info.ud_mask) && reader.Read(info.vertex_offset_sgpr) &&
+        reader.Read(info.instance_offset_sgpr) && reader.ReadList(info.buffers) &&
+        reader.ReadList(info.texture_buffers) && reader.ReadList(info.images) &&
+        reader.ReadList(info.samplers) && reader.Read(flags) && reader.Read(info.mrt_mask) &&
+        reader.Read(info.fetch_shader_sgpr);
+    if (!success) {
+        return false;
+    }
+    for (u32 i = 0; i < InfoFlags.size(); i++) {
+        info.*InfoFlags[i] = (flags >> i) & 1;
+    }
+    return true;
+}
+
+u64 ScmRevHash() {
+    return XXH3_64bits(Common::g_scm_rev, std::strlen(Common::g_scm_rev));
+}
+
+} // Anonymous namespace
+
+ShaderDiskCache::ShaderDiskCache(const Instance& instance_, const Shader::Profile& profile_)
+    : instance{instance_}, profile{profile_} {
+    const auto& game_info = Common::ElfInfo::Instance();
+    const auto serial = game_info.GameSerial();
+    if (serial.empty()) {
+        LOG_WARNING(Render_Vulkan, "Unknown title serial, shader disk cache is disabled");
+        return;
+    }
+    cache_dir = Common::FS::GetUserPath(Common::FS::PathType::ShaderDir) / "cache" / serial;
+    std::error_code ec;
+    std::filesystem::create_directories(cache_dir, ec);
+    if (ec) {
+        LOG_ERROR(Render_Vulkan, "Failed to create shader cache directory: {}", ec.message());
+        return;
+    }
+    Load();
+}
+
+ShaderDiskCache::~ShaderDiskCache() {
+    // Modules precompiled for permutations the title never requested are still owned here.
+    const vk::Device device = instance.GetDevice();
+    for (const auto& [key, cached] : modules) {
+        if (cached.module) {
+            device.destroyShaderModule(cached.module);
+        }
+    }
+}
+
+void ShaderDiskCache::Load() {
+    using namespace Common::FS;
+    const auto path = cache_dir / "shaders.bin";
+    const FileHeader expected_header = {
+        .magic = CacheMagic,
+        .version = CacheVersion,
+        .scm_rev_hash = ScmRevHash(),
+        .profile = profile,
+    };
+
+    u64 valid_size{};
+    if (std::filesystem::exists(path)) {
+        IOFile in{path, FileAccessMode::Read};
+        FileHeader header{};
+        if (in.ReadObject(header) && header.magic == expected_header.magic &&
+            header.version == expected_header.version &&
+            header.scm_rev_hash == expected_header.scm_rev_hash &&
+            header.profile == expected_header.profile) {
+            valid_size = sizeof(FileHeader);
+            EntryHeader entry{};
+            std::vector<u8> payload;
+            while (in.ReadObject(entry)) {
+                payload.resize(entry.size);
+                if (in.ReadSpan(std::span{payload}) != entry.size) {
+                    break;
+                }
+                if (entry.type == InfoEntry) {
+                    infos[entry.pgm_hash] = payload;
+                } else if (entry.type == ModuleEntry && entry.size > sizeof(Bindings) &&
+                           (entry.size - sizeof(Bindings)) % sizeof(u32) == 0) {
+                    auto& cached = modules[ModuleKey(entry.pgm_hash, entry.spec_hash)];
+                    std::memcpy(&cached.end_binding, payload.data(), sizeof(Bindings));
+                    cached.spirv.resize((entry.size - sizeof(Bindings)) / sizeof(u32));
+                    std::memcpy(cached.spirv.data(), payload.data() + sizeof(Bindings),
+                                entry.size - sizeof(Bindings));
+                }
+                valid_size += sizeof(EntryHeader) + entry.size;
+            }
+        } else {
+            LOG_INFO(Render_Vulkan, "Shader disk cache is outdated, discarding");
+        }
+    }
+
+    if (valid_size == 0) {
+        file.Open(path, FileAccessMode::Write);
+        file.WriteObject(expected_header);
+    } else {
+        // Drop any partially written entry at the end of the file before appending.
+        if (IOFile trim{path, FileAccessMode::ReadWrite}; trim.GetSize() != valid_size) {
+            LOG_WARNING(Render_Vulkan, "Discarding truncated shader disk cache entry");
+            trim.SetSize(valid_size);
+        }
+        file.Open(path, FileAccessMode::Append);
+    }
+    if (!file.IsOpen()) {
+        LOG_ERROR(Render_Vulkan, "Failed to open shader disk cache {}", fmt::UTF(path.u8string()));
+        return;
+    }
+    LOG_INFO(Render_Vulkan, "Loaded {} programs and {} shader permutations from disk cache",
+             infos.size(), modules.size());
+}
+
+void ShaderDiskCache::Precompile(u32 num_threads) {
+    if (modules.empty() || num_threads == 0) {
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    {
+        Common::ThreadWorker workers{num_threads, "shadPS4:ShaderPrecompile"};
+        const vk::Device device = instance.GetDevice();
+        // Each task only touches its own entry and the map is not modified until all tasks
+        // have finished.
+        for (auto it = modules.begin(); it != modules.end(); ++it) {
+            workers.QueueWork([device, &cached = it.value()] {
+                cached.module = CompileSPV(cached.spirv, device);
+                cached.spirv = {};
+            });
+        }
+        workers.WaitForRequests();
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    LOG_INFO(Render_Vulkan, "Precompiled {} shader modules on {} threads in {} ms",
+             modules.size(), num_threads, elapsed.count());
+}
+
+bool ShaderDiskCache::LoadInfo(u64 pgm_hash, Shader::Info& info) const {
+    std::scoped_lock lk{mutex};
+    const auto it = infos.find(pgm_hash);
+    if (it == infos.end()) {
+        return false;
+    }
+    if (!DeserializeInfo(it->second, info)) {
+        LOG_WARNING(Render_Vulkan, "Corrupted shader info for {:#x} in disk cache", pgm_hash);
+        return false;
+    }
+    return true;
+}
+
+void ShaderDiskCache::StoreInfo(const Shader::Info& info) {
+    if (!IsEnabled()) {
+        return;
+    }
+    {
+        std::scoped_lock lk{mutex};
+        if (infos.contains(info.pgm_hash)) {
+            return;
+        }
+    }
+    auto data = SerializeInfo(info);
+    Append(InfoEntry, info.pgm_hash, 0, data);
+    std::scoped_lock lk{mutex};
+    infos[info.pgm_hash] = std::move(data);
+}
+
+vk::ShaderModule ShaderDiskCache::LoadModule(u64 pgm_hash, u64 spec_hash, Bindings& binding) {
+    CachedModule cached;
+    {
+        std::scoped_lock lk{mutex};
+        const auto it = modules.find(ModuleKey(pgm_hash, spec_hash));
+        if (it == modules.end()) {
+            return {};
+        }
+        // The pipeline cache keeps its own copy of the module from now on.
+        cached = std::move(it.value());
+        modules.erase(it);
+    }
+    binding = cached.end_binding;
+    if (cached.module) {
+        return cached.module;
+    }
+    return CompileSPV(cached.spirv, instance.GetDevice());
+}
+
+void ShaderDiskCache::StoreModule(u64 pgm_hash, u64 spec_hash, const Bindings& end_binding,
+                                  std::span<const u32> spv) {
+    if (!IsEnabled()) {
+        return;
+    }
+    std::vector<u8> data(sizeof(Bindings) + spv.size_bytes());
+    std::memcpy(data.data(), &end_binding, sizeof(Bindings));
+    std::memcpy(data.data() + sizeof(Bindings), spv.data(), spv.size_bytes());
+    Append(ModuleEntry, pgm_hash, spec_hash, data);
+}
+
+void ShaderDiskCache::Append(u32 type, u64 pgm_hash, u64 spec_hash, std::span<const u8> payload) {
+    const EntryHeader entry = {
+        .type = type,
+        .size = static_cast<u32>(payload.size()),
+        .pgm_hash = pgm_hash,
+        .spec_hash = spec_hash,
+    };
+    std::scoped_lock lk{mutex};
+    file.WriteObject(entry);
+    file.WriteSpan(payload);
+    file.Flush();
+}
+
+std::vector<u8> ShaderDiskCache::LoadPipelineCacheData() const {
+    using namespace Common::FS;
+    const auto path = cache_dir / "pipelines.bin";
+    if (!IsEnabled() || !std::filesystem::exists(path)) {
+        return {};
+    }
+    const IOFile in{path, FileAccessMode::Read};
+    std::vector<u8> data(in.GetSize());
+    if (data.size() < sizeof(PipelineCacheHeader) || in.Read(data) != data.size()) {
+        return {};
+    }
+    // Some drivers do not validate the blob properly, so make sure it was produced by this device.
+    PipelineCacheHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    const auto uuid = instance.GetPipelineCacheUUID();
+    if (header.vendor_id != instance.GetVendorID() || header.device_id != instance.GetDeviceID() ||
+        std::memcmp(header.uuid.data(), uuid.data(), VK_UUID_SIZE) != 0) {
+        LOG_INFO(Render_Vulkan, "Pipeline disk cache was created by another device, discarding");
+        return {};
+    }
+    return data;
+}
+
+void ShaderDiskCache::StorePipelineCacheData(vk::PipelineCache pipeline_cache) const {
+    if (!IsEnabled()) {
+        return;
+    }
+    const auto [result, data] = instance.GetDevice().getPipelineCacheData(pipeline_cache);
+    if (result != vk::Result::eSuccess) {
+        LOG_ERROR(Render_Vulkan, "Failed to get pipeline cache data: {}", vk::to_string(result));
+        return;
+    }
+    const auto path = cache_dir / "pipelines.bin";
+    Common::FS::IOFile::WriteBytes(path, data);
+}
+
+} // namespace Vulkan
@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <vector>
+#include <tsl/robin_map.h>
+
+#include "common/io_file.h"
+#include "common/types.h"
+#include "shader_recompiler/backend/bindings.h"
+#include "shader_recompiler/profile.h"
+#include "video_core/renderer_vulkan/vk_common.h"
+
+namespace Shader {
+struct Info;
+}
+
+namespace Vulkan {
+
+class Instance;
+
+/**
+ * Persistent per-title storage of recompiled shaders and of the driver pipeline cache.
+ * Shader info is stored once per guest program hash, SPIR-V is stored per program and
+ * specialization hash. Entries are appended as new shaders get compiled and the whole
+ * cache is discarded when the emulator revision or the shader profile changes.
+ */
+class ShaderDiskCache {
+public:
+    explicit ShaderDiskCache(const Instance& instance, const Shader::Profile& profile);
+    ~ShaderDiskCache();
+
+    ShaderDiskCache(const ShaderDiskCache&) = delete;
+    ShaderDiskCache& operator=(const ShaderDiskCache&) = delete;
+
+    /// Returns true when the cache is backed by a file on disk.
+    [[nodiscard]] bool IsEnabled() const noexcept {
+        return file.IsOpen();
+    }
+
+    /// Creates shader modules for every stored SPIR-V entry using the provided number of threads.
+    void Precompile(u32 num_threads);
+
+    /// Fills the provided info with stored shader information. Returns false on a cache miss.
+    bool LoadInfo(u64 pgm_hash, Shader::Info& info) const;
+
+    /// Stores the information generated by the first translation of a program.
+    void StoreInfo(const Shader::Info& info);
+
+    /// Returns a shader module for the provided program permutation or a null handle on miss.
+    /// On a hit the bindings are advanced the same way SPIR-V emission advanced them.
+    vk::ShaderModule LoadModule(u64 pgm_hash, u64 spec_hash, Shader::Backend::Bindings& binding);
+
+    /// Stores the SPIR-V of a program permutation along with the bindings after its emission.
+    void StoreModule(u64 pgm_hash, u64 spec_hash, const Shader::Backend::Bindings& end_binding,
+                     std::span<const u32> spv);
+
+    /// Returns the serialized driver pipeline cache if it is compatible with the current device.
+    [[nodiscard]] std::vector<u8> LoadPipelineCacheData() const;
+
+    /// Serializes the driver pipeline cache to disk.
+    void StorePipelineCacheData(vk::PipelineCache pipeline_cache) const;
+
+private:
+    struct CachedModule {
+        Shader::Backend::Bindings end_binding;
+        std::vector<u32> spirv;
+        vk::ShaderModule module;
+    };
+
+    void Load();
+    void Append(u32 type, u64 pgm_hash, u64 spec_hash, std::span<const u8> payload);
+
+    static constexpr u64 ModuleKey(u64 pgm_hash, u64 spec_hash) noexcept {
+        return pgm_hash ^ (spec_hash + 0x9e3779b9 + (pgm_hash << 6) + (pgm_hash >> 2));
+    }
+
+private:
+    const Instance& instance;
+    Shader::Profile profile;
+    std::filesystem::path cache_dir;
+    Common::FS::IOFile file;
+    mutable std::mutex mutex;
+    tsl::robin_map<u64, std::vector<u8>> infos;
+    tsl::robin_map<u64, CachedModule> modules;
+};
+
+} // namespace Vulkan
@@ -7,6 +7,7 @@
 #include "video_core/renderer_vulkan/vk_instance.h"
 #include "video_core/renderer_vulkan/vk_scheduler.h"
 #include "video_core/texture_cache/image.h"
+#include "video_core/texture_cache/tile_manager.h"
 
 #include <vk_mem_alloc.h>
 
@@ -151,6 +152,7 @@ Image::Image(const Vulkan::Instance& instance_, Vulkan::Scheduler& scheduler_,
 
     usage = ImageUsageFlags(info);
     format_features = FormatFeatureFlags(usage);
+    cpu_detilable = CanDetileOnCpu(info);
 
     switch (info.pixel_format) {
     case vk::Format::eD16Unorm:
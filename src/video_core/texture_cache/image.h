@@ -115,6 +115,7 @@ struct Image {
     // Resource state tracking
     vk::ImageUsageFlags usage;
     vk::FormatFeatureFlags2 format_features;
+    bool cpu_detilable = false; ///< The layout can be converted by ConvertTileToLinear
     struct State {
         vk::Flags<vk::PipelineStageFlagBits2> pl_stage = vk::PipelineStageFlagBits2::eAllCommands;
         vk::Flags<vk::AccessFlagBits2> access_mask = vk::AccessFlagBits2::eNone;
@@ -124,6 +125,15 @@ struct Image {
     std::vector<State> subresource_states{};
     boost::container::small_vector<u64, 14> mip_hashes{};
     u64 tick_accessed_last{0};
+
+    // CPU write tracking. Pages written by the guest are unprotected individually, so the rest
+    // of the image stays tracked. The untracked range is page aligned and is protected again
+    // when the image is used, the dirty range spans the pages written since the last upload.
+    // An empty dirty range on a CPU dirty image means the whole image must be uploaded.
+    VAddr untracked_addr{0};
+    VAddr untracked_addr_end{0};
+    VAddr dirty_addr{0};
+    VAddr dirty_addr_end{0};
 };
 
 } // namespace VideoCore
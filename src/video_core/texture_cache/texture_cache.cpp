@@ -3,6 +3,7 @@
 
 #include <optional>
 #include <xxhash.h>
+#include "common/alignment.h"
 #include "common/assert.h"
 #include "video_core/buffer_cache/buffer_cache.h"
 #include "video_core/page_manager.h"
@@ -15,6 +16,7 @@
 namespace VideoCore {
 
 static constexpr u64 PageShift = 12;
+static constexpr u64 PageSize = 1ULL << PageShift;
 static constexpr u64 NumFramesBeforeRemoval = 32;
 
 TextureCache::TextureCache(const Vulkan::Instance& instance_, Vulkan::Scheduler& scheduler_,
@@ -41,15 +43,29 @@ TextureCache::TextureCache(const Vulkan::Instance& instance_, Vulkan::Scheduler&
     Vulkan::SetObjectName(instance.GetDevice(), null_image_view, "Null Image View");
 }
 
-TextureCache::~TextureCache() = default;
+TextureCache::~TextureCache() {
+    LOG_INFO(Render_Vulkan, "Image refreshes uploaded {} MiB, partial uploads skipped {} MiB",
+             bytes_uploaded >> 20, bytes_skipped >> 20);
+}
 
 void TextureCache::InvalidateMemory(VAddr address, size_t size) {
     std::scoped_lock lock{mutex};
     ForEachImageInRegion(address, size, [&](ImageId image_id, Image& image) {
+        const bool was_clean = False(image.flags & ImageFlagBits::Dirty);
+        const bool has_dirty_range = image.dirty_addr != image.dirty_addr_end;
+        // Untrack the written pages, so the range is unprotected and the guest can write freely.
+        UntrackImageRange(image_id, address, size);
+        // The rest of the image stays protected, so only the unprotected pages can be written
+        // until the next upload.
+        if (True(image.flags & ImageFlagBits::Tracked) && (was_clean || has_dirty_range)) {
+            image.dirty_addr = was_clean ? image.untracked_addr
+                                         : std::min(image.dirty_addr, image.untracked_addr);
+            image.dirty_addr_end = was_clean
+                                       ? image.untracked_addr_end
+                                       : std::max(image.dirty_addr_end, image.untracked_addr_end);
+        }
         // Ensure image is reuploaded when accessed again.
         image.flags |= ImageFlagBits::CpuDirty;
-        // Untrack image, so the range is unprotected and the guest can write freely.
-        UntrackImage(image_id);
     });
 }
 
@@ -379,13 +395,39 @@ void TextureCache::RefreshImage(Image& image, Vulkan::Scheduler* custom_schedule
     const auto& num_mips = image.info.resources.levels;
     ASSERT(num_mips == image.info.mips_layout.size());
 
+    // When only the CPU wrote to the image and the written range is known, skip the parts of
+    // the image that were left untouched. Linear and micro tiled 2D images are also narrowed
+    // down to the affected rows, other layouts are uploaded with mip granularity.
+    const bool is_partial = (image.flags & ImageFlagBits::Dirty) == ImageFlagBits::CpuDirty &&
+                            image.dirty_addr != image.dirty_addr_end;
+    const u64 dirty_begin =
+        is_partial ? std::max(image.dirty_addr, image.cpu_addr) - image.cpu_addr : 0;
+    const u64 dirty_end = is_partial
+                              ? std::min(image.dirty_addr_end, image.cpu_addr_end) - image.cpu_addr
+                              : image.info.guest_size_bytes;
+    const bool can_upload_rows =
+        is_partial && num_layers == 1 && !image.info.props.is_volume &&
+        !image.info.props.is_block &&
+        (image.info.tiling_mode == AmdGpu::TilingMode::Display_Linear ||
+         image.info.tiling_mode == AmdGpu::TilingMode::Texture_MicroTiled);
+    const u32 rows_per_tile =
+        image.info.tiling_mode == AmdGpu::TilingMode::Texture_MicroTiled ? 8u : 1u;
+
     boost::container::small_vector<vk::BufferImageCopy, 14> image_copy{};
+    u64 copy_begin = std::numeric_limits<u64>::max();
+    u64 copy_end = 0;
+    u64 upload_size = 0;
     for (u32 m = 0; m < num_mips; m++) {
         const u32 width = std::max(image.info.size.width >> m, 1u);
         const u32 height = std::max(image.info.size.height >> m, 1u);
         const u32 depth =
             image.info.props.is_volume ? std::max(image.info.size.depth >> m, 1u) : 1u;
         const auto& [mip_size, mip_pitch, mip_height, mip_ofs] = image.info.mips_layout[m];
+        const u64 mip_begin = mip_ofs * num_layers;
+        const u64 mip_end = mip_begin + mip_size * num_layers;
+        if (mip_end <= dirty_begin || dirty_end <= mip_begin) {
+            continue;
+        }
 
         // Protect GPU modified resources from accidental CPU reuploads.
         const bool is_gpu_modified = True(image.flags & ImageFlagBits::GpuModified);
@@ -399,8 +441,29 @@ void TextureCache::RefreshImage(Image& image, Vulkan::Scheduler* custom_schedule
             image.mip_hashes[m] = hash;
         }
 
+        u32 row_begin = 0;
+        u32 row_end = height;
+        if (can_upload_rows) {
+            const u64 tile_row_size = mip_pitch * rows_per_tile * image.info.num_bits / 8;
+            const u64 dirty_mip_begin = std::max(dirty_begin, mip_begin) - mip_begin;
+            const u64 dirty_mip_end = std::min(dirty_end, mip_end) - mip_begin;
+            row_begin = std::min<u64>(dirty_mip_begin / tile_row_size * rows_per_tile, height);
+            row_end = std::min<u64>(Common::DivCeil(dirty_mip_end, tile_row_size) * rows_per_tile,
+                                    height);
+            if (row_begin >= row_end) {
+                continue;
+            }
+        }
+        const u64 row_size = mip_pitch * image.info.num_bits / 8;
+        const u64 buffer_offset = mip_begin + row_begin * row_size;
+        const u64 buffer_size = can_upload_rows ? (row_end - row_begin) * row_size
+                                                : mip_size * num_layers;
+        copy_begin = std::min(copy_begin, buffer_offset);
+        copy_end = std::max(copy_end, buffer_offset + buffer_size);
+        upload_size += buffer_size;
+
         image_copy.push_back({
-            .bufferOffset = mip_ofs * num_layers,
+            .bufferOffset = buffer_offset,
             .bufferRowLength = static_cast<u32>(mip_pitch),
             .bufferImageHeight = static_cast<u32>(mip_height),
             .imageSubresource{
@@ -409,12 +472,17 @@ void TextureCache::RefreshImage(Image& image, Vulkan::Scheduler* custom_schedule
                 .baseArrayLayer = 0,
                 .layerCount = num_layers,
             },
-            .imageOffset = {0, 0, 0},
-            .imageExtent = {width, height, depth},
+            .imageOffset = {0, static_cast<s32>(row_begin), 0},
+            .imageExtent = {width, row_end - row_begin, depth},
         });
     }
 
+    bytes_uploaded += upload_size;
+    bytes_skipped += image.info.guest_size_bytes - upload_size;
+
     if (image_copy.empty()) {
+        image.flags &= ~ImageFlagBits::Dirty;
+        image.dirty_addr = image.dirty_addr_end = 0;
         return;
     }
 
@@ -425,8 +493,17 @@ void TextureCache::RefreshImage(Image& image, Vulkan::Scheduler* custom_schedule
     image.Transit(vk::ImageLayout::eTransferDstOptimal, vk::AccessFlagBits2::eTransferWrite, {},
                   cmdbuf);
 
-    const VAddr image_addr = image.info.guest_address;
-    const size_t image_size = image.info.guest_size_bytes;
+    // Tiled images are converted as a whole, linear ones only need the copied range.
+    if (image.info.props.is_tiled) {
+        copy_begin = 0;
+        copy_end = image.info.guest_size_bytes;
+    }
+    for (auto& copy : image_copy) {
+        copy.bufferOffset -= copy_begin;
+    }
+
+    const VAddr image_addr = image.info.guest_address + copy_begin;
+    const size_t image_size = copy_end - copy_begin;
     const auto [vk_buffer, buf_offset] = buffer_cache.ObtainTempBuffer(image_addr, image_size);
     // The obtained buffer may be written by a shader so we need to emit a barrier to prevent RAW
     // hazard
@@ -440,13 +517,18 @@ void TextureCache::RefreshImage(Image& image, Vulkan::Scheduler* custom_schedule
         cmdbuf.pipelineBarrier2(dependencies);
     }
 
-    const auto [buffer, offset] = tile_manager.TryDetile(vk_buffer->Handle(), buf_offset, image);
+    // Only layouts detiled on the CPU read guest memory, skip the tracker query for the rest.
+    const bool guest_data_valid =
+        image.cpu_detilable && !buffer_cache.IsRegionGpuModified(image_addr, image_size);
+    const auto [buffer, offset] =
+        tile_manager.TryDetile(vk_buffer->Handle(), buf_offset, image, guest_data_valid);
     for (auto& copy : image_copy) {
         copy.bufferOffset += offset;
     }
 
     cmdbuf.copyBufferToImage(buffer, image.image, vk::ImageLayout::eTransferDstOptimal, image_copy);
     image.flags &= ~ImageFlagBits::Dirty;
+    image.dirty_addr = image.dirty_addr_end = 0;
 }
 
 vk::Sampler TextureCache::GetSampler(const AmdGpu::Sampler& sampler) {
@@ -488,6 +570,12 @@ void TextureCache::UnregisterImage(ImageId image_id) {
 void TextureCache::TrackImage(ImageId image_id) {
     auto& image = slot_images[image_id];
     if (True(image.flags & ImageFlagBits::Tracked)) {
+        // Protect again the pages written since the image was last used.
+        if (image.untracked_addr != image.untracked_addr_end) {
+            tracker.UpdatePagesCachedCount(image.untracked_addr,
+                                           image.untracked_addr_end - image.untracked_addr, 1);
+            image.untracked_addr = image.untracked_addr_end = 0;
+        }
         return;
     }
     image.flags |= ImageFlagBits::Tracked;
@@ -500,7 +588,52 @@ void TextureCache::UntrackImage(ImageId image_id) {
         return;
     }
     image.flags &= ~ImageFlagBits::Tracked;
-    tracker.UpdatePagesCachedCount(image.cpu_addr, image.info.guest_size_bytes, -1);
+    if (image.untracked_addr == image.untracked_addr_end) {
+        tracker.UpdatePagesCachedCount(image.cpu_addr, image.info.guest_size_bytes, -1);
+    } else {
+        const VAddr image_addr = Common::AlignDown(image.cpu_addr, PageSize);
+        const VAddr image_addr_end = Common::AlignUp(image.cpu_addr_end, PageSize);
+        if (image_addr < image.untracked_addr) {
+            tracker.UpdatePagesCachedCount(image_addr, image.untracked_addr - image_addr, -1);
+        }
+        if (image.untracked_addr_end < image_addr_end) {
+            tracker.UpdatePagesCachedCount(image.untracked_addr_end,
+                                           image_addr_end - image.untracked_addr_end, -1);
+        }
+    }
+    image.untracked_addr = image.untracked_addr_end = 0;
+    // Writes are no longer noticed, the whole image has to be uploaded if it is dirty.
+    image.dirty_addr = image.dirty_addr_end = 0;
+}
+
+void TextureCache::UntrackImageRange(ImageId image_id, VAddr address, size_t size) {
+    auto& image = slot_images[image_id];
+    if (False(image.flags & ImageFlagBits::Tracked)) {
+        return;
+    }
+    const VAddr image_addr = Common::AlignDown(image.cpu_addr, PageSize);
+    const VAddr image_addr_end = Common::AlignUp(image.cpu_addr_end, PageSize);
+    VAddr range_addr = std::max(Common::AlignDown(address, PageSize), image_addr);
+    VAddr range_addr_end = std::min(Common::AlignUp(address + size, PageSize), image_addr_end);
+    if (range_addr >= range_addr_end) {
+        return;
+    }
+    if (image.untracked_addr == image.untracked_addr_end) {
+        tracker.UpdatePagesCachedCount(range_addr, range_addr_end - range_addr, -1);
+    } else {
+        // Keep a single untracked range, the pages in between are unprotected as well.
+        if (range_addr < image.untracked_addr) {
+            tracker.UpdatePagesCachedCount(range_addr, image.untracked_addr - range_addr, -1);
+        }
+        if (image.untracked_addr_end < range_addr_end) {
+            tracker.UpdatePagesCachedCount(image.untracked_addr_end,
+                                           range_addr_end - image.untracked_addr_end, -1);
+        }
+        range_addr = std::min(range_addr, image.untracked_addr);
+        range_addr_end = std::max(range_addr_end, image.untracked_addr_end);
+    }
+    image.untracked_addr = range_addr;
+    image.untracked_addr_end = range_addr_end;
 }
 
 void TextureCache::DeleteImage(ImageId image_id) {
@@ -199,6 +199,9 @@ private:
     /// Stop tracking CPU reads and writes for image
     void UntrackImage(ImageId image_id);
 
+    /// Stop tracking CPU reads and writes for the pages of image overlapping the range
+    void UntrackImageRange(ImageId image_id, VAddr address, size_t size);
+
     /// Removes the image and any views/surface metas that reference it.
     void DeleteImage(ImageId image_id);
 
@@ -219,6 +222,8 @@ private:
     tsl::robin_map<u64, Sampler> samplers;
     PageTable page_table;
     std::mutex mutex;
+    u64 bytes_uploaded{}; ///< Bytes uploaded by image refreshes since startup
+    u64 bytes_skipped{};  ///< Bytes of clean rows left out of partial uploads
 
     struct MetaDataInfo {
         enum class Type {
@@ -1,6 +1,8 @@
 // SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
 // SPDX-License-Identifier: GPL-2.0-or-later
 
+#include "common/arch.h"
+#include "common/config.h"
 #include "video_core/renderer_vulkan/vk_instance.h"
 #include "video_core/renderer_vulkan/vk_scheduler.h"
 #include "video_core/renderer_vulkan/vk_shader_util.h"
@@ -16,6 +18,10 @@
 #include <boost/container/static_vector.hpp>
 #include <magic_enum.hpp>
 #include <vk_mem_alloc.h>
+#ifdef ARCH_X86_64
+#include <immintrin.h>
+#include <xbyak/xbyak_util.h>
+#endif
 
 namespace VideoCore {
 
@@ -149,25 +155,101 @@ public:
     }
 };
 
+/**
+ * Per image lookup tables for the 32bpp macro tiled layout. The pipe and bank bits of a tiled
+ * address are XORs of independent x and y terms and the macro tile offset is a sum of a column
+ * and a row term, so the offset of any texel can be rebuilt from the offsets of (x, 0) and (0, y)
+ * as ((x_low ^ y_low) + x_high + y_high).
+ */
+struct MacroTileTables {
+    std::vector<u32> column_low;
+    std::vector<u32> column_high;
+    u32 low_mask;
+
+    MacroTileTables(const TileManager32& t, u32 width, bool is_neo)
+        : column_low(width), column_high(width) {
+        low_mask = (1U << (8 + t.m_pipe_bits + t.m_bank_bits)) - 1;
+        for (u32 x = 0; x < width; x++) {
+            const u32 offset = static_cast<u32>(t.getTiledOffs(x, 0, is_neo));
+            column_low[x] = offset & low_mask;
+            column_high[x] = offset & ~low_mask;
+        }
+    }
+};
+
+static void DetileRow(u32* dst, const u8* src, const MacroTileTables& tables, u32 row_offset,
+                      u32 begin, u32 width) {
+    const u32 row_low = row_offset & tables.low_mask;
+    const u32 row_high = row_offset & ~tables.low_mask;
+    for (u32 x = begin; x < width; x++) {
+        const u32 offset = (tables.column_low[x] ^ row_low) + tables.column_high[x] + row_high;
+        std::memcpy(dst + x, src + offset, sizeof(u32));
+    }
+}
+
+#ifdef ARCH_X86_64
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+TARGET_AVX2 static void DetileRowAvx2(u32* dst, const u8* src, const MacroTileTables& tables,
+                                      u32 row_offset, u32 width) {
+    const __m256i row_low = _mm256_set1_epi32(row_offset & tables.low_mask);
+    const __m256i row_high = _mm256_set1_epi32(row_offset & ~tables.low_mask);
+    const auto* column_low = reinterpret_cast<const __m256i*>(tables.column_low.data());
+    const auto* column_high = reinterpret_cast<const __m256i*>(tables.column_high.data());
+    u32 x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i low = _mm256_xor_si256(_mm256_loadu_si256(column_low + x / 8), row_low);
+        const __m256i high = _mm256_add_epi32(_mm256_loadu_si256(column_high + x / 8), row_high);
+        const __m256i offsets = _mm256_add_epi32(low, high);
+        const __m256i texels =
+            _mm256_i32gather_epi32(reinterpret_cast<const int*>(src), offsets, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), texels);
+    }
+    DetileRow(dst, src, tables, row_offset, x, width);
+}
+#endif
+
 void ConvertTileToLinear(u8* dst, const u8* src, u32 width, u32 height, bool is_neo) {
     TileManager32 t;
     t.Init(width, height, is_neo);
+    const MacroTileTables tables{t, width, is_neo};
 
-    for (u32 y = 0; y < height; y++) {
-        u32 x = 0;
-        u64 linear_offset = y * width * 4;
+#ifdef ARCH_X86_64
+    static const bool has_avx2 = Xbyak::util::Cpu{}.has(Xbyak::util::Cpu::tAVX2);
+#endif
 
-        for (; x + 1 < width; x += 2) {
-            auto tiled_offset = t.getTiledOffs(x, y, is_neo);
-
-            std::memcpy(dst + linear_offset, src + tiled_offset, sizeof(u64));
-            linear_offset += 8;
+    for (u32 y = 0; y < height; y++) {
+        u32* dst_row = reinterpret_cast<u32*>(dst) + static_cast<u64>(y) * width;
+        const u32 row_offset = static_cast<u32>(t.getTiledOffs(0, y, is_neo));
+#ifdef ARCH_X86_64
+        if (has_avx2) {
+            DetileRowAvx2(dst_row, src, tables, row_offset, width);
+            continue;
         }
-        if (x < width) {
-            auto tiled_offset = t.getTiledOffs(x, y, is_neo);
-            std::memcpy(dst + linear_offset, src + tiled_offset, sizeof(u32));
+#endif
+        DetileRow(dst_row, src, tables, row_offset, 0, width);
+    }
+#ifdef _DEBUG
+    // Cross-check both the table decomposition and the gathers against the address function.
+    for (u32 y = 0; y < height; y++) {
+        const u32* dst_row = reinterpret_cast<const u32*>(dst) + static_cast<u64>(y) * width;
+        for (u32 x = 0; x < width; x++) {
+            u32 texel;
+            std::memcpy(&texel, src + t.getTiledOffs(x, y, is_neo), sizeof(u32));
+            DEBUG_ASSERT_MSG(dst_row[x] == texel, "Detiled texel mismatch at ({}, {})", x, y);
         }
     }
+#endif
+}
+
+bool CanDetileOnCpu(const ImageInfo& info) {
+    return info.tiling_mode == AmdGpu::TilingMode::Display_MacroTiled && info.num_bits == 32 &&
+           !info.props.is_block && info.resources.levels == 1 && info.resources.layers == 1 &&
+           info.type == vk::ImageType::e2D && info.pitch % 128 == 0;
 }
 
 vk::Format DemoteImageFormatForDetiling(vk::Format format) {
@@ -339,9 +421,11 @@ TileManager::TileManager(const Vulkan::Instance& instance, Vulkan::Scheduler& sc
 TileManager::~TileManager() = default;
 
 TileManager::ScratchBuffer TileManager::AllocBuffer(u32 size, bool is_storage /*= false*/) {
-    const auto usage = vk::BufferUsageFlagBits::eStorageBuffer |
-                       (is_storage ? vk::BufferUsageFlagBits::eTransferSrc
-                                   : vk::BufferUsageFlagBits::eTransferDst);
+    // Upload buffers may also be copied from when the image was detiled on the CPU.
+    auto usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc;
+    if (!is_storage) {
+        usage |= vk::BufferUsageFlagBits::eTransferDst;
+    }
     const vk::BufferCreateInfo buffer_ci{
         .size = size,
         .usage = usage,
@@ -380,14 +464,34 @@ void TileManager::FreeBuffer(ScratchBuffer buffer) {
     vmaDestroyBuffer(instance.GetAllocator(), buffer.first, buffer.second);
 }
 
+std::pair<vk::Buffer, u32> TileManager::DetileOnCpu(const Image& image) {
+    const u32 width = image.info.pitch;
+    const u32 height = image.info.size.height;
+    const u32 linear_size = width * height * sizeof(u32);
+
+    const auto out_buffer = AllocBuffer(linear_size);
+    scheduler.DeferOperation([=, this]() { FreeBuffer(out_buffer); });
+
+    void* ptr{};
+    const auto result = vmaMapMemory(instance.GetAllocator(), out_buffer.second, &ptr);
+    ASSERT(result == VK_SUCCESS);
+    ConvertTileToLinear(static_cast<u8*>(ptr), std::bit_cast<const u8*>(image.info.guest_address),
+                        width, height, Config::isNeoMode());
+    vmaUnmapMemory(instance.GetAllocator(), out_buffer.second);
+    return {out_buffer.first, 0};
+}
+
 std::pair<vk::Buffer, u32> TileManager::TryDetile(vk::Buffer in_buffer, u32 in_offset,
-                                                  Image& image) {
+                                                  Image& image, bool guest_data_valid) {
     if (!image.info.props.is_tiled) {
         return {in_buffer, in_offset};
     }
 
     const auto* detiler = GetDetiler(image);
     if (!detiler) {
+        if (guest_data_valid && image.cpu_detilable) {
+            return DetileOnCpu(image);
+        }
         if (image.info.tiling_mode != AmdGpu::TilingMode::Texture_MacroTiled &&
             image.info.tiling_mode != AmdGpu::TilingMode::Display_MacroTiled) {
             LOG_ERROR(Render_Vulkan, "Unsupported tiled image: {} ({})",
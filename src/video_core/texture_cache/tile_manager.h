@@ -11,9 +11,12 @@ namespace VideoCore {
 
 class TextureCache;
 
-/// Converts tiled texture data to linear format.
+/// Converts 32bpp macro tiled texture data to linear format.
 void ConvertTileToLinear(u8* dst, const u8* src, u32 width, u32 height, bool neo);
 
+/// Returns true when the image layout can be converted to linear by ConvertTileToLinear.
+bool CanDetileOnCpu(const ImageInfo& info);
+
 /// Converts image format to the one used internally by detiler.
 vk::Format DemoteImageFormatForDetiling(vk::Format format);
 
@@ -39,7 +42,10 @@ public:
     TileManager(const Vulkan::Instance& instance, Vulkan::Scheduler& scheduler);
     ~TileManager();
 
-    std::pair<vk::Buffer, u32> TryDetile(vk::Buffer in_buffer, u32 in_offset, Image& image);
+    /// Returns a buffer holding the linear contents of the image. Layouts without a compute
+    /// detiler are converted on the CPU from guest memory when guest_data_valid is set.
+    std::pair<vk::Buffer, u32> TryDetile(vk::Buffer in_buffer, u32 in_offset, Image& image,
+                                         bool guest_data_valid);
 
     ScratchBuffer AllocBuffer(u32 size, bool is_storage = false);
     void Upload(ScratchBuffer buffer, const void* data, size_t size);
@@ -48,6 +54,8 @@ public:
 private:
     const DetilerContext* GetDetiler(const Image& image) const;
 
+    std::pair<vk::Buffer, u32> DetileOnCpu(const Image& image);
+
 private:
     const Vulkan::Instance& instance;
     Vulkan::Scheduler& scheduler;
@@ -0,0 +1,276 @@
+// SPDX-FileCopyrightText: Copyright 2024 shadPS4 Emulator Project
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Benchmarks the virtual memory area bookkeeping of the memory manager. A trace of map, unmap and
+// query operations is replayed with the carve, split and merge helpers the memory manager uses,
+// once over boost::container::flat_map and once over std::map. The trace is either generated,
+// with first fit placement over a fragmenting address space, or read from a file.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/container/flat_map.hpp>
+#include <fmt/core.h>
+
+#include "common/logging/backend.h"
+#include "common/types.h"
+#include "core/area_map.h"
+#include "core/memory.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Core::MemoryProt;
+using Core::VirtualMemoryArea;
+using Core::VMAType;
+
+constexpr VAddr SpaceBase = 0x10'0000'0000ULL;
+constexpr size_t SpaceSize = 0x100'0000'0000ULL;
+constexpr size_t PageSize = 16_KB;
+constexpr size_t InitialMapCapacity = 4096;
+
+struct Options {
+    u32 num_ops = 200000;
+    u32 queries_per_op = 4;
+    u32 max_live = 2048;
+    u64 seed = 1;
+    std::string trace_in;
+    std::string trace_out;
+};
+
+void PrintUsage(const char* program) {
+    fmt::print("Usage: {} [options]\n"
+               "  -n <ops>      Map and unmap operations to generate (default: 200000)\n"
+               "  -q <queries>  Lookups per operation (default: 4)\n"
+               "  -l <live>     Maximum number of live mappings (default: 2048)\n"
+               "  -s <seed>     Seed of the generated trace (default: 1)\n"
+               "  -i <file>     Replay a trace file instead of generating one\n"
+               "  -o <file>     Write the replayed trace to a file\n"
+               "Trace lines are 'm <addr> <size> <prot>', 'u <addr> <size>' or 'q <addr>', with\n"
+               "hexadecimal numbers.\n",
+               program);
+}
+
+std::optional<Options> ParseOptions(int argc, char* argv[]) {
+    Options options{};
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg{argv[i]};
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        if (arg == "-n") {
+            options.num_ops = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-q") {
+            options.queries_per_op = std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "-l") {
+            options.max_live = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "-s") {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-i") {
+            options.trace_in = argv[++i];
+        } else if (arg == "-o") {
+            options.trace_out = argv[++i];
+        } else {
+            return std::nullopt;
+        }
+    }
+    return options;
+}
+
+struct Op {
+    enum class Type : u8 { Map, Unmap, Query };
+
+    Type type;
+    VAddr addr;
+    size_t size;
+    MemoryProt prot;
+};
+
+template <typename Map>
+void InitSpace(Map& map) {
+    if constexpr (requires { map.reserve(InitialMapCapacity); }) {
+        map.reserve(InitialMapCapacity);
+    }
+    map.emplace(SpaceBase, VirtualMemoryArea{SpaceBase, SpaceSize});
+}
+
+/// Applies a map or unmap operation the way MapMemory and UnmapMemoryImpl change the areas.
+template <typename Map>
+void Apply(Map& map, const Op& op) {
+    auto it = Core::AreaMap::Carve(map, op.addr, op.size);
+    auto& vma = it->second;
+    if (op.type == Op::Type::Map) {
+        vma.type = VMAType::Flexible;
+        vma.prot = op.prot;
+    } else {
+        vma.type = VMAType::Free;
+        vma.prot = MemoryProt::NoAccess;
+    }
+    Core::AreaMap::MergeAdjacent(map, it);
+}
+
+/// Generates a trace by running it against a model of the address space. Mappings are placed
+/// first fit like SearchFree does, unmaps pick a random live mapping.
+std::vector<Op> GenerateTrace(const Options& options) {
+    std::mt19937_64 rng{options.seed};
+    std::map<VAddr, VirtualMemoryArea> model;
+    InitSpace(model);
+
+    std::vector<Op> trace;
+    std::vector<std::pair<VAddr, size_t>> live;
+    for (u32 i = 0; i < options.num_ops; i++) {
+        const bool map = live.empty() || (live.size() < options.max_live && rng() % 100 < 55);
+        Op op{};
+        if (map) {
+            const size_t size = PageSize << (rng() % 12);
+            auto it = model.begin();
+            while (!it->second.IsFree() || it->second.size < size) {
+                ++it;
+            }
+            op = {Op::Type::Map, it->second.base, size,
+                  rng() % 2 ? MemoryProt::CpuReadWrite : MemoryProt::CpuRead};
+            live.emplace_back(op.addr, size);
+        } else {
+            const size_t index = rng() % live.size();
+            op = {Op::Type::Unmap, live[index].first, live[index].second, MemoryProt::NoAccess};
+            live[index] = live.back();
+            live.pop_back();
+        }
+        Apply(model, op);
+        trace.push_back(op);
+        for (u32 q = 0; q < options.queries_per_op && !live.empty(); q++) {
+            const auto& [addr, size] = live[rng() % live.size()];
+            trace.push_back({Op::Type::Query, addr + rng() % size, 0, MemoryProt::NoAccess});
+        }
+    }
+    return trace;
+}
+
+std::optional<std::vector<Op>> ReadTrace(const std::string& path) {
+    std::ifstream file{path};
+    if (!file) {
+        return std::nullopt;
+    }
+    std::vector<Op> trace;
+    std::string type;
+    while (file >> type) {
+        Op op{};
+        u32 prot{};
+        file >> std::hex >> op.addr;
+        if (type == "m") {
+            op.type = Op::Type::Map;
+            file >> op.size >> prot;
+            op.prot = static_cast<MemoryProt>(prot);
+        } else if (type == "u") {
+            op.type = Op::Type::Unmap;
+            file >> op.size;
+        } else if (type == "q") {
+            op.type = Op::Type::Query;
+        } else {
+            return std::nullopt;
+        }
+        file >> std::dec;
+        if (!file) {
+            return std::nullopt;
+        }
+        trace.push_back(op);
+    }
+    return trace;
+}
+
+void WriteTrace(const std::string& path, const std::vector<Op>& trace) {
+    std::ofstream file{path};
+    for (const Op& op : trace) {
+        switch (op.type) {
+        case Op::Type::Map:
+            file << fmt::format("m {:x} {:x} {:x}\n", op.addr, op.size, u32(op.prot));
+            break;
+        case Op::Type::Unmap:
+            file << fmt::format("u {:x} {:x}\n", op.addr, op.size);
+            break;
+        case Op::Type::Query:
+            file << fmt::format("q {:x}\n", op.addr);
+            break;
+        }
+    }
+}
+
+struct Result {
+    double ms;
+    u64 checksum;
+    size_t num_areas;
+    size_t max_areas;
+};
+
+template <typename Map>
+Result Replay(const std::vector<Op>& trace) {
+    Map map;
+    InitSpace(map);
+    u64 checksum{};
+    size_t max_areas{};
+    const auto start = Clock::now();
+    for (const Op& op : trace) {
+        if (op.type == Op::Type::Query) {
+            const auto it = Core::AreaMap::Find(map, op.addr);
+            checksum += it->second.base ^ static_cast<u64>(it->second.prot);
+        } else {
+            Apply(map, op);
+            max_areas = std::max(max_areas, map.size());
+        }
+    }
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return {ms, checksum, map.size(), max_areas};
+}
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[]) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage(argv[0]);
+        return -1;
+    }
+
+    Common::Log::Initialize("vmem_bench.log");
+    Common::Log::Start();
+
+    std::vector<Op> trace;
+    if (!options->trace_in.empty()) {
+        auto read = ReadTrace(options->trace_in);
+        if (!read) {
+            fmt::print("Failed to read trace {}\n", options->trace_in);
+            Common::Log::Stop();
+            return -1;
+        }
+        trace = std::move(*read);
+    } else {
+        trace = GenerateTrace(*options);
+    }
+    if (!options->trace_out.empty()) {
+        WriteTrace(options->trace_out, trace);
+    }
+
+    const auto flat = Replay<boost::container::flat_map<VAddr, VirtualMemoryArea>>(trace);
+    const auto tree = Replay<std::map<VAddr, VirtualMemoryArea>>(trace);
+
+    fmt::print("{} operations, {} areas at the end, {} at most\n", trace.size(), flat.num_areas,
+               flat.max_areas);
+    fmt::print("{:<24}{:>10.2f} ms{:>10.1f} ns/op\n", "boost flat_map", flat.ms,
+               flat.ms * 1e6 / static_cast<double>(trace.size()));
+    fmt::print("{:<24}{:>10.2f} ms{:>10.1f} ns/op\n", "std::map", tree.ms,
+               tree.ms * 1e6 / static_cast<double>(trace.size()));
+
+    const bool same = flat.checksum == tree.checksum && flat.num_areas == tree.num_areas;
+    if (!same) {
+        fmt::print("The maps disagree on the replayed trace\n");
+    }
+    Common::Log::Stop();
+    return same ? 0 : 1;
+}